@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef ctrlplane_ip4_lpm_trie_h
+#define ctrlplane_ip4_lpm_trie_h
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "base/util.h"
+
+//
+// Read-optimized longest prefix match table for IPv4 addresses.
+//
+// The address is consumed 8 bits at a time, giving a trie of at most 4
+// levels. Each trie node covers 256 slots and is stored compressed, in the
+// style of poptrie:
+//  - child_bits has a bit set for every slot that has a child node. The
+//    children are stored compactly, in slot order, and a slot's child is
+//    found by counting the bits set before it.
+//  - leaf_bits has a bit set for every slot where the leaf value differs
+//    from the previous slot. Runs of equal leaf values are stored once.
+//  A leaf is the most specific prefix, rooted at this level, that covers the
+//  slot, or NULL if there is none.
+//
+// A lookup touches the bitmaps of one node per level, which share a cache
+// line, plus one leaf and one child pointer.
+//
+// Updates rebuild the leaves of a single node from the prefixes rooted at
+// it, so they cost O(256) regardless of the table size. The table does not
+// synchronize readers and writers; callers provide the same exclusion that
+// they need for the route tree it is kept alongside.
+//
+template <class D>
+class Ip4LPMTrie {
+public:
+    Ip4LPMTrie() : default_(NULL), root_(new Node), size_(0), nodes_(1) {
+        root_->RebuildLeaves();
+    }
+
+    ~Ip4LPMTrie() {
+        DeleteNode(root_);
+    }
+
+    // Returns false if the prefix is already present; its data is replaced.
+    bool Insert(uint32_t addr, int plen, D *data) {
+        assert(plen >= 0 && plen <= 32);
+        if (plen == 0) {
+            bool added = (default_ == NULL);
+            default_ = data;
+            if (added)
+                size_++;
+            return added;
+        }
+
+        Node *node = root_;
+        int level = (plen - 1) / kStride;
+        for (int i = 0; i < level; i++) {
+            int index = SlotIndex(addr, i);
+            Node *child = node->GetChild(index);
+            if (child == NULL) {
+                child = new Node;
+                child->RebuildLeaves();
+                node->AddChild(index, child);
+                nodes_++;
+            }
+            node = child;
+        }
+
+        int len = plen - level * kStride;
+        uint8_t bits = SlotIndex(addr, level) & Mask(len);
+        bool added = node->SetPrefix(bits, len, data);
+        node->RebuildLeaves();
+        if (added)
+            size_++;
+        return added;
+    }
+
+    // Returns false if the prefix is not present.
+    bool Remove(uint32_t addr, int plen) {
+        assert(plen >= 0 && plen <= 32);
+        if (plen == 0) {
+            if (default_ == NULL)
+                return false;
+            default_ = NULL;
+            size_--;
+            return true;
+        }
+
+        Node *path[kLevels];
+        int level = (plen - 1) / kStride;
+        path[0] = root_;
+        for (int i = 0; i < level; i++) {
+            path[i + 1] = path[i]->GetChild(SlotIndex(addr, i));
+            if (path[i + 1] == NULL)
+                return false;
+        }
+
+        int len = plen - level * kStride;
+        uint8_t bits = SlotIndex(addr, level) & Mask(len);
+        if (!path[level]->ClearPrefix(bits, len))
+            return false;
+        path[level]->RebuildLeaves();
+        size_--;
+
+        // Free the nodes that no longer hold prefixes or children.
+        for (int i = level; i > 0 && path[i]->empty(); i--) {
+            path[i - 1]->RemoveChild(SlotIndex(addr, i - 1));
+            delete path[i];
+            nodes_--;
+        }
+        return true;
+    }
+
+    D *LPMFind(uint32_t addr) const {
+        D *best = default_;
+        const Node *node = root_;
+        for (int level = 0; node != NULL; level++) {
+            int index = SlotIndex(addr, level);
+            D *leaf = node->leaves_[Rank(node->leaf_bits_, index) - 1];
+            if (leaf != NULL)
+                best = leaf;
+            if (!TestBit(node->child_bits_, index))
+                break;
+            node = node->children_[Rank(node->child_bits_, index) - 1];
+        }
+        return best;
+    }
+
+    size_t size() const { return size_; }
+    size_t node_count() const { return nodes_; }
+
+private:
+    static const int kStride = 8;
+    static const int kLevels = 32 / kStride;
+    static const int kSlots = 1 << kStride;
+    static const int kWords = kSlots / 64;
+
+    struct Prefix {
+        uint8_t bits;
+        uint8_t len;
+        D *data;
+    };
+
+    struct Node {
+        Node() : children_(NULL), leaves_(NULL) {
+            memset(child_bits_, 0, sizeof(child_bits_));
+            memset(leaf_bits_, 0, sizeof(leaf_bits_));
+        }
+        ~Node() {
+            delete [] children_;
+            delete [] leaves_;
+        }
+
+        bool empty() const {
+            return prefixes_.empty() && children_ == NULL;
+        }
+
+        Node *GetChild(int index) const {
+            if (!TestBit(child_bits_, index))
+                return NULL;
+            return children_[Rank(child_bits_, index) - 1];
+        }
+
+        void AddChild(int index, Node *child) {
+            int count = Rank(child_bits_, kSlots - 1);
+            int pos = Rank(child_bits_, index);
+            Node **children = new Node *[count + 1];
+            for (int i = 0; i < pos; i++)
+                children[i] = children_[i];
+            children[pos] = child;
+            for (int i = pos; i < count; i++)
+                children[i + 1] = children_[i];
+            delete [] children_;
+            children_ = children;
+            child_bits_[index / 64] |= (1ULL << (index % 64));
+        }
+
+        void RemoveChild(int index) {
+            int count = Rank(child_bits_, kSlots - 1);
+            int pos = Rank(child_bits_, index) - 1;
+            child_bits_[index / 64] &= ~(1ULL << (index % 64));
+            if (count == 1) {
+                delete [] children_;
+                children_ = NULL;
+                return;
+            }
+            Node **children = new Node *[count - 1];
+            for (int i = 0; i < pos; i++)
+                children[i] = children_[i];
+            for (int i = pos + 1; i < count; i++)
+                children[i - 1] = children_[i];
+            delete [] children_;
+            children_ = children;
+        }
+
+        bool SetPrefix(uint8_t bits, uint8_t len, D *data) {
+            for (size_t i = 0; i < prefixes_.size(); i++) {
+                if (prefixes_[i].bits == bits && prefixes_[i].len == len) {
+                    prefixes_[i].data = data;
+                    return false;
+                }
+            }
+            Prefix prefix = { bits, len, data };
+            prefixes_.push_back(prefix);
+            return true;
+        }
+
+        bool ClearPrefix(uint8_t bits, uint8_t len) {
+            for (size_t i = 0; i < prefixes_.size(); i++) {
+                if (prefixes_[i].bits == bits && prefixes_[i].len == len) {
+                    prefixes_[i] = prefixes_.back();
+                    prefixes_.pop_back();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Expand the prefixes into the 256 slots, shortest first so that
+        // more specific prefixes win, and compress the result into runs.
+        void RebuildLeaves() {
+            D *slots[kSlots];
+            memset(slots, 0, sizeof(slots));
+            for (int len = 1; len <= kStride; len++) {
+                for (size_t i = 0; i < prefixes_.size(); i++) {
+                    const Prefix &prefix = prefixes_[i];
+                    if (prefix.len != len)
+                        continue;
+                    int count = 1 << (kStride - len);
+                    for (int j = 0; j < count; j++)
+                        slots[prefix.bits + j] = prefix.data;
+                }
+            }
+
+            int runs = 1;
+            for (int i = 1; i < kSlots; i++) {
+                if (slots[i] != slots[i - 1])
+                    runs++;
+            }
+            D **leaves = new D *[runs];
+            memset(leaf_bits_, 0, sizeof(leaf_bits_));
+            int pos = 0;
+            for (int i = 0; i < kSlots; i++) {
+                if (i == 0 || slots[i] != slots[i - 1]) {
+                    leaf_bits_[i / 64] |= (1ULL << (i % 64));
+                    leaves[pos++] = slots[i];
+                }
+            }
+            delete [] leaves_;
+            leaves_ = leaves;
+        }
+
+        // Lookup state, kept together at the start of the node.
+        uint64_t child_bits_[kWords];
+        uint64_t leaf_bits_[kWords];
+        Node **children_;
+        D **leaves_;
+
+        // Prefixes rooted at this node. Only used by updates.
+        std::vector<Prefix> prefixes_;
+    };
+
+    static int SlotIndex(uint32_t addr, int level) {
+        return (addr >> (32 - kStride * (level + 1))) & (kSlots - 1);
+    }
+
+    // Mask of the first len bits of a slot index.
+    static uint8_t Mask(int len) {
+        return static_cast<uint8_t>(0xFF << (kStride - len));
+    }
+
+    static bool TestBit(const uint64_t *bits, int index) {
+        return (bits[index / 64] & (1ULL << (index % 64))) != 0;
+    }
+
+    // Number of bits set at or before index.
+    static int Rank(const uint64_t *bits, int index) {
+        int word = index / 64;
+        int count = 0;
+        for (int i = 0; i < word; i++)
+            count += __builtin_popcountll(bits[i]);
+        uint64_t mask = (2ULL << (index % 64)) - 1;
+        return count + __builtin_popcountll(bits[word] & mask);
+    }
+
+    void DeleteNode(Node *node) {
+        int count = Rank(node->child_bits_, kSlots - 1);
+        for (int i = 0; i < count; i++)
+            DeleteNode(node->children_[i]);
+        delete node;
+    }
+
+    D *default_;
+    Node *root_;
+    size_t size_;
+    size_t nodes_;
+
+    DISALLOW_COPY_AND_ASSIGN(Ip4LPMTrie);
+};
+
+#endif
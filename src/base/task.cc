@@ -8,6 +8,7 @@
 #include <iostream>
 #include <boost/intrusive/set.hpp>
 
+#include "tbb/concurrent_queue.h"
 #include "tbb/task.h"
 #include "tbb/enumerable_thread_specific.h"
 #include "base/logging.h"
@@ -202,6 +203,70 @@ private:
     DISALLOW_COPY_AND_ASSIGN(TaskGroup);
 };
 
+// Per-core queue of scheduler operations posted while the scheduler mutex_
+// was held by another thread. Each thread always posts to the same shard,
+// which keeps the operations of a thread in FIFO order.
+class TaskOpShard {
+public:
+    struct Op {
+        Op() : type(0), task(NULL) { }
+        Op(int type, Task *task) : type(type), task(task) { }
+        int type;
+        Task *task;
+    };
+
+    TaskOpShard() { pending_ = 0; }
+
+    // The pending count is bumped before the push, so that it is never less
+    // than the number of operations in the queue.
+    void Push(int type, Task *task) {
+        pending_++;
+        queue_.push(Op(type, task));
+    }
+    bool Pop(Op *op) {
+        if (!queue_.try_pop(*op))
+            return false;
+        pending_--;
+        return true;
+    }
+    int pending() const { return pending_; }
+
+private:
+    tbb::concurrent_queue<Op> queue_;
+    tbb::atomic<int> pending_;
+
+    DISALLOW_COPY_AND_ASSIGN(TaskOpShard);
+};
+
+// Holds the scheduler mutex_. Operations posted to the shards are applied
+// when the lock is acquired, so that the caller observes them, and again
+// before it is released. Posted operations that raced with the release are
+// picked up by DrainOps once the lock is dropped.
+//
+// Each drain of a shard is bounded by the number of operations pending in
+// the shard when the drain starts, so that a thread releasing the lock does
+// not keep applying operations that other threads post meanwhile. The bound
+// still covers every operation that was posted before the drain started, so
+// the lock holder always observes the operations its own thread posted.
+class TaskScheduler::ScopedLock {
+public:
+    explicit ScopedLock(TaskScheduler *scheduler)
+        : scheduler_(scheduler), lock_(scheduler->mutex_) {
+        scheduler_->DrainOpsUnLocked();
+    }
+    ~ScopedLock() {
+        scheduler_->DrainOpsUnLocked();
+        lock_.release();
+        scheduler_->DrainOps();
+    }
+
+private:
+    TaskScheduler *scheduler_;
+    tbb::mutex::scoped_lock lock_;
+
+    DISALLOW_COPY_AND_ASSIGN(ScopedLock);
+};
+
 ////////////////////////////////////////////////////////////////////////////
 // Implementation for class TaskImpl 
 ////////////////////////////////////////////////////////////////////////////
@@ -276,10 +341,22 @@ int TaskScheduler::GetThreadCount() {
 // part of tbb. So, initialize TBB with one thread more than its default
 TaskScheduler::TaskScheduler() : 
     task_scheduler_(GetThreadCount() + 1),
-    running_(true), seqno_(0), id_max_(0) {
+    running_(true), seqno_(0), sharded_run_queue_(false),
+    op_shard_index_(-1), id_max_(0) {
     hw_thread_count_ = GetThreadCount();
     task_group_db_.resize(TaskScheduler::kVectorGrowSize);
     stop_entry_ = new TaskEntry(-1);
+
+    op_shard_next_ = 0;
+    drain_scheduled_ = 0;
+    for (int i = 0; i <= hw_thread_count_; i++) {
+        op_shards_.push_back(new TaskOpShard());
+    }
+
+    char *sharded_str = getenv("TASK_SHARDED_RUN_QUEUE");
+    if (sharded_str && strtol(sharded_str, NULL, 0) != 0) {
+        sharded_run_queue_ = true;
+    }
 }
 
 // Free up the task_entry_db_ allocated for scheduler
@@ -303,6 +380,12 @@ TaskScheduler::~TaskScheduler() {
     stop_entry_ = NULL;
     task_group_db_.clear();
 
+    for (TaskOpShardList::iterator iter = op_shards_.begin();
+         iter != op_shards_.end(); ++iter) {
+        delete *iter;
+    }
+    op_shards_.clear();
+
     return;
 }
 
@@ -362,7 +445,7 @@ TaskEntry *TaskScheduler::QueryTaskEntry(int task_id, int task_instance) {
 //      task_db_[tid1] : Rule <tid0, -1> is added to policyq
 //      task_group_db_[tid2, inst2] : Rule <tid0, inst2> is added to policyq
 void TaskScheduler::SetPolicy(int task_id, TaskPolicy &policy) {
-    tbb::mutex::scoped_lock     lock(mutex_);
+    ScopedLock lock(this);
 
     TaskGroup *group = GetTaskGroup(task_id);
     TaskEntry *group_entry = group->GetTaskEntry(-1);
@@ -390,8 +473,12 @@ void TaskScheduler::SetPolicy(int task_id, TaskPolicy &policy) {
 // Enqueue a Task for running. Starts task if all policy rules are met else 
 // puts task in waitq
 void TaskScheduler::Enqueue(Task *t) {
-    tbb::mutex::scoped_lock     lock(mutex_);
+    if (sharded_run_queue_) {
+        PostOp(OP_ENQUEUE, t);
+        return;
+    }
 
+    ScopedLock lock(this);
     EnqueueUnLocked(t);
 }
 
@@ -436,7 +523,7 @@ void TaskScheduler::EnqueueUnLocked(Task *t) {
 // Cancel a Task that can be in RUN/WAIT state.
 // [Note]: The caller needs to ensure that the task exists when Cancel() is invoked. 
 TaskScheduler::CancelReturnCode TaskScheduler::Cancel(Task *t) {
-    tbb::mutex::scoped_lock  lock(mutex_);
+    ScopedLock lock(this);
 
     // If the task is in RUN state, mark the task for cancellation and return.
     if (t->state_ == Task::RUN) {
@@ -486,8 +573,16 @@ TaskScheduler::CancelReturnCode TaskScheduler::Cancel(Task *t) {
 // Method invoked on exit of a Task.
 // Exit of a task can potentially start tasks in pendingq.
 void TaskScheduler::OnTaskExit(Task *t) {
-    tbb::mutex::scoped_lock lock(mutex_);
+    if (sharded_run_queue_) {
+        PostOp(OP_EXIT, t);
+        return;
+    }
+
+    ScopedLock lock(this);
+    OnTaskExitUnLocked(t);
+}
 
+void TaskScheduler::OnTaskExitUnLocked(Task *t) {
     TaskEntry *entry = QueryTaskEntry(t->GetTaskId(), t->GetTaskInstance());
     entry->TaskExited(t, GetTaskGroup(t->GetTaskId()));
 
@@ -510,13 +605,13 @@ void TaskScheduler::OnTaskExit(Task *t) {
 }
 
 void TaskScheduler::Stop() {
-    tbb::mutex::scoped_lock             lock(mutex_);
+    ScopedLock lock(this);
 
     running_ = false;
 }
 
 void TaskScheduler::Start() {
-    tbb::mutex::scoped_lock             lock(mutex_);
+    ScopedLock lock(this);
 
     running_ = true;
 
@@ -525,6 +620,114 @@ void TaskScheduler::Start() {
     return;
 }
 
+void TaskScheduler::SetShardedRunQueue(bool enable) {
+    ScopedLock lock(this);
+    sharded_run_queue_ = enable;
+}
+
+// Each thread is bound to one shard on its first post. Threads are spread
+// round-robin across the shards.
+TaskOpShard *TaskScheduler::LocalOpShard() {
+    TaskOpShardIndex::reference index = op_shard_index_.local();
+    if (index < 0) {
+        index = op_shard_next_.fetch_and_increment() % op_shards_.size();
+    }
+    return op_shards_[index];
+}
+
+// Apply the operation right away if the scheduler mutex_ is free. Otherwise
+// post it to the shard of the current thread; the owner of mutex_ applies it
+// before releasing the lock.
+void TaskScheduler::PostOp(OpType type, Task *t) {
+    tbb::mutex::scoped_lock lock;
+    if (lock.try_acquire(mutex_)) {
+        DrainOpsUnLocked();
+        ApplyOp(type, t);
+        DrainOpsUnLocked();
+        lock.release();
+        DrainOps();
+        return;
+    }
+
+    LocalOpShard()->Push(type, t);
+    DrainOps();
+}
+
+void TaskScheduler::ApplyOp(OpType type, Task *t) {
+    switch (type) {
+    case OP_ENQUEUE:
+        EnqueueUnLocked(t);
+        break;
+    case OP_EXIT:
+        OnTaskExitUnLocked(t);
+        break;
+    }
+}
+
+// Continues a drain that was cut short by its bound.
+class TaskScheduler::DrainTask : public tbb::task {
+public:
+    explicit DrainTask(TaskScheduler *scheduler) : scheduler_(scheduler) { }
+
+    tbb::task *execute() {
+        scheduler_->drain_scheduled_ = 0;
+        scheduler_->DrainOps();
+        return NULL;
+    }
+
+private:
+    TaskScheduler *scheduler_;
+};
+
+// Drain posted operations if the mutex_ can be acquired without waiting. If
+// the mutex_ is busy, its owner is guaranteed to see the operations since
+// they were posted before it released the lock. Operations posted during the
+// drain are left to a DrainTask rather than applied by this thread.
+void TaskScheduler::DrainOps() {
+    if (!OpsPending())
+        return;
+    {
+        tbb::mutex::scoped_lock lock;
+        if (!lock.try_acquire(mutex_))
+            return;
+        DrainOpsUnLocked();
+    }
+    if (OpsPending() && drain_scheduled_.compare_and_swap(1, 0) == 0) {
+        tbb::task::spawn(*new (tbb::task::allocate_root()) DrainTask(this));
+    }
+}
+
+bool TaskScheduler::OpsPending() const {
+    for (TaskOpShardList::const_iterator iter = op_shards_.begin();
+         iter != op_shards_.end(); ++iter) {
+        if ((*iter)->pending() > 0)
+            return true;
+    }
+    return false;
+}
+
+//
+// Apply at most the operations pending in each shard on entry.
+//
+// Operations of a shard are popped in FIFO order and each of them was counted
+// before it was pushed. The operations queued ahead of any operation posted
+// before the drain started are therefore all within the bound, and so is the
+// operation itself. A pop can fail before the bound is reached if a producer
+// has counted its operation but not pushed it yet; the producer then calls
+// DrainOps itself.
+void TaskScheduler::DrainOpsUnLocked() {
+    for (TaskOpShardList::iterator iter = op_shards_.begin();
+         iter != op_shards_.end(); ++iter) {
+        TaskOpShard *shard = *iter;
+        int count = shard->pending();
+        TaskOpShard::Op op;
+        while (count > 0 && shard->Pop(&op)) {
+            count--;
+            ApplyOp(static_cast<OpType>(op.type), op.task);
+        }
+    }
+}
+
 void TaskScheduler::Print() {
     for (TaskGroupDb::iterator iter = task_group_db_.begin();
          iter != task_group_db_.end(); ++iter) {
@@ -543,7 +746,7 @@ void TaskScheduler::Print() {
 bool TaskScheduler::IsEmpty() {
     TaskGroup *group;
 
-    tbb::mutex::scoped_lock lock(mutex_);
+    ScopedLock lock(this);
 
     for (TaskGroupDb::iterator it = task_group_db_.begin();
          it != task_group_db_.end(); ++it) {
@@ -34,6 +34,8 @@
 #include <boost/scoped_ptr.hpp>
 #include <map>
 #include <vector>
+#include <tbb/atomic.h>
+#include <tbb/enumerable_thread_specific.h>
 #include <tbb/mutex.h>
 #include <tbb/reader_writer_lock.h>
 #include <tbb/task.h>
@@ -42,6 +44,7 @@
 
 class TaskGroup;
 class TaskEntry;
+class TaskOpShard;
 
 struct TaskStats {
     int     wait_count_;
@@ -123,6 +126,14 @@ private:
 // which may now be runnable. It is important that this process is efficient
 // such that exit events do not scan tasks that are not waiting on a particular
 // task id or task instance to have a 0 count.
+//
+// By default every Enqueue and task exit serializes on the scheduler mutex_.
+// With the sharded run queue enabled, Enqueue and OnTaskExit only take the
+// mutex_ if it is free. Otherwise the operation is posted to a lock-free
+// per-core shard and the thread returns immediately. The thread owning the
+// mutex_ applies all posted operations, in per-thread FIFO order, before it
+// releases the lock. Sequence numbers are assigned when the operation is
+// applied, so the TaskPolicy and deferq_ ordering rules are unchanged.
 class TaskScheduler {
 public:
     TaskScheduler();
@@ -147,6 +158,11 @@ public:
     // Set the task exclusion policy.
     void SetPolicy(int task_id, TaskPolicy &policy);
 
+    // Enable or disable the sharded run queue. Expected to be set before
+    // tasks are enqueued. Can also be enabled with TASK_SHARDED_RUN_QUEUE=1.
+    void SetShardedRunQueue(bool enable);
+    bool sharded_run_queue() const { return sharded_run_queue_; }
+
     bool GetRunStatus() { return running_; };
     int GetTaskId(const std::string &name);
 
@@ -177,8 +193,17 @@ public:
 
 private:
     friend class ConcurrencyScope;
+    class DrainTask;
+    class ScopedLock;
     typedef std::vector<TaskGroup *> TaskGroupDb;
     typedef std::map<std::string, int> TaskIdMap;
+    typedef std::vector<TaskOpShard *> TaskOpShardList;
+    typedef tbb::enumerable_thread_specific<int> TaskOpShardIndex;
+
+    enum OpType {
+        OP_ENQUEUE,
+        OP_EXIT
+    };
 
     static const int        kVectorGrowSize = 16;
     static boost::scoped_ptr<TaskScheduler> singleton_;
@@ -191,6 +216,14 @@ private:
     void ClearRunningTask();
     void WaitForTerminateCompletion();
 
+    void OnTaskExitUnLocked(Task *task);
+    void PostOp(OpType type, Task *task);
+    void ApplyOp(OpType type, Task *task);
+    void DrainOps();
+    void DrainOpsUnLocked();
+    bool OpsPending() const;
+    TaskOpShard *LocalOpShard();
+
     TaskEntry               *stop_entry_;
 
     tbb::task_scheduler_init task_scheduler_;
@@ -199,6 +232,13 @@ private:
     int                     seqno_;
     TaskGroupDb             task_group_db_;
 
+    bool                    sharded_run_queue_;
+    TaskOpShardList         op_shards_;
+    TaskOpShardIndex        op_shard_index_;
+    tbb::atomic<int>        op_shard_next_;
+    // Set while a DrainTask is spawned
+    tbb::atomic<int>        drain_scheduled_;
+
     tbb::reader_writer_lock id_map_mutex_;
     TaskIdMap               id_map_;
     int                     id_max_;
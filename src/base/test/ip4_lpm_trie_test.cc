@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <stdlib.h>
+#include <iostream>
+#include <vector>
+
+#include "base/ip4_lpm_trie.h"
+#include "base/logging.h"
+#include "base/patricia.h"
+#include "base/util.h"
+#include "testing/gunit.h"
+
+using namespace std;
+
+class Route {
+public:
+    Route(uint32_t addr = 0, int len = 0) : addr_(addr), len_(len) {
+    }
+
+    class RtKey {
+    public:
+        static std::size_t Length(Route *route) {
+            return route->len_;
+        }
+        static char ByteValue(Route *route, std::size_t i) {
+            return static_cast<char>(route->addr_ >> (24 - (i << 3)));
+        }
+    };
+
+    uint32_t addr_;
+    int len_;
+    Patricia::Node rtnode_;
+};
+
+typedef Patricia::Tree<Route, &Route::rtnode_, Route::RtKey> RouteTree;
+typedef Ip4LPMTrie<Route> RouteTrie;
+
+static uint32_t MaskAddr(uint32_t addr, int len) {
+    if (len == 0)
+        return 0;
+    return addr & (~0U << (32 - len));
+}
+
+//
+// Environment variables for the benchmark:
+//     LPM_BENCH_ROUTES  - number of routes in the table (default 100000)
+//     LPM_BENCH_LOOKUPS - number of lookups (default 2000000)
+//
+class Ip4LPMTrieTest : public ::testing::Test {
+protected:
+    Ip4LPMTrieTest() {
+        route_count_ = 100000;
+        char *str = getenv("LPM_BENCH_ROUTES");
+        if (str) route_count_ = strtoul(str, NULL, 0);
+        lookup_count_ = 2000000;
+        str = getenv("LPM_BENCH_LOOKUPS");
+        if (str) lookup_count_ = strtoul(str, NULL, 0);
+        srand(0x1234);
+    }
+
+    virtual void TearDown() {
+        STLDeleteValues(&routes_);
+    }
+
+    static uint32_t RandomAddr() {
+        return (static_cast<uint32_t>(rand()) << 16) ^ rand();
+    }
+
+    // Mix of prefix lengths resembling a VRF with host routes, subnets and
+    // a few aggregates.
+    static int RandomLen() {
+        int value = rand() % 100;
+        if (value < 60) return 32;
+        if (value < 85) return 24;
+        if (value < 95) return 16 + rand() % 8;
+        return 1 + rand() % 15;
+    }
+
+    void AddRoute(uint32_t addr, int len) {
+        Route *route = new Route(MaskAddr(addr, len), len);
+        if (!tree_.Insert(route)) {
+            delete route;
+            return;
+        }
+        EXPECT_TRUE(trie_.Insert(route->addr_, len, route));
+        routes_.push_back(route);
+    }
+
+    void RemoveRoute(size_t index) {
+        Route *route = routes_[index];
+        EXPECT_TRUE(tree_.Remove(route));
+        EXPECT_TRUE(trie_.Remove(route->addr_, route->len_));
+        routes_[index] = routes_.back();
+        routes_.pop_back();
+        delete route;
+    }
+
+    Route *TreeLPM(uint32_t addr) {
+        Route key(addr, 32);
+        return tree_.LPMFind(&key);
+    }
+
+    void VerifyLookups(int count) {
+        for (int i = 0; i < count; i++) {
+            uint32_t addr = RandomAddr();
+            if (!routes_.empty() && (i % 2) == 0) {
+                // Bias towards addresses covered by a route.
+                addr = routes_[rand() % routes_.size()]->addr_ | (addr & 0xFF);
+            }
+            ASSERT_EQ(TreeLPM(addr), trie_.LPMFind(addr));
+        }
+    }
+
+    size_t route_count_;
+    size_t lookup_count_;
+    vector<Route *> routes_;
+    RouteTree tree_;
+    RouteTrie trie_;
+};
+
+TEST_F(Ip4LPMTrieTest, Basic) {
+    EXPECT_TRUE(trie_.LPMFind(0x0a010101) == NULL);
+
+    AddRoute(0x0a000000, 8);
+    AddRoute(0x0a010000, 16);
+    AddRoute(0x0a010100, 24);
+    AddRoute(0x0a010101, 32);
+    AddRoute(0x0a010180, 25);
+    EXPECT_EQ(5U, trie_.size());
+
+    EXPECT_EQ(32, trie_.LPMFind(0x0a010101)->len_);
+    EXPECT_EQ(24, trie_.LPMFind(0x0a010102)->len_);
+    EXPECT_EQ(25, trie_.LPMFind(0x0a0101ff)->len_);
+    EXPECT_EQ(16, trie_.LPMFind(0x0a010201)->len_);
+    EXPECT_EQ(8, trie_.LPMFind(0x0a020201)->len_);
+    EXPECT_TRUE(trie_.LPMFind(0x0b000001) == NULL);
+
+    AddRoute(0, 0);
+    EXPECT_EQ(0, trie_.LPMFind(0x0b000001)->len_);
+
+    // Duplicate insert replaces the data.
+    EXPECT_FALSE(trie_.Insert(0x0a010100, 24, routes_[2]));
+    EXPECT_FALSE(trie_.Remove(0x0a010200, 24));
+
+    while (!routes_.empty()) {
+        RemoveRoute(routes_.size() - 1);
+        VerifyLookups(100);
+    }
+    EXPECT_EQ(0U, trie_.size());
+    EXPECT_EQ(1U, trie_.node_count());
+}
+
+// Random adds and deletes, checked against the Patricia tree.
+TEST_F(Ip4LPMTrieTest, Random) {
+    for (int i = 0; i < 5000; i++) {
+        AddRoute(RandomAddr(), RandomLen());
+    }
+    VerifyLookups(20000);
+
+    for (int i = 0; i < 2500; i++) {
+        RemoveRoute(rand() % routes_.size());
+    }
+    VerifyLookups(20000);
+
+    while (!routes_.empty()) {
+        RemoveRoute(rand() % routes_.size());
+    }
+    EXPECT_EQ(0U, trie_.size());
+    EXPECT_EQ(1U, trie_.node_count());
+}
+
+// Lookups per second of the trie against the Patricia tree.
+TEST_F(Ip4LPMTrieTest, Benchmark) {
+    while (routes_.size() < route_count_) {
+        AddRoute(RandomAddr(), RandomLen());
+    }
+
+    vector<uint32_t> addrs(lookup_count_);
+    for (size_t i = 0; i < lookup_count_; i++) {
+        addrs[i] = routes_[rand() % routes_.size()]->addr_ |
+            (RandomAddr() & 0xFF);
+    }
+
+    uint64_t t0 = UTCTimestampUsec();
+    size_t tree_found = 0;
+    for (size_t i = 0; i < lookup_count_; i++) {
+        if (TreeLPM(addrs[i]) != NULL)
+            tree_found++;
+    }
+    uint64_t tree_usecs = UTCTimestampUsec() - t0 + 1;
+
+    t0 = UTCTimestampUsec();
+    size_t trie_found = 0;
+    for (size_t i = 0; i < lookup_count_; i++) {
+        if (trie_.LPMFind(addrs[i]) != NULL)
+            trie_found++;
+    }
+    uint64_t trie_usecs = UTCTimestampUsec() - t0 + 1;
+    EXPECT_EQ(tree_found, trie_found);
+
+    cout << "routes: " << routes_.size() << " trie nodes: "
+         << trie_.node_count() << endl;
+    cout << "patricia lookups/sec: "
+         << lookup_count_ * 1000000 / tree_usecs << endl;
+    cout << "trie     lookups/sec: "
+         << lookup_count_ * 1000000 / trie_usecs << endl;
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
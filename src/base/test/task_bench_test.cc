@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+//
+// Contention benchmark for TaskScheduler::Enqueue and task exit.
+//
+// A number of pthreads concurrently enqueue trivial tasks, each thread with
+// its own task id, and the time to run all tasks to completion is measured
+// for an increasing number of enqueue threads. The benchmark is run with the
+// global scheduler mutex and with the sharded run queue.
+//
+// Environment variables:
+//     TASK_BENCH_TASK_COUNT   - tasks enqueued per thread (default 100000)
+//     TASK_BENCH_THREAD_COUNT - maximum number of enqueue threads
+//
+
+#include <pthread.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <boost/foreach.hpp>
+#include <tbb/atomic.h>
+
+#include "base/logging.h"
+#include "base/task.h"
+#include "base/util.h"
+#include "base/test/task_test_util.h"
+#include "testing/gunit.h"
+
+using namespace std;
+
+static tbb::atomic<int> bench_done_count;
+static tbb::atomic<int> bench_exclusion_running;
+static tbb::atomic<int> bench_exclusion_violations;
+
+class BenchTask : public Task {
+public:
+    BenchTask(int task_id) : Task(task_id) { }
+    virtual bool Run() {
+        bench_done_count++;
+        return true;
+    }
+};
+
+class BenchExclusionTask : public Task {
+public:
+    BenchExclusionTask(int task_id, int instance)
+        : Task(task_id, instance) { }
+    virtual bool Run() {
+        if (bench_exclusion_running.fetch_and_increment() != 0)
+            bench_exclusion_violations++;
+        usleep(10);
+        bench_exclusion_running--;
+        bench_done_count++;
+        return true;
+    }
+};
+
+static tbb::atomic<bool> bench_gate_closed;
+static tbb::atomic<int> bench_cancel_failed;
+static tbb::atomic<int> bench_cancel_ran;
+
+// Holds off the other tasks of its <task-id, instance> until the gate opens.
+class BenchGateTask : public Task {
+public:
+    BenchGateTask(int task_id, int instance) : Task(task_id, instance) { }
+    virtual bool Run() {
+        while (bench_gate_closed)
+            usleep(100);
+        return true;
+    }
+};
+
+class BenchCancelTask : public Task {
+public:
+    BenchCancelTask(int task_id, int instance) : Task(task_id, instance) { }
+    virtual bool Run() {
+        bench_cancel_ran++;
+        return true;
+    }
+};
+
+struct BenchThreadArgs {
+    int task_id;
+    int task_count;
+    bool exclusion;
+};
+
+static void *BenchThreadRun(void *objp) {
+    BenchThreadArgs *args = reinterpret_cast<BenchThreadArgs *>(objp);
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    for (int i = 0; i < args->task_count; i++) {
+        if (args->exclusion) {
+            scheduler->Enqueue(new BenchExclusionTask(args->task_id, 0));
+        } else {
+            scheduler->Enqueue(new BenchTask(args->task_id));
+        }
+    }
+    return NULL;
+}
+
+// Each task is cancelled right after it is enqueued. It is queued behind the
+// gate task, so the Cancel must find it waiting.
+static void *BenchCancelThreadRun(void *objp) {
+    BenchThreadArgs *args = reinterpret_cast<BenchThreadArgs *>(objp);
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    scheduler->Enqueue(new BenchGateTask(args->task_id, 0));
+    for (int i = 0; i < args->task_count; i++) {
+        Task *task = new BenchCancelTask(args->task_id, 0);
+        scheduler->Enqueue(task);
+        if (scheduler->Cancel(task) != TaskScheduler::CANCELLED)
+            bench_cancel_failed++;
+    }
+    return NULL;
+}
+
+class TaskBenchTest : public ::testing::Test {
+protected:
+    TaskBenchTest() : scheduler_(TaskScheduler::GetInstance()) {
+        task_count_ = 100000;
+        char *str = getenv("TASK_BENCH_TASK_COUNT");
+        if (str) task_count_ = strtoul(str, NULL, 0);
+
+        max_threads_ = scheduler_->HardwareThreadCount();
+        str = getenv("TASK_BENCH_THREAD_COUNT");
+        if (str) max_threads_ = strtoul(str, NULL, 0);
+    }
+
+    virtual void TearDown() {
+        task_util::WaitForIdle();
+        scheduler_->SetShardedRunQueue(false);
+    }
+
+    // Returns the number of tasks completed per second.
+    uint64_t RunBench(int thread_count, bool exclusion) {
+        vector<pthread_t> thread_ids;
+        vector<BenchThreadArgs> args(thread_count);
+        pthread_t tid;
+
+        bench_done_count = 0;
+        uint64_t start = UTCTimestampUsec();
+        for (int i = 0; i < thread_count; i++) {
+            ostringstream name;
+            name << "bench::Task" << i;
+            args[i].task_id = exclusion ?
+                scheduler_->GetTaskId("bench::Exclusion") :
+                scheduler_->GetTaskId(name.str());
+            args[i].task_count = task_count_;
+            args[i].exclusion = exclusion;
+            pthread_create(&tid, NULL, &BenchThreadRun, &args[i]);
+            thread_ids.push_back(tid);
+        }
+        BOOST_FOREACH(tid, thread_ids) { pthread_join(tid, NULL); }
+        TASK_UTIL_EXPECT_EQ(thread_count * task_count_,
+                            static_cast<int>(bench_done_count));
+        uint64_t elapsed = UTCTimestampUsec() - start;
+        if (elapsed == 0)
+            elapsed = 1;
+        return (uint64_t) thread_count * task_count_ * 1000000 / elapsed;
+    }
+
+    void RunScaling(bool sharded) {
+        scheduler_->SetShardedRunQueue(sharded);
+        for (int threads = 1; threads <= max_threads_; threads *= 2) {
+            uint64_t rate = RunBench(threads, false);
+            cout << (sharded ? "sharded" : "mutex") << " threads: "
+                 << threads << " tasks/sec: " << rate << endl;
+        }
+    }
+
+    TaskScheduler *scheduler_;
+    int task_count_;
+    int max_threads_;
+};
+
+TEST_F(TaskBenchTest, MutexScaling) {
+    RunScaling(false);
+}
+
+TEST_F(TaskBenchTest, ShardedScaling) {
+    RunScaling(true);
+}
+
+// Tasks of the same <task-id, instance> must never run concurrently when
+// enqueued from many threads through the sharded run queue.
+TEST_F(TaskBenchTest, ShardedExclusion) {
+    scheduler_->SetShardedRunQueue(true);
+    bench_exclusion_running = 0;
+    bench_exclusion_violations = 0;
+    int saved_count = task_count_;
+    task_count_ = min(task_count_, 1000);
+    RunBench(max(max_threads_, 2), true);
+    task_count_ = saved_count;
+    EXPECT_EQ(0, static_cast<int>(bench_exclusion_violations));
+}
+
+// An Enqueue posted to a shard must be applied before a Cancel issued by the
+// same thread right after it.
+TEST_F(TaskBenchTest, ShardedEnqueueCancel) {
+    scheduler_->SetShardedRunQueue(true);
+    bench_gate_closed = true;
+    bench_cancel_failed = 0;
+    bench_cancel_ran = 0;
+
+    int thread_count = max(max_threads_, 4);
+    vector<pthread_t> thread_ids;
+    vector<BenchThreadArgs> args(thread_count);
+    pthread_t tid;
+    for (int i = 0; i < thread_count; i++) {
+        ostringstream name;
+        name << "bench::Cancel" << i;
+        args[i].task_id = scheduler_->GetTaskId(name.str());
+        args[i].task_count = min(task_count_, 10000);
+        args[i].exclusion = false;
+        pthread_create(&tid, NULL, &BenchCancelThreadRun, &args[i]);
+        thread_ids.push_back(tid);
+    }
+    BOOST_FOREACH(tid, thread_ids) { pthread_join(tid, NULL); }
+    bench_gate_closed = false;
+    task_util::WaitForIdle();
+
+    EXPECT_EQ(0, static_cast<int>(bench_cancel_failed));
+    EXPECT_EQ(0, static_cast<int>(bench_cancel_ran));
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -113,7 +113,13 @@ public:
 
     friend std::size_t hash_value(AsPath const &as_path) {
         size_t hash = 0;
-        boost::hash_combine(hash, as_path.path().ToString());
+        const std::vector<AsPathSpec::PathSegment *> &segments =
+            as_path.path().path_segments;
+        for (size_t i = 0; i < segments.size(); i++) {
+            boost::hash_combine(hash, segments[i]->path_segment_type);
+            boost::hash_range(hash, segments[i]->path_segment.begin(),
+                              segments[i]->path_segment.end());
+        }
         return hash;
     }
 
@@ -147,14 +153,8 @@ inline void intrusive_ptr_release(const AsPath *cpath) {
 
 typedef boost::intrusive_ptr<const AsPath> AsPathPtr;
 
-struct AsPathCompare {
-    bool operator()(const AsPath *lhs, const AsPath *rhs) {
-        return lhs->CompareTo(*rhs) < 0;
-    }
-};
-
 class AsPathDB : public BgpPathAttributeDB<AsPath, AsPathPtr, AsPathSpec,
-                                           AsPathCompare, AsPathDB> {
+                                           AsPathDB> {
 public:
     AsPathDB(BgpServer *server);
 
@@ -141,6 +141,8 @@ struct BgpMpNlri : public BgpAttribute {
     std::vector<uint8_t> nexthop;
 
     std::vector<BgpProtoPrefix *> nlri;
+    // NLRI in wire format, see BgpProto::DecodeUpdate
+    std::vector<uint8_t> raw_nlri;
 };
 
 struct BgpAttrLabelBlock : public BgpAttribute {
@@ -165,7 +167,7 @@ public:
 
     friend std::size_t hash_value(BgpOListElem const &elem) {
         size_t hash = 0;
-        boost::hash_combine(hash, elem.address.to_string());
+        boost::hash_combine(hash, elem.address.to_ulong());
         boost::hash_combine(hash, elem.label);
         return hash;
     }
@@ -322,14 +324,8 @@ inline void intrusive_ptr_release(const BgpAttr *cattrp) {
 
 typedef boost::intrusive_ptr<const BgpAttr> BgpAttrPtr;
 
-struct BgpAttrCompare {
-    bool operator()(const BgpAttr *lhs, const BgpAttr *rhs) {
-        return lhs->CompareTo(*rhs) < 0;
-    }
-};
-
 class BgpAttrDB : public BgpPathAttributeDB<BgpAttr, BgpAttrPtr, BgpAttrSpec,
-                                            BgpAttrCompare, BgpAttrDB> {
+                                            BgpAttrDB> {
 public:
     BgpAttrDB(BgpServer *server);
     BgpAttrPtr ReplaceExtCommunityAndLocate(const BgpAttr *attr,
@@ -6,9 +6,9 @@
 #define ctrlplane_bgp_attr_base_h
 
 #include <boost/functional/hash.hpp>
-#include <boost/scoped_array.hpp>
 #include <set>
 #include <string>
+#include <tbb/concurrent_hash_map.h>
 #include <tbb/mutex.h>
 #include <vector>
 #include "base/parse_object.h"
@@ -69,35 +69,24 @@ struct BgpProtoPrefix : public ParseObject {
 // Base class to manage BGP Path Attributes database. This class provides
 // thread safe access to the data base.
 //
-// Lock contention can be tuned by varying the hash table size passed to the
-// constructor.
+// The attributes are kept in a tbb::concurrent_hash_map, which grows as
+// needed. Lookups of attributes that are already present only take reader
+// locks, so concurrent lookups of the same attribute don't serialize.
 //
-// Attribute contents must be hashable via hash_value() and hashed using
-// boost::hash_combine() to partition the attribute database.
-template <class Type, class TypePtr, class TypeSpec, typename TypeCompare,
-          class TypeDB>
+// Attribute contents must be hashable via hash_value() and comparable via
+// CompareTo().
+template <class Type, class TypePtr, class TypeSpec, class TypeDB>
 class BgpPathAttributeDB {
 public:
-    BgpPathAttributeDB(int hash_size = GetHashSize()) :
-            hash_size_(hash_size), set_(new Set[hash_size]),
-            mutex_(new tbb::mutex[hash_size]) {
+    BgpPathAttributeDB() {
     }
 
     size_t Size() {
-        size_t size = 0;
-
-        for (size_t i = 0; i < hash_size_; i++) {
-            tbb::mutex::scoped_lock lock(mutex_[i]);
-            size += set_[i].size();
-        }
-        return size;
+        return map_.size();
     }
 
     void Delete(Type *attr) {
-        size_t hash = HashCompute(attr);
-
-        tbb::mutex::scoped_lock lock(mutex_[hash]);
-        set_[hash].erase(attr);
+        map_.erase(attr);
     }
 
     // Locate passed in attribute in the data base based on the attr ptr.
@@ -112,20 +101,29 @@ public:
     }
 
 private:
-    const size_t HashCompute(Type *attr) const {
-        if (hash_size_ <= 1) return 0;
-
-        size_t hash = 0;
-        boost::hash_combine(hash, *attr);
-        return hash % hash_size_;
-    }
-
-    static size_t GetHashSize() {
-        char *str = getenv("BGP_PATH_ATTRIBUTE_DB_HASH_SIZE");
-
-        // Use just one bucket for now.
-        if (!str) return 1;
-        return strtoul(str, NULL, 0);
+    struct HashCompare {
+        static size_t hash(Type *const &attr) {
+            return hash_value(*attr);
+        }
+        static bool equal(Type *const &lhs, Type *const &rhs) {
+            return lhs->CompareTo(*rhs) == 0;
+        }
+    };
+    typedef tbb::concurrent_hash_map<Type *, bool, HashCompare> Map;
+
+    // Take a reference to an entry of the data base, unless the entry is
+    // undergoing deletion. This can happen because attribute intrusive
+    // pointer is released without any lock: an entry whose refcount has
+    // dropped to 0 stays in the data base until Delete erases it.
+    static bool Reference(Type *entry, TypePtr *ptr) {
+        // Take a reference to prevent this entry from getting deleted.
+        int prev = intrusive_ptr_add_ref(entry);
+        if (prev > 0)
+            *ptr = TypePtr(entry);
+
+        // Release redundant refcount taken above.
+        intrusive_ptr_del_ref(entry);
+        return prev > 0;
     }
 
     // This template safely retrieves an attribute entry from its data base.
@@ -134,71 +132,42 @@ private:
     // If the entry is already present, then passed in entry is freed and
     // existing entry is returned.
     TypePtr LocateInternal(Type *attr) {
-
-        // Hash attribute contents to to avoid potential mutex contention.
-        size_t hash = HashCompute(attr);
+        TypePtr ptr;
         while (true) {
+            // Common case, the entry is already present.
+            {
+                typename Map::const_accessor accessor;
+                if (map_.find(accessor, attr) &&
+                    Reference(accessor->first, &ptr)) {
+                    delete attr;
+                    return ptr;
+                }
+            }
 
-            // Grab mutex to keep db access thread safe.
-            tbb::mutex::scoped_lock lock(mutex_[hash]);
-            std::pair<typename Set::iterator, bool> ret;
-
-            // Try to insert the passed entry into the database.
-            ret = set_[hash].insert(attr);
-
-            // Take a reference to prevent this entry from getting deleted.
-            // Counter is automatically incremented, hence we get thread safety
-            // here.
-            int prev = intrusive_ptr_add_ref(*ret.first);
-
-            // Check if passed in entry did get into the data base.
-            if (ret.second) {
-
-                // Take intrusive pointer, thereby incrementing the refcount.
-                TypePtr ptr = TypePtr(*ret.first);
-
-                // Release redundant refcount taken above to protect this entry
-                // from getting deleted, as we have now bumped up refcount above
-                intrusive_ptr_del_ref(*ret.first);
+            // Try to insert the passed entry into the database. The write
+            // lock on the new entry keeps others from finding it before it
+            // is referenced.
+            typename Map::accessor accessor;
+            if (map_.insert(accessor, attr)) {
+                ptr = TypePtr(attr);
                 return ptr;
             }
 
-            // Make sure that this entry, though in the database is not
-            // undergoing deletion. This can happen because attribute intrusive
-            // pointer is released without taking the mutex.
-            //
-            // If the previous refcount is 0, it implies that this entry is
-            // about to get deleted (after we release the mutex). In such
-            // cases, we retry inserting the passed attribute pointer into the
-            // data base.
-            if (prev > 0) {
-
-                // Free passed in attribute, as it is already in the database.
+            // Somebody else inserted the entry in the meantime.
+            if (Reference(accessor->first, &ptr)) {
                 delete attr;
-
-                // Take intrusive pointer, thereby incrementing the refcount.
-                TypePtr ptr = TypePtr(*ret.first);
-
-                // Release redundant refcount taken above to protect this entry
-                // from getting deleted, as we have now bumped up refcount above
-                intrusive_ptr_del_ref(*ret.first);
                 return ptr;
             }
 
-            // Decrement the counter bumped up above as we can't use this entry
-            // which is above to be deleted. Instead, retry inserting the passed
-            // entry again, into the database.
-            intrusive_ptr_del_ref(*ret.first);
+            // The entry in the data base is about to be deleted. Retry
+            // once it is gone.
         }
 
         assert(false);
         return NULL;
     }
 
-    typedef std::set<Type *, TypeCompare> Set;
-    size_t hash_size_;
-    boost::scoped_array<Set> set_;
-    boost::scoped_array<tbb::mutex> mutex_;
+    Map map_;
 };
 
 #endif
@@ -4,13 +4,20 @@
 
 #include "bgp/bgp_message_builder.h"
 
+#include <algorithm>
+
 #include "base/logging.h"
 #include "base/parse_object.h"
 #include "bgp/bgp_log.h"
 #include "bgp/bgp_route.h"
+#include "bgp/evpn/evpn_route.h"
+#include "bgp/inet/inet_route.h"
+#include "bgp/l3vpn/inetvpn_route.h"
 #include "net/bgp_af.h"
 
-BgpMessage::BgpMessage() {
+BgpMessage::BgpMessage()
+    : datalen_(0), msg_length_offset_(-1), attr_length_offset_(-1),
+      nlri_length_offset_(-1) {
 }
 
 BgpMessage::~BgpMessage() {
@@ -128,48 +135,161 @@ void BgpMessage::Start(const RibOutAttr *roattr, const BgpRoute *route) {
     } else {
         StartUnreach(route);
     }
+    msg_length_offset_ = encode_offsets_.FindOffset("BgpMsgLength");
+    attr_length_offset_ = encode_offsets_.FindOffset("BgpPathAttribute");
+    nlri_length_offset_ = encode_offsets_.FindOffset("MpReachUnreachNlri");
 }
 
-bool BgpMessage::UpdateLength(const char *tag, int size, int delta) {
-    int offset = encode_offsets_.FindOffset(tag);
+bool BgpMessage::UpdateLength(int offset, int delta) {
     if (offset < 0) {
         return false;
     }
-    int value = get_value(&data_[offset], size);
+    int value = get_value(&data_[offset], 2);
     value += delta;
-    put_value(&data_[offset], size, value);
+    put_value(&data_[offset], 2, value);
     return true;
 }
 
-bool BgpMessage::AddRoute(const BgpRoute *route, const RibOutAttr *roattr) {
-    uint8_t *data = data_ + datalen_;
-    size_t size = sizeof(data_) - datalen_;
+//
+// Label stack entry with the bottom of stack bit set, as written by the
+// BuildProtoPrefix methods.
+//
+static void EncodeLabel(uint32_t label, uint8_t *data) {
+    uint32_t tmp = (label << 4 | 0x1);
+    data[0] = (tmp >> 16) & 0xff;
+    data[1] = (tmp >> 8) & 0xff;
+    data[2] = tmp & 0xff;
+}
+
+// Prefix length in bits followed by the significant bytes of the address.
+static int EncodeInetNlri(const InetRoute *route, uint8_t *data, size_t size) {
+    const Ip4Prefix &prefix = route->GetPrefix();
+    int num_bytes = (prefix.prefixlen() + 7) / 8;
+    if (size < static_cast<size_t>(1 + num_bytes))
+        return -1;
+
+    data[0] = prefix.prefixlen();
+    const Ip4Address::bytes_type &addr_bytes = prefix.ip4_addr().to_bytes();
+    std::copy(addr_bytes.begin(), addr_bytes.begin() + num_bytes, data + 1);
+    return 1 + num_bytes;
+}
+
+// Prefix length in bits including label and RD, label, RD and the
+// significant bytes of the address.
+static int EncodeInetVpnNlri(const InetVpnRoute *route, uint32_t label,
+                             uint8_t *data, size_t size) {
+    const size_t rd_size = RouteDistinguisher::kSize;
+    const size_t label_size = 3;
+    const InetVpnPrefix &prefix = route->GetPrefix();
+    int prefixlen = prefix.prefixlen() + (rd_size + label_size) * 8;
+    int num_bytes = (prefixlen + 7) / 8;
+    if (size < static_cast<size_t>(1 + num_bytes))
+        return -1;
+
+    uint8_t *ptr = data;
+    *ptr++ = prefixlen;
+    EncodeLabel(label, ptr);
+    ptr += label_size;
+    RouteDistinguisher rd = prefix.route_distinguisher();
+    std::copy(rd.GetData(), rd.GetData() + rd_size, ptr);
+    ptr += rd_size;
+    int num_ip_bytes = num_bytes - rd_size - label_size;
+    const Ip4Address::bytes_type &addr_bytes = prefix.addr().to_bytes();
+    std::copy(addr_bytes.begin(), addr_bytes.begin() + num_ip_bytes, ptr);
+    return 1 + num_bytes;
+}
+
+// Route type and length in bytes followed by the MAC advertisement route:
+// RD, ESI, ethernet tag, MAC, IP address and label. The ESI and ethernet
+// tag are left zero as in EvpnPrefix::BuildProtoPrefix.
+static int EncodeEvpnNlri(const EvpnRoute *route, uint32_t label,
+                          uint8_t *data, size_t size) {
+    const size_t rd_size = RouteDistinguisher::kSize;
+    const size_t esi_size = 10;
+    const size_t tag_size = 4;
+    const size_t mac_size = MacAddress::kSize;
+    const size_t ip_size = 4;
+    const size_t label_size = 3;
+    const size_t num_bytes = rd_size + esi_size + tag_size +
+        1 + mac_size + 1 + ip_size + label_size;
+    if (size < 2 + num_bytes)
+        return -1;
+
+    const EvpnPrefix &prefix = route->GetPrefix();
+    uint8_t *ptr = data;
+    *ptr++ = 2;
+    *ptr++ = num_bytes;
+    RouteDistinguisher rd = prefix.route_distinguisher();
+    std::copy(rd.GetData(), rd.GetData() + rd_size, ptr);
+    ptr += rd_size;
+    std::fill(ptr, ptr + esi_size + tag_size, 0);
+    ptr += esi_size + tag_size;
+    *ptr++ = 48;
+    MacAddress mac_addr = prefix.mac_addr();
+    std::copy(mac_addr.GetData(), mac_addr.GetData() + mac_size, ptr);
+    ptr += mac_size;
+    Ip4Prefix ip_prefix = prefix.ip_prefix();
+    *ptr++ = ip_prefix.prefixlen();
+    const Ip4Address::bytes_type &addr_bytes = ip_prefix.ip4_addr().to_bytes();
+    std::copy(addr_bytes.begin(), addr_bytes.begin() + ip_size, ptr);
+    ptr += ip_size;
+    EncodeLabel(label, ptr);
+    return 2 + num_bytes;
+}
+
+int BgpMessage::EncodeNlri(const BgpRoute *route, uint32_t label,
+                           uint8_t *data, size_t size) {
+    uint16_t afi = route->Afi();
+    uint8_t safi = route->Safi();
+    if (afi == BgpAf::IPv4 && safi == BgpAf::Unicast) {
+        return EncodeInetNlri(static_cast<const InetRoute *>(route),
+                              data, size);
+    }
+    if (afi == BgpAf::IPv4 && safi == BgpAf::Vpn) {
+        return EncodeInetVpnNlri(static_cast<const InetVpnRoute *>(route),
+                                 label, data, size);
+    }
+    if (afi == BgpAf::L2Vpn && safi == BgpAf::EVpn) {
+        return EncodeEvpnNlri(static_cast<const EvpnRoute *>(route),
+                              label, data, size);
+    }
+    return EncodeNlriGeneric(route, label, data, size);
+}
 
+int BgpMessage::EncodeNlriGeneric(const BgpRoute *route, uint32_t label,
+                                  uint8_t *data, size_t size) {
     BgpMpNlri nlri;
     nlri.afi = route->Afi();
     nlri.safi = route->Safi();
     BgpProtoPrefix *prefix = new BgpProtoPrefix;
-    uint32_t label = roattr ? roattr->label() : 0;
     route->BuildProtoPrefix(prefix, label);
     nlri.nlri.push_back(prefix);
+    return BgpProto::Encode(&nlri, data, size);
+}
+
+bool BgpMessage::AddRoute(const BgpRoute *route, const RibOutAttr *roattr) {
+    uint8_t *data = data_ + datalen_;
+    size_t size = sizeof(data_) - datalen_;
+
+    uint32_t label = roattr ? roattr->label() : 0;
     if (roattr->IsReachable()) {
         num_reach_route_++;
     } else {
         num_unreach_route_++;
     }
 
-    int result = BgpProto::Encode(&nlri, data, size);
+    int result = EncodeNlri(route, label, data, size);
     if (result <= 0) return false;
 
     datalen_ += result;
-    if (!UpdateLength("BgpMsgLength", 2, result)) {
+    if (!UpdateLength(msg_length_offset_, result)) {
         BGP_LOG(BgpMessageBuilder, SandeshLevel::SYS_WARN, BGP_LOG_FLAG_ALL,
                 "Cannot find BGP message length", datalen_, route->ToString());
         assert(false);
         return false;
     }
 
-    if (!UpdateLength("BgpPathAttribute", 2, result)) {
+    if (!UpdateLength(attr_length_offset_, result)) {
         BGP_LOG(BgpMessageBuilder, SandeshLevel::SYS_WARN, BGP_LOG_FLAG_ALL,
                 "Cannot find BGP attributes length", datalen_,
                 route->ToString());
@@ -177,7 +297,7 @@ bool BgpMessage::AddRoute(const BgpRoute *route, const RibOutAttr *roattr) {
         return false;
     }
 
-    if (!UpdateLength("MpReachUnreachNlri", 2, result)) {
+    if (!UpdateLength(nlri_length_offset_, result)) {
         BGP_LOG(BgpMessageBuilder, SandeshLevel::SYS_WARN, BGP_LOG_FLAG_ALL,
                 "Cannot find MP Reach/Unreach NLRI length", datalen_,
                 route->ToString());
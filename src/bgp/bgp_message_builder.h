@@ -17,12 +17,26 @@ public:
     virtual void Finish();
     virtual const uint8_t *GetData(IPeerUpdate *ipeer_update, size_t *lenp);
 
+    // Write the MP reach/unreach NLRI of the route to data and return the
+    // number of bytes written, or a negative value if it does not fit.
+    // EncodeNlri writes the inet, inet-vpn and e-vpn wire formats directly
+    // and falls back to EncodeNlriGeneric, the BgpProto::Encode based
+    // encoder, for other families. Both produce identical output.
+    static int EncodeNlri(const BgpRoute *route, uint32_t label,
+                          uint8_t *data, size_t size);
+    static int EncodeNlriGeneric(const BgpRoute *route, uint32_t label,
+                                 uint8_t *data, size_t size);
+
 private:
     void StartReach(const RibOutAttr *roattr, const BgpRoute *route);
     void StartUnreach(const BgpRoute *route);
-    bool UpdateLength(const char *tag, int size, int delta);
+    bool UpdateLength(int offset, int delta);
 
     EncodeOffsets encode_offsets_;
+    // Offsets of the length fields patched by AddRoute, looked up once
+    int msg_length_offset_;
+    int attr_length_offset_;
+    int nlri_length_offset_;
     uint8_t data_[BgpProto::kMaxMessageSize];
     size_t datalen_;
     DISALLOW_COPY_AND_ASSIGN(BgpMessage);
@@ -784,7 +784,8 @@ void BgpPeer::ProcessUpdate(const BgpProto::Update *msg) {
 
 
     RoutingInstance *instance = GetRoutingInstance();
-    if (msg->nlri.size() || msg->withdrawn_routes.size()) {
+    if (msg->nlri.size() || msg->withdrawn_routes.size() ||
+        msg->raw_nlri.size() || msg->raw_withdrawn_routes.size()) {
         InetTable *table =
             static_cast<InetTable *>(instance->GetTable(Address::INET));
         if (!table) {
@@ -793,28 +794,32 @@ void BgpPeer::ProcessUpdate(const BgpProto::Update *msg) {
             return;
         }
 
-        for (vector<BgpProtoPrefix *>::const_iterator it =
-             msg->withdrawn_routes.begin(); it != msg->withdrawn_routes.end();
-             ++it++) {
-            DBRequest req;
-            req.oper = DBRequest::DB_ENTRY_DELETE;
-            req.data.reset(NULL);
-            Ip4Prefix prefix = Ip4Prefix(**it);
-            req.key.reset(new InetTable::RequestKey(prefix, this));
-            table->Enqueue(&req);
+        vector<DBRequest *> requests;
+        BgpProtoPrefixReader withdrawn_reader(msg->withdrawn_routes,
+                                              msg->raw_withdrawn_routes, false);
+        for (const BgpProtoPrefix *proto_prefix = withdrawn_reader.Next();
+             proto_prefix != NULL; proto_prefix = withdrawn_reader.Next()) {
+            DBRequest *req = new DBRequest;
+            req->oper = DBRequest::DB_ENTRY_DELETE;
+            Ip4Prefix prefix = Ip4Prefix(*proto_prefix);
+            req->key.reset(new InetTable::RequestKey(prefix, this));
+            requests.push_back(req);
             inc_rx_route_unreach();
         }
-
-        for (vector<BgpProtoPrefix *>::const_iterator it = msg->nlri.begin();
-             it != msg->nlri.end(); ++it) {
-            DBRequest req;
-            req.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
-            req.data.reset(new InetTable::RequestData(attr, flags, 0));
-            Ip4Prefix prefix = Ip4Prefix(**it);
-            req.key.reset(new InetTable::RequestKey(prefix, this));
-            table->Enqueue(&req);
+        EnqueueRequests(table, &requests);
+
+        BgpProtoPrefixReader nlri_reader(msg->nlri, msg->raw_nlri, false);
+        for (const BgpProtoPrefix *proto_prefix = nlri_reader.Next();
+             proto_prefix != NULL; proto_prefix = nlri_reader.Next()) {
+            DBRequest *req = new DBRequest;
+            req->oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+            req->data.reset(new InetTable::RequestData(attr, flags, 0));
+            Ip4Prefix prefix = Ip4Prefix(*proto_prefix);
+            req->key.reset(new InetTable::RequestKey(prefix, this));
+            requests.push_back(req);
             inc_rx_route_reach();
         }
+        EnqueueRequests(table, &requests);
     }
 
     for (std::vector<BgpAttribute *>::const_iterator ait =
@@ -846,22 +851,26 @@ void BgpPeer::ProcessUpdate(const BgpProto::Update *msg) {
         if ((*ait)->code == BgpAttribute::MPReachNlri)
             attr = GetMpNlriNexthop(nlri, attr);
 
+        vector<DBRequest *> requests;
+        BgpProtoPrefixReader reader(nlri->nlri, nlri->raw_nlri,
+                                    family == Address::EVPN);
         switch (family) {
         case Address::INET: {
             InetTable *table =
                 static_cast<InetTable *>(instance->GetTable(family));
             assert(table);
 
-            vector<BgpProtoPrefix *>::const_iterator it;
-            for (it = nlri->nlri.begin(); it < nlri->nlri.end(); it++) {
-                DBRequest req;
-                req.oper = oper;
+            for (const BgpProtoPrefix *proto_prefix = reader.Next();
+                 proto_prefix != NULL; proto_prefix = reader.Next()) {
+                DBRequest *req = new DBRequest;
+                req->oper = oper;
                 if (oper == DBRequest::DB_ENTRY_ADD_CHANGE)
-                    req.data.reset(new InetTable::RequestData(attr, flags, 0));
-                Ip4Prefix prefix = Ip4Prefix(**it);
-                req.key.reset(new InetTable::RequestKey(prefix, this));
-                table->Enqueue(&req);
+                    req->data.reset(new InetTable::RequestData(attr, flags, 0));
+                Ip4Prefix prefix = Ip4Prefix(*proto_prefix);
+                req->key.reset(new InetTable::RequestKey(prefix, this));
+                requests.push_back(req);
             }
+            EnqueueRequests(table, &requests);
             break;
         }
 
@@ -870,19 +879,20 @@ void BgpPeer::ProcessUpdate(const BgpProto::Update *msg) {
               static_cast<InetVpnTable *>(instance->GetTable(family));
             assert(table);
 
-            vector<BgpProtoPrefix *>::const_iterator it;
-            for (it = nlri->nlri.begin(); it < nlri->nlri.end(); it++) {
-                uint32_t label = ((*it)->prefix[0] << 16 |
-                                  (*it)->prefix[1] << 8 |
-                                  (*it)->prefix[2]) >> 4;
-                DBRequest req;
-                req.oper = oper;
+            for (const BgpProtoPrefix *proto_prefix = reader.Next();
+                 proto_prefix != NULL; proto_prefix = reader.Next()) {
+                uint32_t label = (proto_prefix->prefix[0] << 16 |
+                                  proto_prefix->prefix[1] << 8 |
+                                  proto_prefix->prefix[2]) >> 4;
+                DBRequest *req = new DBRequest;
+                req->oper = oper;
                 if (oper == DBRequest::DB_ENTRY_ADD_CHANGE)
-                    req.data.reset(new InetVpnTable::RequestData(attr, flags, label));
-                req.key.reset(new InetVpnTable::RequestKey(InetVpnPrefix(**it),
-                                                           this));
-                table->Enqueue(&req);
+                    req->data.reset(new InetVpnTable::RequestData(attr, flags, label));
+                req->key.reset(new InetVpnTable::RequestKey(
+                    InetVpnPrefix(*proto_prefix), this));
+                requests.push_back(req);
             }
+            EnqueueRequests(table, &requests);
             break;
         }
 
@@ -891,25 +901,28 @@ void BgpPeer::ProcessUpdate(const BgpProto::Update *msg) {
               static_cast<EvpnTable *>(instance->GetTable(family));
             assert(table);
 
-            vector<BgpProtoPrefix *>::const_iterator it;
-            for (it = nlri->nlri.begin(); it < nlri->nlri.end(); it++) {
-                if ((*it)->type != 2) {
+            for (const BgpProtoPrefix *proto_prefix = reader.Next();
+                 proto_prefix != NULL; proto_prefix = reader.Next()) {
+                if (proto_prefix->type != 2) {
                     BGP_LOG_PEER(this, SandeshLevel::SYS_WARN, BGP_LOG_FLAG_ALL,
                                  BGP_PEER_DIR_IN,
-                                 "EVPN: Unsupported route type " << (*it)->type);
+                                 "EVPN: Unsupported route type " <<
+                                 proto_prefix->type);
                     continue;
                 }
-                size_t label_offset = EvpnPrefix::label_offset(**it);
-                uint32_t label = ((*it)->prefix[label_offset] << 16 |
-                                  (*it)->prefix[label_offset + 1] << 8 |
-                                  (*it)->prefix[label_offset + 2]) >> 4;
-                DBRequest req;
-                req.oper = oper;
+                size_t label_offset = EvpnPrefix::label_offset(*proto_prefix);
+                uint32_t label = (proto_prefix->prefix[label_offset] << 16 |
+                                  proto_prefix->prefix[label_offset + 1] << 8 |
+                                  proto_prefix->prefix[label_offset + 2]) >> 4;
+                DBRequest *req = new DBRequest;
+                req->oper = oper;
                 if (oper == DBRequest::DB_ENTRY_ADD_CHANGE)
-                    req.data.reset(new EvpnTable::RequestData(attr, flags, label));
-                req.key.reset(new EvpnTable::RequestKey(EvpnPrefix(**it), this));
-                table->Enqueue(&req);
+                    req->data.reset(new EvpnTable::RequestData(attr, flags, label));
+                req->key.reset(new EvpnTable::RequestKey(
+                    EvpnPrefix(*proto_prefix), this));
+                requests.push_back(req);
             }
+            EnqueueRequests(table, &requests);
             break;
         }
 
@@ -919,6 +932,18 @@ void BgpPeer::ProcessUpdate(const BgpProto::Update *msg) {
     }
 }
 
+//
+// Hand the requests built for one section of an UPDATE to the table in a
+// single batch, one work queue entry per DB partition. The batch keeps the
+// order of the requests within each partition.
+//
+void BgpPeer::EnqueueRequests(BgpTable *table, vector<DBRequest *> *requests) {
+    if (requests->empty())
+        return;
+    table->EnqueueBatch(*requests);
+    STLDeleteValues(requests);
+}
+
 void BgpPeer::KeepaliveTimerErrorHandler(string error_name,
                                          string error_message) {
     BGP_LOG_PEER(this, SandeshLevel::SYS_CRIT, BGP_LOG_FLAG_ALL,
@@ -1014,7 +1039,9 @@ string BgpPeer::BytesToHexString(const u_int8_t *msg, size_t size) {
 void BgpPeer::ReceiveMsg(BgpSession *session, const u_int8_t *msg,
                          size_t size) {
     ParseErrorContext ec;
-    BgpProto::BgpMessage *minfo = BgpProto::Decode(msg, size, &ec);
+    BgpProto::BgpMessage *minfo = BgpProto::DecodeUpdate(msg, size);
+    if (minfo == NULL)
+        minfo = BgpProto::Decode(msg, size, &ec);
 
     if (minfo == NULL) {
         BGP_TRACE_PEER_PACKET(this, msg, size, SandeshLevel::SYS_WARN);
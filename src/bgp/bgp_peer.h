@@ -25,6 +25,8 @@
 #include "net/address.h"
 
 class BgpNeighborConfig;
+class BgpTable;
+struct DBRequest;
 class BgpPeerInfo;
 class BgpServer;
 class BgpSession;
@@ -212,6 +214,7 @@ private:
 
     virtual bool MpNlriAllowed(uint16_t afi, uint8_t safi);
     BgpAttrPtr GetMpNlriNexthop(BgpMpNlri *nlri, BgpAttrPtr attr);
+    void EnqueueRequests(BgpTable *table, std::vector<DBRequest *> *requests);
 
     void PostCloseRelease();
     void CustomClose();
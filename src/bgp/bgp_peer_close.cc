@@ -38,6 +38,7 @@ PeerCloseManager::PeerCloseManager(IPeer *peer) :
         stale_timer_(NULL),
         stale_timer_running_(false),
         start_stale_timer_(false) {
+    stale_path_count_ = 0;
 
     if (peer->server()) {
         stale_timer_ = TimerManager::CreateTimer(*peer->server()->ioservice(),
@@ -83,6 +84,14 @@ int PeerCloseManager::GetCloseTypeForTimerCallback(IPeerRib *peer_rib) {
         return MembershipRequest::RIBIN_DELETE;
     }
 
+    //
+    // Every stale path has been learned again or removed, there is nothing
+    // left to sweep
+    //
+    if (stale_path_count_ == 0) {
+        return MembershipRequest::INVALID;
+    }
+
     //
     // Peer has come back up and registered with this table again. Sweep all
     // the stale paths and remove those that did not reappear in the new session
@@ -276,11 +285,13 @@ void PeerCloseManager::Close() {
 }
 
 // For graceful-restart, we take mark-and-sweep approach instead of directly
-// deleting the paths. In the first walk, local-preference is lowered so that
-// the paths are least preferred and they are marked stale. After some time, if
-// the peer session does not come back up, we delete all the paths and the peer
-// itself. If the session did come back up, we flush only those paths that were
-// not learned again in the new session.
+// deleting the paths. In the first walk, the paths are marked stale in place
+// without notifying the routes. After some time, if the peer session does not
+// come back up, we delete all the paths and the peer itself. If the session
+// did come back up, we flush only those paths that were not learned again in
+// the new session. Paths learned again with the same attributes only have the
+// stale flag reset, and the sweep walk is skipped altogether once no stale
+// path is left.
 
 // ProcessRibIn
 //
@@ -319,7 +330,7 @@ void PeerCloseManager::ProcessRibIn(DBTablePartBase *root, BgpRoute *rt,
 
                 // Stale paths must be deleted
                 if (!path->IsStale()) {
-                    return;
+                    continue;
                 }
 
                 // Fall through to delete case as the path is still stale
@@ -333,17 +344,14 @@ void PeerCloseManager::ProcessRibIn(DBTablePartBase *root, BgpRoute *rt,
 
             case MembershipRequest::RIBIN_STALE:
 
-                // This path must be marked for staling. Update the local
-                // preference and update the route accordingly
-                oper = DBRequest::DB_ENTRY_ADD_CHANGE;
-
-                // Update attrs with maximum local preference so that this path
-                // is least preferred
-                // TODO: Check for the right local-pref value to use
-                attrs = peer_->server()->attr_db()->\
-                        ReplaceLocalPreferenceAndLocate(path->GetAttr(), 1);
-                path->SetStale();
-                break;
+                // Mark the path stale in place. Its attributes do not change,
+                // so there is nothing to notify and the path keeps forwarding
+                // until it is either learned again or swept.
+                if (!path->IsStale()) {
+                    path->SetStale();
+                    stale_path_count_++;
+                }
+                continue;
 
             default:
                 return;
@@ -5,6 +5,7 @@
 #ifndef __BGP_PEER_CLOSE_H__
 #define __BGP_PEER_CLOSE_H__
 
+#include <tbb/atomic.h>
 #include <tbb/recursive_mutex.h>
 
 #include "base/timer.h"
@@ -55,6 +56,11 @@ public:
                       int action_mask);
     bool IsCloseInProgress();
 
+    // Number of paths of this peer marked stale that are not yet learned
+    // again or deleted. Updated from the db partition tasks.
+    int stale_path_count() const { return stale_path_count_; }
+    void UpdateStalePathCount(int count) { stale_path_count_ += count; }
+
 private:
     friend class PeerCloseManagerTest;
 
@@ -67,6 +73,7 @@ private:
     Timer *stale_timer_;
     bool stale_timer_running_;
     bool start_stale_timer_;
+    tbb::atomic<int> stale_path_count_;
     tbb::recursive_mutex mutex_;
 };
 
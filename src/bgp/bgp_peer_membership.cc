@@ -320,6 +320,8 @@ void IPeerRib::ManagedDelete() {
 //
 PeerRibMembershipManager::PeerRibMembershipManager(BgpServer *server) :
         server_(server) {
+    walk_count_ = 0;
+    walk_request_count_ = 0;
     if (membership_task_id_ == -1) {
         TaskScheduler *scheduler = TaskScheduler::GetInstance();
         membership_task_id_ = scheduler->GetTaskId("bgp::PeerMembership");
@@ -341,25 +343,124 @@ PeerRibMembershipManager::~PeerRibMembershipManager() {
 //
 // Concurrency: Runs in the context of the BGP peer membership task.
 //
-// Start the process to join the Ipeer to the BgpTable. This consists mainly
-// of starting a table walk so that all existing routes can be advertised to
-// the IPeer.
+// Start a table walk to join and/or leave the IPeers in the lists to the
+// BgpTable. Either list may be NULL. A combined walk leaves each route for
+// the peers that are unregistering before joining it for the peers that are
+// registering.
 //
-// Assumes that the IPeer is already registered with the BgpTable.
-//
-void PeerRibMembershipManager::Join(BgpTable *table,
-                                    MembershipRequestList *request_list) {
+void PeerRibMembershipManager::Walk(BgpTable *table,
+                                    MembershipRequestList *join_list,
+                                    MembershipRequestList *leave_list) {
     DB *db = table->database();
     DBTableWalker *walker = db->GetWalker();
 
+    walk_count_++;
+    if (join_list) {
+        join_walk_set_.insert(table);
+        walk_request_count_ += join_list->size();
+    }
+    if (leave_list) {
+        leave_walk_set_.insert(table);
+        walk_request_count_ += leave_list->size();
+    }
+
     walker->WalkTable(table, NULL,
         // _1: DBTablePartition, _2: DBEntry
-        boost::bind(&PeerRibMembershipManager::RouteJoin, this, _1, _2, table,
-                    request_list),
+        boost::bind(&PeerRibMembershipManager::RouteWalk, this, _1, _2, table,
+                    join_list, leave_list),
 
         // _1: DBTablePartition
-        boost::bind(&PeerRibMembershipManager::JoinDone, this, _1,
-                    request_list));
+        boost::bind(&PeerRibMembershipManager::WalkDone, this, _1,
+                    join_list, leave_list));
+}
+
+//
+// Concurrency: Runs in the context of the db walker task triggered from
+// BGP peer membership task.
+//
+bool PeerRibMembershipManager::RouteWalk(DBTablePartBase *root,
+                                         DBEntryBase *db_entry, BgpTable *table,
+                                         MembershipRequestList *join_list,
+                                         MembershipRequestList *leave_list) {
+    if (leave_list) {
+        RouteLeave(root, db_entry, table, leave_list);
+    }
+    if (join_list) {
+        RouteJoin(root, db_entry, table, join_list);
+    }
+    return true;
+}
+
+//
+// Concurrency: Runs in the context of the DB partition task.
+//
+// Process the table walk done notification from the DB infrastructure. This
+// table walk was started from the Walk method.
+//
+void PeerRibMembershipManager::WalkDone(DBTableBase *db,
+                                        MembershipRequestList *join_list,
+                                        MembershipRequestList *leave_list) {
+    if (join_list) {
+        JoinDone(db, join_list);
+    }
+    if (leave_list) {
+        LeaveDone(db, leave_list);
+    }
+}
+
+//
+// Concurrency: Runs in the context of the BGP peer membership task.
+//
+// Prepare to join the IPeers to the BgpTable. This creates the IPeerRibs and
+// registers their RibIn and RibOut. The join itself consists mainly of a
+// table walk so that all existing routes can be advertised to the IPeers.
+//
+void PeerRibMembershipManager::PrepareJoin(BgpTable *table,
+                                    MembershipRequestList *request_list) {
+    //
+    // Iterate through each request and prepare for walk
+    //
+    for (MembershipRequestList::iterator iter =
+            request_list->begin(); iter != request_list->end(); iter++) {
+        MembershipRequest *request = iter.operator->();
+        IPeerRib *peer_rib = IPeerRibFind(request->ipeer, table);
+
+        assert(request->action_mask != MembershipRequest::INVALID);
+
+        if (!peer_rib) {
+            peer_rib = IPeerRibInsert(request->ipeer, table);
+            if (request->instance_id > 0) {
+                peer_rib->set_instance_id(request->instance_id);
+            }
+        }
+
+        //
+        // Peer has registered to this table. Reset the stale flag
+        //
+        if (peer_rib->IsStale()) {
+            peer_rib->ResetStale();
+        }
+
+        BGP_LOG_TABLE_PEER(peer_rib->ipeer(), SandeshLevel::SYS_DEBUG,
+                           BGP_LOG_FLAG_SYSLOG, peer_rib->table(),
+                           "Register routing-table for " <<
+                               MembershipRequest::ActionMaskToString(
+                                   request->action_mask));
+
+        //
+        // Register RibOut if requested
+        //
+        if (request->action_mask & MembershipRequest::RIBOUT_ADD) {
+            peer_rib->RegisterRibOut(request->policy);
+        }
+
+        //
+        // Register RibIn if requested
+        //
+        if (request->action_mask & MembershipRequest::RIBIN_ADD) {
+            peer_rib->RegisterRibIn();
+        }
+    }
 }
 
 //
@@ -368,7 +469,7 @@ void PeerRibMembershipManager::Join(BgpTable *table,
 //
 // Handle RibIna and RibOut join for a particular prefix to a set of peers
 //
-bool PeerRibMembershipManager::RouteJoin(DBTablePartBase *root,
+void PeerRibMembershipManager::RouteJoin(DBTablePartBase *root,
                                          DBEntryBase *db_entry, BgpTable *table,
                                          MembershipRequestList *request_list) {
 
@@ -388,15 +489,12 @@ bool PeerRibMembershipManager::RouteJoin(DBTablePartBase *root,
             peer_rib->RibOutJoin(root, db_entry, table, request->action_mask);
         }
     }
-
-    return true;
 }
 
 //
 // Concurrency: Runs in the context of the DB partition task.
 //
-// Process the table walk done notification from the DB infrastructure. This
-// table walk was started from the Join method.
+// The walk for a set of peer registration requests is complete.
 //
 void PeerRibMembershipManager::JoinDone(DBTableBase *db,
                                         MembershipRequestList *request_list) {
@@ -411,45 +509,57 @@ void PeerRibMembershipManager::JoinDone(DBTableBase *db,
 //
 // Concurrency: Runs in the context of the BGP peer membership task.
 //
-// Kick off the process to unregister the IPeer from the BgpTable. We first
-// need to do a table walk and clean up state for all routes from the IPeer.
-// We can actually unregister only after the state has been cleaned up.
+// Prepare to unregister the IPeers from the BgpTable. We first need to do a
+// table walk and clean up state for all routes from the IPeers. We can
+// actually unregister only after the state has been cleaned up.
 //
-// In the meantime, we deactivate the IPeer in the RibOut to ensure that it
-// does not export any more routes.
+// In the meantime, we deactivate the IPeers in the RibOut to ensure that
+// they do not export any more routes.
 //
-void PeerRibMembershipManager::Leave(BgpTable *table,
-                              MembershipRequestList *request_list) {
-
-    DB *db = table->database();
+// Returns false if none of the IPeers is registered, in which case there is
+// no need for a walk.
+//
+bool PeerRibMembershipManager::PrepareLeave(BgpTable *table,
+                                     MembershipRequestList *request_list) {
+    bool walk = false;
 
-    for (MembershipRequestList::iterator iter = request_list->begin();
-             iter != request_list->end(); iter++) {
+    //
+    // Iterate through each request and prepare for walk
+    //
+    for (MembershipRequestList::iterator iter =
+            request_list->begin(); iter != request_list->end(); iter++) {
         MembershipRequest *request = iter.operator->();
+        IPeerRib *peer_rib = IPeerRibFind(request->ipeer, table);
+        if (!peer_rib) continue;
 
-        if (!(request->action_mask & MembershipRequest::RIBOUT_DELETE)) {
+        //
+        // A request that has nothing to do on the routes and leaves the
+        // peer_rib in place needs no walk
+        //
+        if (request->action_mask == MembershipRequest::INVALID &&
+            (peer_rib->IsRibInRegistered() ||
+             peer_rib->IsRibOutRegistered())) {
             continue;
         }
+        walk = true;
 
-        IPeerRib *peer_rib = IPeerRibFind(request->ipeer, table);
-
-        if (peer_rib) {
+        BGP_LOG_TABLE_PEER(peer_rib->ipeer(), SandeshLevel::SYS_DEBUG,
+                           BGP_LOG_FLAG_SYSLOG, peer_rib->table(),
+                           "Unregister routing-table for " <<
+                               MembershipRequest::ActionMaskToString(
+                                   request->action_mask));
 
-            // 
-            // Ignore peer ribs which are already in close process
-            //
-            if (peer_rib->IsRibOutActive()) peer_rib->DeactivateRibOut();
+        if (!(request->action_mask & MembershipRequest::RIBOUT_DELETE)) {
+            continue;
         }
+
+        // 
+        // Ignore peer ribs which are already in close process
+        //
+        if (peer_rib->IsRibOutActive()) peer_rib->DeactivateRibOut();
     }
 
-    DBTableWalker *walker = db->GetWalker();
-    walker->WalkTable(table, NULL,
-        // _1: DBTablePartBase, _2: DBEntry
-        boost::bind(&PeerRibMembershipManager::RouteLeave, this, _1, _2, table,
-                    request_list),
-        // _1: DBTableBase
-        boost::bind(&PeerRibMembershipManager::LeaveDone, this, _1,
-                    request_list));
+    return walk;
 }
 
 //
@@ -458,7 +568,7 @@ void PeerRibMembershipManager::Leave(BgpTable *table,
 //
 // Leave the route from RibIn and from RibOut
 //
-bool PeerRibMembershipManager::RouteLeave(DBTablePartBase *root,
+void PeerRibMembershipManager::RouteLeave(DBTablePartBase *root,
                                           DBEntryBase *db_entry,
                                           BgpTable *table,
                                           MembershipRequestList *request_list) {
@@ -473,29 +583,13 @@ bool PeerRibMembershipManager::RouteLeave(DBTablePartBase *root,
         peer_rib->RibOutLeave(root, db_entry, table, request->action_mask);
         peer_rib->RibInLeave(root, db_entry, table, request->action_mask);
     }
-    return true;
-}
-
-void PeerRibMembershipManager::MembershipRequestListDebug(
-    const char *function, int line, BgpTable *table,
-    MembershipRequestList *request_list) {
-
-    std::ostringstream ostream;
-
-    ostream << "";
-    for (MembershipRequestList::iterator iter = (request_list)->begin();
-            iter != (request_list)->end(); iter++) {
-        MembershipRequest *request = iter.operator->();
-        ostream << request->ipeer->ToString() << ", ";
-    }
 }
 
 //
 // Concurrency: Runs in the context of the DB partition task.
 //
-// Process the table walk done notification from the DB infrastructure.  This
-// walk was started from the Leave method. Since the table walk is complete,
-// we can post an IPeerRib UNREGISTER_RIB event for the BGP peer membership
+// The walk for a set of peer unregistration requests is complete, so we can
+// post an IPeerRib UNREGISTER_RIB_COMPLETE event for the BGP peer membership
 // task.
 //
 void PeerRibMembershipManager::LeaveDone(DBTableBase *db,
@@ -508,6 +602,54 @@ void PeerRibMembershipManager::LeaveDone(DBTableBase *db,
     Enqueue(event);
 }
 
+//
+// Concurrency: Runs in the context of the BGP peer membership task.
+//
+// Take the requests of the other kind that are pending for the table so that
+// the walk being started serves them too. This is not possible if a walk for
+// them is already in progress, or if they involve any of the peers in the
+// request_list, since the join and leave of a peer must not be reordered.
+//
+MembershipRequestList *PeerRibMembershipManager::TakePendingRequests(
+        TableMembershipRequestMap *request_map, const TableWalkSet &walk_set,
+        BgpTable *table, const MembershipRequestList *request_list) {
+    if (walk_set.find(table) != walk_set.end())
+        return NULL;
+    TableMembershipRequestMap::iterator it = request_map->find(table);
+    if (it == request_map->end() || !it->second)
+        return NULL;
+
+    std::set<const IPeer *> peers;
+    for (MembershipRequestList::const_iterator iter = request_list->begin();
+         iter != request_list->end(); ++iter) {
+        peers.insert(iter->ipeer);
+    }
+    MembershipRequestList *pending = it->second;
+    for (MembershipRequestList::const_iterator iter = pending->begin();
+         iter != pending->end(); ++iter) {
+        if (peers.find(iter->ipeer) != peers.end())
+            return NULL;
+    }
+
+    // The event posted for these requests finds nothing left to do.
+    it->second = NULL;
+    return pending;
+}
+
+void PeerRibMembershipManager::MembershipRequestListDebug(
+    const char *function, int line, BgpTable *table,
+    MembershipRequestList *request_list) {
+
+    std::ostringstream ostream;
+
+    ostream << "";
+    for (MembershipRequestList::iterator iter = (request_list)->begin();
+            iter != (request_list)->end(); iter++) {
+        MembershipRequest *request = iter.operator->();
+        ostream << request->ipeer->ToString() << ", ";
+    }
+}
+
 //
 // Process Register/Unregister request for a peer with a particular rib
 //
@@ -787,6 +929,30 @@ void PeerRibMembershipManager::FillPeerMembershipInfo(const IPeer *peer,
     if (table_list.size()) resp.set_routing_tables(table_list);
 }
 
+size_t PeerRibMembershipManager::GetPendingRequestCount() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    size_t count = 0;
+    for (TableMembershipRequestMap::const_iterator it =
+         register_request_map_.begin(); it != register_request_map_.end();
+         ++it) {
+        if (it->second) count += it->second->size();
+    }
+    for (TableMembershipRequestMap::const_iterator it =
+         unregister_request_map_.begin(); it != unregister_request_map_.end();
+         ++it) {
+        if (it->second) count += it->second->size();
+    }
+    return count;
+}
+
+void PeerRibMembershipManager::FillMembershipStats(
+        PeerMembershipStats *stats) {
+    stats->set_queue_depth(event_queue_->QueueCount());
+    stats->set_pending_requests(GetPendingRequestCount());
+    stats->set_walks(walk_count_);
+    stats->set_walk_requests(walk_request_count_);
+}
+
 void PeerRibMembershipManager::FillRegisteredTable(IPeer *peer, 
                                                std::vector<std::string> &list) {
     IPeerRib peer_rib(peer, NULL, this);
@@ -869,55 +1035,24 @@ void PeerRibMembershipManager::ProcessRegisterRibEvent(BgpTable *table,
         return;
     }
 
+    PrepareJoin(table, request_list);
+
     //
-    // Iterate through each request and prepare for walk
+    // Serve the pending unregister requests of other peers in the same walk
     //
-    for (MembershipRequestList::iterator iter =
-            request_list->begin(); iter != request_list->end(); iter++) {
-        MembershipRequest *request = iter.operator->();
-        IPeerRib *peer_rib = IPeerRibFind(request->ipeer, table);
-
-        assert(request->action_mask != MembershipRequest::INVALID);
-
-        if (!peer_rib) {
-            peer_rib = IPeerRibInsert(request->ipeer, table);
-            if (request->instance_id > 0) {
-                peer_rib->set_instance_id(request->instance_id);
-            }
-        }
-
-        //
-        // Peer has registered to this table. Reset the stale flag
-        //
-        if (peer_rib->IsStale()) {
-            peer_rib->ResetStale();
-        }
-
-        BGP_LOG_TABLE_PEER(peer_rib->ipeer(), SandeshLevel::SYS_DEBUG,
-                           BGP_LOG_FLAG_SYSLOG, peer_rib->table(),
-                           "Register routing-table for " <<
-                               MembershipRequest::ActionMaskToString(
-                                   request->action_mask));
-
-        //
-        // Register RibOut if requested
-        //
-        if (request->action_mask & MembershipRequest::RIBOUT_ADD) {
-            peer_rib->RegisterRibOut(request->policy);
-        }
-
-        //
-        // Register RibIn if requested
-        //
-        if (request->action_mask & MembershipRequest::RIBIN_ADD) {
-            peer_rib->RegisterRibIn();
-        }
+    MembershipRequestList *leave_list = TakePendingRequests(
+        &unregister_request_map_, leave_walk_set_, table, request_list);
+    if (leave_list && !PrepareLeave(table, leave_list)) {
+        NotifyCompletion(table, leave_list);
+        delete leave_list;
+        unregister_request_map_.erase(table);
+        leave_list = NULL;
     }
 
     //
     // Start off a walk to process this list of peer registration requests
     //
-    Join(table, request_list);
+    Walk(table, request_list, leave_list);
 }
 
 
@@ -943,41 +1078,37 @@ void PeerRibMembershipManager::ProcessRegisterRibCompleteEvent(
 //
 void PeerRibMembershipManager::ProcessUnregisterRibEvent(BgpTable *table,
                                    MembershipRequestList *request_list) {
-    bool complete = true;
-
-    //
-    // Iterate through each request and prepare for walk
-    //
-    for (MembershipRequestList::iterator iter =
-            request_list->begin(); iter != request_list->end(); iter++) {
-        MembershipRequest *request = iter.operator->();
-        IPeerRib *peer_rib = IPeerRibFind(request->ipeer, table);
-        if (!peer_rib) continue;
-        complete = false;
-
-        BGP_LOG_TABLE_PEER(peer_rib->ipeer(), SandeshLevel::SYS_DEBUG,
-                           BGP_LOG_FLAG_SYSLOG, peer_rib->table(),
-                           "Unregister routing-table for " <<
-                               MembershipRequest::ActionMaskToString(
-                                   request->action_mask));
-    }
-
     //
     // If there is no walk necessary, inform the caller
     //
-    if (complete) {
+    if (!PrepareLeave(table, request_list)) {
 
         // Notify
         NotifyCompletion(table, request_list);
         delete request_list;
         unregister_request_map_.erase(table);
-    } else {
+        return;
+    }
 
-        //
-        // Kick off the db walk to start the leave process
-        //
-        Leave(table, request_list);
+    //
+    // Serve the pending register requests of other peers in the same walk
+    //
+    MembershipRequestList *join_list = TakePendingRequests(
+        &register_request_map_, join_walk_set_, table, request_list);
+    if (join_list) {
+        if (table->IsDeleted()) {
+            register_request_map_.erase(table);
+            delete join_list;
+            join_list = NULL;
+        } else {
+            PrepareJoin(table, join_list);
+        }
     }
+
+    //
+    // Kick off the db walk to start the leave process
+    //
+    Walk(table, join_list, request_list);
 }
 
 //
@@ -1049,8 +1180,13 @@ void PeerRibMembershipManager::IPeerRibEventCallbackUnlocked(
     case IPeerRibEvent::REGISTER_RIB:
 
         // Retrieve the the list of requests from the map, for this event's
-        // specific table
+        // specific table. The requests may already have been served by a
+        // walk started for unregister requests, or be waiting for one.
         map_iter = register_request_map_.find(event->table);
+        if (map_iter == register_request_map_.end() || !map_iter->second ||
+            join_walk_set_.count(event->table)) {
+            break;
+        }
         request_list = map_iter->second;
         map_iter->second = NULL;
         ProcessRegisterRibEvent(event->table, request_list);
@@ -1058,9 +1194,12 @@ void PeerRibMembershipManager::IPeerRibEventCallbackUnlocked(
 
     case IPeerRibEvent::REGISTER_RIB_COMPLETE:
         ProcessRegisterRibCompleteEvent(event);
+        join_walk_set_.erase(event->table);
 
         // Check if there are any new registrations pending
         map_iter = register_request_map_.find(event->table);
+        if (map_iter == register_request_map_.end())
+            break;
         request_list = map_iter->second;
         if (!request_list) {
             register_request_map_.erase(event->table);
@@ -1074,6 +1213,10 @@ void PeerRibMembershipManager::IPeerRibEventCallbackUnlocked(
 
         // Check if there are any new registrations pending
         map_iter = unregister_request_map_.find(event->table);
+        if (map_iter == unregister_request_map_.end() || !map_iter->second ||
+            leave_walk_set_.count(event->table)) {
+            break;
+        }
         request_list = map_iter->second;
         map_iter->second = NULL;
         ProcessUnregisterRibEvent(event->table, request_list);
@@ -1083,9 +1226,12 @@ void PeerRibMembershipManager::IPeerRibEventCallbackUnlocked(
 
         // Unregistration for a set of peers from a rib is complete
         ProcessUnregisterRibCompleteEvent(event);
+        leave_walk_set_.erase(event->table);
 
         // Check if there are any new registrations pending
         map_iter = unregister_request_map_.find(event->table);
+        if (map_iter == unregister_request_map_.end())
+            break;
         request_list = map_iter->second;
         if (!request_list) {
             unregister_request_map_.erase(event->table);
@@ -7,6 +7,8 @@
 
 #include <set>
 
+#include <tbb/atomic.h>
+
 #include "base/lifetime.h"
 #include "base/util.h"
 #include "base/queue_task.h"
@@ -21,6 +23,7 @@ class PeerRibMembershipManager;
 class RibOut;
 class ShowRoutingInstanceTable;
 class BgpNeighborResp;
+class PeerMembershipStats;
 
 struct MembershipRequest {
 public:
@@ -188,6 +191,10 @@ struct IPeerRibCompare {
 // spreading it out over multiple IPeers or BgpTables, makes it possible to
 // optimize regsiter/unregister processing in future.
 //
+// Requests for a table are batched while a walk of the table is pending or
+// in progress. Register and unregister requests for different peers that are
+// pending for the same table are served by a single walk.
+//
 class PeerRibMembershipManager {
 public:
     typedef std::set<IPeerRib *, IPeerRibCompare> PeerRibSet;
@@ -226,23 +233,43 @@ public:
     bool IsQueueEmpty() { return event_queue_->IsQueueEmpty(); }
     void FillRegisteredTable(IPeer *peer, std::vector<std::string> &list);
 
+    // Requests waiting for a table walk, across all tables
+    size_t GetPendingRequestCount();
+    // Table walks started and the requests served by them
+    uint64_t walk_count() const { return walk_count_; }
+    uint64_t walk_request_count() const { return walk_request_count_; }
+    void FillMembershipStats(PeerMembershipStats *stats);
+
 private:
     friend class PeerMembershipMgrTest;
     friend class PeerRibMembershipManagerTest;
 
     typedef std::multimap<const BgpTable *, IPeer *> RibPeerMap;
     typedef std::multimap<const IPeer *, IPeerRib *> PeerRibMap;
-
-    void Join(BgpTable *table, MembershipRequestList *request_list);
-    bool RouteJoin(DBTablePartBase *root, DBEntryBase *db_entry,
+    typedef std::set<BgpTable *> TableWalkSet;
+
+    void Walk(BgpTable *table, MembershipRequestList *join_list,
+              MembershipRequestList *leave_list);
+    bool RouteWalk(DBTablePartBase *root, DBEntryBase *db_entry,
+                   BgpTable *table, MembershipRequestList *join_list,
+                   MembershipRequestList *leave_list);
+    void WalkDone(DBTableBase *db, MembershipRequestList *join_list,
+                  MembershipRequestList *leave_list);
+
+    void PrepareJoin(BgpTable *table, MembershipRequestList *request_list);
+    void RouteJoin(DBTablePartBase *root, DBEntryBase *db_entry,
                    BgpTable *table, MembershipRequestList *request_list);
     void JoinDone(DBTableBase *db, MembershipRequestList *request_list);
 
-    void Leave(BgpTable *table, MembershipRequestList *request_list);
-    bool RouteLeave(DBTablePartBase *root, DBEntryBase *db_entry,
+    bool PrepareLeave(BgpTable *table, MembershipRequestList *request_list);
+    void RouteLeave(DBTablePartBase *root, DBEntryBase *db_entry,
                     BgpTable *table, MembershipRequestList *request_list);
     void LeaveDone(DBTableBase *db, MembershipRequestList *request_list);
 
+    MembershipRequestList *TakePendingRequests(
+        TableMembershipRequestMap *request_map, const TableWalkSet &walk_set,
+        BgpTable *table, const MembershipRequestList *request_list);
+
     IPeerRibEvent *ProcessRequest(IPeerRibEvent::EventType event_type,
                                   BgpTable *table,
                                   const MembershipRequest &request);
@@ -277,8 +304,14 @@ private:
 
     TableMembershipRequestMap register_request_map_;
     TableMembershipRequestMap unregister_request_map_;
+    // Tables with a walk in progress for register/unregister requests
+    TableWalkSet join_walk_set_;
+    TableWalkSet leave_walk_set_;
     tbb::mutex mutex_;
 
+    tbb::atomic<uint64_t> walk_count_;
+    tbb::atomic<uint64_t> walk_request_count_;
+
     DISALLOW_COPY_AND_ASSIGN(PeerRibMembershipManager);
 };
 
@@ -4,6 +4,8 @@
 
 #include "bgp/bgp_proto.h"
 
+#include <string.h>
+
 #include "base/proto.h"
 #include "base/logging.h"
 #include "bgp/bgp_common.h"
@@ -203,13 +205,14 @@ int BgpProto::Update::Validate(const BgpPeer *peer, std::string &data) {
 
     BGP_LOG_PEER(peer, SandeshLevel::SYS_DEBUG, BGP_LOG_FLAG_TRACE,
                  BGP_PEER_DIR_IN, rxed_attr);
-    if (nlri.size() > 0 && !nh) {
+    bool has_nlri = (nlri.size() > 0 || !raw_nlri.empty());
+    if (has_nlri && !nh) {
         // next-hop attribute must be present if IPv4 NLRI is present
         char attrib_type = BgpAttribute::NextHop;
         data = std::string(&attrib_type, 1);
         return BgpProto::Notification::MissingWellKnownAttrib;
     }
-    if (nlri.size() > 0 || mp_reach_nlri) {
+    if (has_nlri || mp_reach_nlri) {
         // origin and as_path must be present if any NLRI is present
         if (!origin) {
             char attrib_type = BgpAttribute::Origin;
@@ -1113,6 +1116,130 @@ BgpProto::BgpMessage *BgpProto::Decode(const uint8_t *data, size_t size,
     return static_cast<BgpMessage *>(context.release());
 }
 
+// Families whose MP NLRI DecodeUpdate keeps in wire format.
+static bool IsRawNlriFamily(uint16_t afi, uint8_t safi) {
+    return (((afi == BgpAf::IPv4) && (safi == BgpAf::Unicast)) ||
+            ((afi == BgpAf::IPv4) && (safi == BgpAf::Vpn)) ||
+            ((afi == BgpAf::L2Vpn) && (safi == BgpAf::EVpn)));
+}
+
+//
+// Decode a MP reach/unreach attribute of one of the raw NLRI families.
+// Returns NULL for any other attribute, or if the attribute is malformed,
+// which leaves it to the generic decoder.
+//
+static BgpMpNlri *DecodeRawMpNlri(uint8_t flags, uint8_t code,
+                                  const uint8_t *value, size_t len) {
+    if (code != BgpAttribute::MPReachNlri &&
+        code != BgpAttribute::MPUnreachNlri) {
+        return NULL;
+    }
+    if (len < 3)
+        return NULL;
+    uint16_t afi = get_value(value, 2);
+    uint8_t safi = value[2];
+    if (!IsRawNlriFamily(afi, safi))
+        return NULL;
+
+    const uint8_t *nexthop = value + 3;
+    size_t nexthop_len = 0;
+    size_t offset = 3;
+    if (code == BgpAttribute::MPReachNlri) {
+        if (len < 5)
+            return NULL;
+        nexthop_len = value[3];
+        nexthop = value + 4;
+        // Skip the nexthop and the reserved octet.
+        offset = 4 + nexthop_len + 1;
+        if (offset > len)
+            return NULL;
+    }
+    bool evpn = (afi == BgpAf::L2Vpn && safi == BgpAf::EVpn);
+    if (!BgpProtoPrefixReader::Validate(value + offset, len - offset, evpn))
+        return NULL;
+
+    BgpMpNlri *mp_nlri = new BgpMpNlri(
+        static_cast<BgpAttribute::Code>(code), afi, safi);
+    mp_nlri->flags = flags;
+    mp_nlri->nexthop.assign(nexthop, nexthop + nexthop_len);
+    mp_nlri->raw_nlri.assign(value + offset, value + len);
+    return mp_nlri;
+}
+
+//
+// The message is split into its path attributes, which go through the
+// generic decoder in a copy of the message without any prefixes, and its
+// prefixes, which are copied out in wire format.
+//
+BgpProto::Update *BgpProto::DecodeUpdate(const uint8_t *data, size_t size) {
+    const size_t header_size = kMinMessageSize;
+    if (size < header_size + 4 || size > (size_t) kMaxMessageSize)
+        return NULL;
+    if (data[header_size - 1] != UPDATE ||
+        (size_t) get_value(data + header_size - 3, 2) != size)
+        return NULL;
+
+    const uint8_t *end = data + size;
+    size_t withdrawn_len = get_value(data + header_size, 2);
+    const uint8_t *withdrawn = data + header_size + 2;
+    if (withdrawn + withdrawn_len + 2 > end)
+        return NULL;
+    size_t attr_len = get_value(withdrawn + withdrawn_len, 2);
+    const uint8_t *attr = withdrawn + withdrawn_len + 2;
+    const uint8_t *attr_end = attr + attr_len;
+    if (attr_end > end)
+        return NULL;
+    if (!BgpProtoPrefixReader::Validate(withdrawn, withdrawn_len, false) ||
+        !BgpProtoPrefixReader::Validate(attr_end, end - attr_end, false))
+        return NULL;
+
+    uint8_t buffer[kMaxMessageSize];
+    memcpy(buffer, data, header_size);
+    put_value(buffer + header_size, 2, 0);
+    uint8_t *ptr = buffer + header_size + 4;
+
+    vector<BgpMpNlri *> mp_nlri_list;
+    for (const uint8_t *cp = attr; cp < attr_end; ) {
+        if (cp + 3 > attr_end) {
+            STLDeleteValues(&mp_nlri_list);
+            return NULL;
+        }
+        uint8_t flags = cp[0];
+        uint8_t code = cp[1];
+        size_t hdr_len = (flags & BgpAttribute::ExtendedLength) ? 4 : 3;
+        size_t len = (hdr_len == 4) ? get_value(cp + 2, 2) : cp[2];
+        if (cp + hdr_len > attr_end || cp + hdr_len + len > attr_end) {
+            STLDeleteValues(&mp_nlri_list);
+            return NULL;
+        }
+
+        BgpMpNlri *mp_nlri = DecodeRawMpNlri(flags, code, cp + hdr_len, len);
+        if (mp_nlri) {
+            mp_nlri_list.push_back(mp_nlri);
+        } else {
+            memcpy(ptr, cp, hdr_len + len);
+            ptr += hdr_len + len;
+        }
+        cp += hdr_len + len;
+    }
+    put_value(buffer + header_size + 2, 2, ptr - (buffer + header_size + 4));
+    put_value(buffer + header_size - 3, 2, ptr - buffer);
+
+    BgpMessage *msg = Decode(buffer, ptr - buffer);
+    if (msg == NULL || msg->type != UPDATE) {
+        delete msg;
+        STLDeleteValues(&mp_nlri_list);
+        return NULL;
+    }
+
+    Update *update = static_cast<Update *>(msg);
+    update->raw_withdrawn_routes.assign(withdrawn, withdrawn + withdrawn_len);
+    update->raw_nlri.assign(attr_end, end);
+    update->path_attributes.insert(update->path_attributes.end(),
+                                   mp_nlri_list.begin(), mp_nlri_list.end());
+    return update;
+}
+
 int BgpProto::Encode(const BgpMessage *msg, uint8_t *data, size_t size,
                      EncodeOffsets *offsets) {
     EncodeContext ctx;
@@ -1137,3 +1264,48 @@ int BgpProto::Encode(const BgpMpNlri *msg, uint8_t *data, size_t size,
     }
     return result;
 }
+
+BgpProtoPrefixReader::BgpProtoPrefixReader(
+        const vector<BgpProtoPrefix *> &prefixes, const vector<uint8_t> &raw,
+        bool evpn)
+    : prefixes_(prefixes), raw_(raw), evpn_(evpn), index_(0), offset_(0) {
+}
+
+const BgpProtoPrefix *BgpProtoPrefixReader::Next() {
+    if (index_ < prefixes_.size())
+        return prefixes_[index_++];
+    if (offset_ >= raw_.size())
+        return NULL;
+
+    const uint8_t *data = &raw_[offset_];
+    size_t len;
+    if (evpn_) {
+        prefix_.type = data[0];
+        len = data[1];
+        prefix_.prefixlen = len * 8;
+        data += 2;
+        offset_ += 2 + len;
+    } else {
+        prefix_.prefixlen = data[0];
+        len = (prefix_.prefixlen + 7) / 8;
+        data += 1;
+        offset_ += 1 + len;
+    }
+    prefix_.prefix.assign(data, data + len);
+    return &prefix_;
+}
+
+bool BgpProtoPrefixReader::Validate(const uint8_t *data, size_t size,
+                                    bool evpn) {
+    size_t offset = 0;
+    while (offset < size) {
+        if (evpn) {
+            if (offset + 2 > size)
+                return false;
+            offset += 2 + data[offset + 1];
+        } else {
+            offset += 1 + (data[offset] + 7) / 8;
+        }
+    }
+    return offset == size;
+}
@@ -285,6 +285,10 @@ public:
         std::vector <BgpProtoPrefix *> withdrawn_routes;
         std::vector <BgpAttribute *> path_attributes;
         std::vector <BgpProtoPrefix *> nlri;
+        // Withdrawn routes and NLRI in wire format, as left undecoded by
+        // DecodeUpdate. Use BgpProtoPrefixReader to walk both forms.
+        std::vector<uint8_t> raw_withdrawn_routes;
+        std::vector<uint8_t> raw_nlri;
         static int EncodeData(Update *msg, uint8_t *data, size_t size);
     };
 
@@ -294,6 +298,13 @@ public:
     static BgpMessage *Decode(const uint8_t *data, size_t size,
                               ParseErrorContext *ec = NULL);
 
+    // Decode an UPDATE message without building an object per prefix. The
+    // path attributes are decoded as usual but the withdrawn routes, the
+    // NLRI and the MP reach/unreach NLRI of the supported families are kept
+    // in wire format. Returns NULL if the message is not a well formed
+    // UPDATE, in which case Decode reports the error.
+    static Update *DecodeUpdate(const uint8_t *data, size_t size);
+
     static int Encode(const BgpMessage *msg, uint8_t *data, size_t size,
                       EncodeOffsets *offsets = NULL);
     static int Encode(const BgpMpNlri *msg, uint8_t *data, size_t size,
@@ -302,4 +313,29 @@ public:
 private:    
 };
 
+//
+// Walks the prefixes of an UPDATE, first the decoded ones and then those
+// left in wire format. The prefixes read from the wire format reuse the
+// same BgpProtoPrefix, which is only valid until the next call to Next.
+//
+class BgpProtoPrefixReader {
+public:
+    BgpProtoPrefixReader(const std::vector<BgpProtoPrefix *> &prefixes,
+                         const std::vector<uint8_t> &raw, bool evpn);
+
+    // Returns NULL when all prefixes have been read.
+    const BgpProtoPrefix *Next();
+
+    // Checks that the wire format data holds a whole number of prefixes.
+    static bool Validate(const uint8_t *data, size_t size, bool evpn);
+
+private:
+    const std::vector<BgpProtoPrefix *> &prefixes_;
+    const std::vector<uint8_t> &raw_;
+    bool evpn_;
+    size_t index_;
+    size_t offset_;
+    BgpProtoPrefix prefix_;
+};
+
 #endif
@@ -53,29 +53,74 @@ bool RibExportPolicy::operator<(const RibExportPolicy &rhs) const {
     return false;
 }
 
-RibOutAttr::RibOutAttr(const BgpAttr *attr, uint32_t label) : attr_out_(attr) {
+std::size_t hash_value(RibOutAttr::NextHop const &nexthop) {
+    size_t hash = 0;
+    if (nexthop.address_.is_v4()) {
+        boost::hash_combine(hash, nexthop.address_.to_v4().to_ulong());
+    } else {
+        Ip6Address::bytes_type bytes = nexthop.address_.to_v6().to_bytes();
+        boost::hash_range(hash, bytes.begin(), bytes.end());
+    }
+    boost::hash_combine(hash, nexthop.label_);
+    boost::hash_range(hash, nexthop.encap_.begin(), nexthop.encap_.end());
+    return hash;
+}
+
+void RibOutAttrData::Remove() {
+    db_->Delete(this);
+}
+
+int RibOutAttrData::CompareTo(const RibOutAttrData &rhs) const {
+    KEY_COMPARE(attr_.get(), rhs.attr_.get());
+    KEY_COMPARE(nexthop_list_.size(), rhs.nexthop_list_.size());
+    for (size_t i = 0; i < nexthop_list_.size(); i++) {
+        int cmp = nexthop_list_[i].CompareTo(rhs.nexthop_list_[i]);
+        if (cmp) {
+            return cmp;
+        }
+    }
+    return 0;
+}
+
+std::size_t hash_value(RibOutAttrData const &data) {
+    size_t hash = 0;
+    boost::hash_combine(hash, data.attr_.get());
+    boost::hash_range(hash, data.nexthop_list_.begin(),
+                      data.nexthop_list_.end());
+    return hash;
+}
+
+RibOutAttrDB *RibOutAttrDB::GetInstance() {
+    // Never deleted, as RibOutAttrs may outlive static destructors.
+    static RibOutAttrDB *instance = new RibOutAttrDB;
+    return instance;
+}
+
+RibOutAttr::RibOutAttr(const BgpAttr *attr, uint32_t label) {
     if (attr) {
-        nexthop_list_.push_back(
+        NextHopList nexthop_list;
+        nexthop_list.push_back(
                 NextHop(attr->nexthop(), label, attr->ext_community()));
+        Locate(attr, nexthop_list);
     }
 }
 
 RibOutAttr::RibOutAttr(BgpRoute *route, const BgpAttr *attr, bool is_xmpp) {
 
-    //
-    // Attribute should not be set already
-    //
-    assert(!attr_out_);
-
     //
     // Always encode best path's attributes (including it's nexthop) and label.
     //
-    set_attr(attr, route->BestPath()->GetLabel());
+    NextHopList nexthop_list;
+    nexthop_list.push_back(NextHop(attr->nexthop(),
+            route->BestPath()->GetLabel(), attr->ext_community()));
 
     //
     // Do not encode ECMP NextHops for non XMPP peers.
     //
-    if (!is_xmpp) return;
+    if (!is_xmpp) {
+        Locate(attr, nexthop_list);
+        return;
+    }
 
     for (Route::PathList::iterator it = route->GetPathList().begin();
         it != route->GetPathList().end(); it++) {
@@ -101,57 +146,38 @@ RibOutAttr::RibOutAttr(BgpRoute *route, const BgpAttr *attr, bool is_xmpp) {
         //
         // Skip if we have already encoded this next-hop
         //
-        if (std::find(nexthop_list_.begin(), nexthop_list_.end(), nexthop) !=
-                nexthop_list_.end()) {
+        if (std::find(nexthop_list.begin(), nexthop_list.end(), nexthop) !=
+                nexthop_list.end()) {
             continue;
         }
-        nexthop_list_.push_back(nexthop);
+        nexthop_list.push_back(nexthop);
     }
+    Locate(attr, nexthop_list);
 }
 
 //
-// Comparator for RibOutAttr. First compare the BgpAttr and then the label.
+// Point to the interned RibOutAttrData for the given attributes.
 //
-int RibOutAttr::CompareTo(const RibOutAttr &rhs) const {
-    if (attr_out_.get() < rhs.attr_out_.get()) {
-        return -1;
-    }
-    if (attr_out_.get() > rhs.attr_out_.get()) {
-        return 1;
-    }
-    if (nexthop_list_.size() < rhs.nexthop_list_.size()) {
-        return -1;
-    }
-    if (nexthop_list_.size() > rhs.nexthop_list_.size()) {
-        return 1;
-    }
-    for(size_t i = 0; i < nexthop_list_.size(); i++) {
-        int cmp = nexthop_list_[i].CompareTo(rhs.nexthop_list_[i]);
-        if (cmp) {
-            return cmp;
-        }
-    }
-
-    return 0;
+void RibOutAttr::Locate(const BgpAttr *attr, const NextHopList &nexthop_list) {
+    RibOutAttrDB *db = RibOutAttrDB::GetInstance();
+    data_ = db->Locate(new RibOutAttrData(db, attr, nexthop_list));
 }
 
 void RibOutAttr::set_attr(const BgpAttrPtr &attrp, uint32_t label) {
-    if (!attr_out_) {
-        attr_out_ = attrp;
-        assert(nexthop_list_.empty());
-        nexthop_list_.push_back(
-                NextHop(attrp->nexthop(), label, attrp->ext_community()));
-        return;
-    }
-
     if (!attrp) {
         clear();
         return;
     }
 
-    bool nexthop_changed = attr_out_->nexthop() != attrp->nexthop();
-    attr_out_ = attrp;
+    if (!data_) {
+        NextHopList nexthop_list;
+        nexthop_list.push_back(
+                NextHop(attrp->nexthop(), label, attrp->ext_community()));
+        Locate(attrp.get(), nexthop_list);
+        return;
+    }
 
+    bool nexthop_changed = attr()->nexthop() != attrp->nexthop();
     if (nexthop_changed) {
 
         //
@@ -159,6 +185,7 @@ void RibOutAttr::set_attr(const BgpAttrPtr &attrp, uint32_t label) {
         //
         assert(false);
     }
+    Locate(attrp.get(), nexthop_list());
 }
 
 RouteState::RouteState() {
@@ -25,12 +25,23 @@ class BgpExport;
 class BgpRoute;
 class RouteUpdate;
 
+class RibOutAttrData;
+int intrusive_ptr_add_ref(const RibOutAttrData *cdata);
+int intrusive_ptr_del_ref(const RibOutAttrData *cdata);
+void intrusive_ptr_release(const RibOutAttrData *cdata);
+typedef boost::intrusive_ptr<const RibOutAttrData> RibOutAttrDataPtr;
+
 //
 // This class represents the attributes for a ribout entry, including the
 // label.  It is essentially a combination of a smart pointer to BgpAttr
 // and a label. The label is not included in BgpAttr in order to maximize
 // sharing of the BgpAttr.
 //
+// The BgpAttr and the list of nexthops are interned in the RibOutAttrDB as a
+// RibOutAttrData, so a RibOutAttr is a single smart pointer. RibOutAttrs for
+// routes with the same attributes and nexthops share the RibOutAttrData and
+// compare equal iff they point to the same one.
+//
 class RibOutAttr {
 public:
     class NextHop {
@@ -43,7 +54,7 @@ public:
             }
             const IpAddress address() const { return address_; }
             uint32_t label() const { return label_; }
-            std::vector<std::string> encap() const { return encap_; }
+            const std::vector<std::string> &encap() const { return encap_; }
 
             int CompareTo(const NextHop &rhs) const {
                 if (address_ < rhs.address_) return -1;
@@ -67,6 +78,8 @@ public:
                 return CompareTo(rhs) != 0;
             }
 
+            friend std::size_t hash_value(NextHop const &nexthop);
+
         private:
             IpAddress address_;
             uint32_t  label_;
@@ -75,33 +88,112 @@ public:
 
     typedef std::vector<NextHop> NextHopList;
 
-    RibOutAttr() : attr_out_(NULL) { }
+    RibOutAttr() { }
     RibOutAttr(const BgpAttr *attr, uint32_t label);
     RibOutAttr(BgpRoute *route, const BgpAttr *attr, bool is_xmpp);
 
-    bool IsReachable() const { return attr_out_.get() != NULL; }
-    bool operator==(const RibOutAttr &rhs) const { return CompareTo(rhs) == 0; }
-    bool operator!=(const RibOutAttr &rhs) const { return CompareTo(rhs) != 0; }
+    bool IsReachable() const { return attr() != NULL; }
+    bool operator==(const RibOutAttr &rhs) const { return data_ == rhs.data_; }
+    bool operator!=(const RibOutAttr &rhs) const { return data_ != rhs.data_; }
 
-    const NextHopList &nexthop_list() const { return nexthop_list_; }
-    const BgpAttr *attr() const { return attr_out_.get(); }
+    inline const NextHopList &nexthop_list() const;
+    inline const BgpAttr *attr() const;
     void set_attr(const BgpAttrPtr &attrp, uint32_t label = 0);
 
     void clear() {
-        attr_out_.reset();
-        nexthop_list_.clear();
+        data_.reset();
     }
     uint32_t label() const {
-        return nexthop_list_.empty() ? 0 : nexthop_list_.at(0).label();
+        return nexthop_list().empty() ? 0 : nexthop_list().at(0).label();
+    }
+
+private:
+    void Locate(const BgpAttr *attr, const NextHopList &nexthop_list);
+
+    RibOutAttrDataPtr data_;
+};
+
+class RibOutAttrDB;
+
+//
+// The interned contents of a RibOutAttr.
+//
+class RibOutAttrData {
+public:
+    RibOutAttrData(RibOutAttrDB *db, const BgpAttr *attr,
+                   const RibOutAttr::NextHopList &nexthop_list)
+        : db_(db), attr_(attr), nexthop_list_(nexthop_list) {
+        refcount_ = 0;
+    }
+    virtual ~RibOutAttrData() { }
+    virtual void Remove();
+
+    // The BgpAttr is compared by pointer, as it's interned itself.
+    int CompareTo(const RibOutAttrData &rhs) const;
+    friend std::size_t hash_value(RibOutAttrData const &data);
+
+    const BgpAttr *attr() const { return attr_.get(); }
+    const RibOutAttr::NextHopList &nexthop_list() const {
+        return nexthop_list_;
     }
 
 private:
-    int CompareTo(const RibOutAttr &rhs) const;
+    friend int intrusive_ptr_add_ref(const RibOutAttrData *cdata);
+    friend int intrusive_ptr_del_ref(const RibOutAttrData *cdata);
+    friend void intrusive_ptr_release(const RibOutAttrData *cdata);
+
+    mutable tbb::atomic<int> refcount_;
+    RibOutAttrDB *db_;
+    BgpAttrPtr attr_;
+    RibOutAttr::NextHopList nexthop_list_;
+
+    DISALLOW_COPY_AND_ASSIGN(RibOutAttrData);
+};
+
+inline int intrusive_ptr_add_ref(const RibOutAttrData *cdata) {
+    return cdata->refcount_.fetch_and_increment();
+}
+
+inline int intrusive_ptr_del_ref(const RibOutAttrData *cdata) {
+    return cdata->refcount_.fetch_and_decrement();
+}
+
+inline void intrusive_ptr_release(const RibOutAttrData *cdata) {
+    int prev = cdata->refcount_.fetch_and_decrement();
+    if (prev == 1) {
+        RibOutAttrData *data = const_cast<RibOutAttrData *>(cdata);
+        data->Remove();
+        assert(data->refcount_ == 0);
+        delete data;
+    }
+}
 
-    BgpAttrPtr attr_out_;
-    NextHopList nexthop_list_;
+//
+// Process wide data base of RibOutAttrData. It's not kept in the BgpServer
+// like the other attribute data bases since a RibOutAttr can be built from
+// a BgpAttr that doesn't belong to any BgpAttrDB.
+//
+class RibOutAttrDB : public BgpPathAttributeDB<RibOutAttrData,
+                                               RibOutAttrDataPtr,
+                                               RibOutAttr::NextHopList,
+                                               RibOutAttrDB> {
+public:
+    static RibOutAttrDB *GetInstance();
+
+private:
+    RibOutAttrDB() { }
+    DISALLOW_COPY_AND_ASSIGN(RibOutAttrDB);
 };
 
+inline const RibOutAttr::NextHopList &RibOutAttr::nexthop_list() const {
+    static const NextHopList empty_list;
+    return data_ ? data_->nexthop_list() : empty_list;
+}
+
+inline const BgpAttr *RibOutAttr::attr() const {
+    return data_ ? data_->attr() : NULL;
+}
+
 //
 // This class represents a bitset of peers within a RibOut. This is distinct
 // from the GroupPeerSet in order to allow it to be denser. This is possible
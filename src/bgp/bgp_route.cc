@@ -37,15 +37,15 @@ const BgpPath *BgpRoute::BestPath() const {
 // Insert given path and redo path selection.
 //
 void BgpRoute::InsertPath(BgpPath *path) {
-    const Path *prev_front = front();
-
-    insert(path);
-
-    Sort(&BgpTable::PathSelection, prev_front);
+    // The paths are always kept sorted, so there's no need to sort them again.
+    bool fast = insert(path, &BgpTable::PathSelection);
 
     // Update counters.
     BgpTable *table = static_cast<BgpTable *>(get_table());
-    if (table) table->UpdatePathCount(path, +1);
+    if (table) {
+        table->UpdatePathCount(path, +1);
+        table->UpdatePathSelectionCount(fast);
+    }
     path->UpdatePeerRefCount(+1);
 }
 
@@ -55,12 +55,19 @@ void BgpRoute::InsertPath(BgpPath *path) {
 void BgpRoute::DeletePath(BgpPath *path) {
     const Path *prev_front = front();
 
+    // Removing a path, including the best one, leaves the remaining paths
+    // sorted.
     remove(path);
-    Sort(&BgpTable::PathSelection, prev_front);
+    if (prev_front == path) {
+        set_last_change_at_to_now();
+    }
 
     // Update counters.
     BgpTable *table = static_cast<BgpTable *>(get_table());
-    if (table) table->UpdatePathCount(path, -1);
+    if (table) {
+        table->UpdatePathCount(path, -1);
+        table->UpdatePathSelectionCount(true);
+    }
     path->UpdatePeerRefCount(-1);
 
     delete path;
@@ -616,6 +616,8 @@ public:
         rit.secondary_paths = table->GetSecondaryPathCount();
         rit.infeasible_paths = table->GetInfeasiblePathCount();
         rit.paths = rit.primary_paths + rit.secondary_paths;
+        rit.path_selection_fast = table->GetPathSelectionFastCount();
+        rit.path_selection_scans = table->GetPathSelectionScanCount();
     }
 
     static void FillRoutingInstanceInfo(const RequestPipeline::StageData *sd,
@@ -1296,6 +1298,11 @@ public:
         bsc->bgp_server->session_manager()->GetTxSocketStats(peer_socket_stats);
         resp->set_tx_socket_stats(peer_socket_stats);
 
+        PeerMembershipStats membership_stats;
+        bsc->bgp_server->membership_mgr()->FillMembershipStats(
+            &membership_stats);
+        resp->set_membership_stats(membership_stats);
+
         resp->set_context(req->context());
         resp->Response();
         return true;
@@ -13,6 +13,7 @@
 #include "db/db_table_partition.h"
 #include "bgp/bgp_log.h"
 #include "bgp/bgp_path.h"
+#include "bgp/bgp_peer_close.h"
 #include "bgp/bgp_peer_types.h"
 #include "bgp/bgp_peer_membership.h"
 #include "bgp/bgp_ribout.h"
@@ -61,6 +62,8 @@ BgpTable::BgpTable(DB *db, const string &name)
     primary_path_count_ = 0;
     secondary_path_count_ = 0;
     infeasible_path_count_ = 0;
+    path_selection_fast_count_ = 0;
+    path_selection_scan_count_ = 0;
 }
 
 BgpTable::~BgpTable() {
@@ -233,6 +236,15 @@ bool BgpTable::PathSelection(const Path &path1, const Path &path2) {
     return res;
 }
 
+// A stale path of the peer was learned again or deleted.
+static void StalePathDone(const IPeer *peer) {
+    IPeerClose *peer_close =
+        peer ? const_cast<IPeer *>(peer)->peer_close() : NULL;
+    if (peer_close && peer_close->close_manager()) {
+        peer_close->close_manager()->UpdateStalePathCount(-1);
+    }
+}
+
 void BgpTable::InputCommon(DBTablePartBase *root, BgpRoute *rt, BgpPath *path,
                            const IPeer *peer, DBRequest *req,
                            DBRequest::DBOperation oper, BgpAttrPtr attrs,
@@ -287,6 +299,10 @@ void BgpTable::InputCommon(DBTablePartBase *root, BgpRoute *rt, BgpPath *path,
         if (rt && !rt->IsDeleted()) {
             BGP_LOG_ROUTE(this, peer, rt, "Delete BGP path");
 
+            if (path && path->IsStale()) {
+                StalePathDone(peer);
+            }
+
             // Remove the Path from the route
             rt->RemovePath(BgpPath::BGP_XMPP, peer, path_id);
 
@@ -361,8 +377,10 @@ void BgpTable::Input(DBTablePartition *root, DBClient *client,
                                 nexthop.address_.to_v4().to_ulong());
 
             if (path && req->oper != DBRequest::DB_ENTRY_DELETE) {
+                // An identical path is then ignored as a duplicate update
                 if (path->IsStale()) {
                     path->ResetStale();
+                    StalePathDone(peer);
                 }
                 deleted_paths.erase(path);
             }
@@ -485,3 +503,11 @@ void BgpTable::UpdatePathCount(const BgpPath *path, int count) {
         infeasible_path_count_ += count;
     }
 }
+
+void BgpTable::UpdatePathSelectionCount(bool fast) {
+    if (fast) {
+        path_selection_fast_count_++;
+    } else {
+        path_selection_scan_count_++;
+    }
+}
@@ -119,6 +119,15 @@ public:
         return infeasible_path_count_;
     }
 
+    // Path changes settled without scanning the path list (fast) or not.
+    void UpdatePathSelectionCount(bool fast);
+    const uint64_t GetPathSelectionFastCount() const {
+        return path_selection_fast_count_;
+    }
+    const uint64_t GetPathSelectionScanCount() const {
+        return path_selection_scan_count_;
+    }
+
 private:
     class DeleteActor;
     friend class BgpTableTest;
@@ -132,6 +141,8 @@ private:
     tbb::atomic<uint64_t> primary_path_count_;
     tbb::atomic<uint64_t> secondary_path_count_;
     tbb::atomic<uint64_t> infeasible_path_count_;
+    tbb::atomic<uint64_t> path_selection_fast_count_;
+    tbb::atomic<uint64_t> path_selection_scan_count_;
 
     DISALLOW_COPY_AND_ASSIGN(BgpTable);
 };
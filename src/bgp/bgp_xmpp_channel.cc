@@ -239,6 +239,7 @@ public:
     }
 
     virtual bool SendUpdate(const uint8_t *msg, size_t msgsize);
+    virtual bool FlushUpdate();
     virtual std::string ToString() const {
         return parent_->ToString();
     }
@@ -332,7 +333,7 @@ bool BgpXmppChannel::XmppPeer::SendUpdate(const uint8_t *msg, size_t msgsize) {
     if (channel->GetPeerState() == xmps::READY) {
         parent_->stats_[1].rt_updates ++;
         if (SkipUpdateSend()) return true;
-        send_ready_ = channel->Send(msg, msgsize, xmps::BGP,
+        send_ready_ = channel->SendBatch(msg, msgsize, xmps::BGP,
                 boost::bind(&BgpXmppChannel::XmppPeer::WriteReadyCb, this, _1));
         if (!send_ready_) {
             XmppPeerInfoData peer_info;
@@ -346,6 +347,20 @@ bool BgpXmppChannel::XmppPeer::SendUpdate(const uint8_t *msg, size_t msgsize) {
     }
 }
 
+bool BgpXmppChannel::XmppPeer::FlushUpdate() {
+    XmppChannel *channel = parent_->channel_;
+    if (channel->Flush(
+            boost::bind(&BgpXmppChannel::XmppPeer::WriteReadyCb, this, _1))) {
+        return true;
+    }
+    send_ready_ = false;
+    XmppPeerInfoData peer_info;
+    peer_info.set_name(ToUVEKey());
+    peer_info.set_send_state("not in sync");
+    XMPPPeerInfo::Send(peer_info);
+    return false;
+}
+
 void BgpXmppChannel::XmppPeer::Close() {
     SetDeleted(true);
     if (server_ == NULL) {
@@ -370,6 +385,9 @@ BgpXmppChannel::BgpXmppChannel(XmppChannel *channel, BgpServer *bgp_server,
             boost::bind(&BgpXmppChannel::MembershipResponseHandler, this, _1)),
       lb_mgr_(new LabelBlockManager()) {
 
+    if (manager_ && manager_->batch_send_bytes() != 0) {
+        channel_->SetBatchSend(manager_->batch_send_bytes());
+    }
     channel_->RegisterReceive(peer_id_,
          boost::bind(&BgpXmppChannel::ReceiveUpdate, this, _1));
 }
@@ -1520,6 +1538,7 @@ BgpXmppChannelManager::BgpXmppChannelManager(XmppServer *xmpp_server,
                                              BgpServer *server)
     : xmpp_server_(xmpp_server),
       bgp_server_(server),
+      batch_send_bytes_(0),
       queue_(TaskScheduler::GetInstance()->GetTaskId("bgp::Config"), 0,
              boost::bind(&BgpXmppChannelManager::DeleteExecutor, this, _1)) {
     queue_.SetEntryCallback(
@@ -178,6 +178,13 @@ public:
     }
     BgpServer *bgp_server() { return bgp_server_; }
     XmppServer *xmpp_server() { return xmpp_server_; }
+
+    // Batch the route updates sent to each XMPP peer, up to max_bytes per
+    // send. Applies to the channels created afterwards. 0 disables batching.
+    void set_batch_send_bytes(size_t max_bytes) {
+        batch_send_bytes_ = max_bytes;
+    }
+    size_t batch_send_bytes() const { return batch_send_bytes_; }
 protected:
     virtual BgpXmppChannel *CreateChannel(XmppChannel *);
 
@@ -186,6 +193,7 @@ private:
     
     XmppServer *xmpp_server_;
     BgpServer  *bgp_server_;
+    size_t batch_send_bytes_;
     WorkQueue<BgpXmppChannel *> queue_;
     XmppChannelMap channel_map_;
     int id_;
@@ -90,15 +90,8 @@ inline void intrusive_ptr_release(const Community *ccomm) {
 
 typedef boost::intrusive_ptr<const Community> CommunityPtr;
 
-struct CommunityCompare {
-    bool operator()(const Community *lhs, const Community *rhs) {
-        return lhs->CompareTo(*rhs) < 0;
-    }
-};
-
 class CommunityDB : public BgpPathAttributeDB<Community, CommunityPtr,
-                                              CommunitySpec, CommunityCompare,
-                                              CommunityDB> {
+                                              CommunitySpec, CommunityDB> {
 public:
     CommunityDB(BgpServer *server);
     virtual ~CommunityDB() { }
@@ -229,15 +222,8 @@ inline void intrusive_ptr_release(const ExtCommunity *cextcomm) {
 
 typedef boost::intrusive_ptr<const ExtCommunity> ExtCommunityPtr;
 
-struct ExtCommunityCompare {
-    bool operator()(const ExtCommunity *lhs, const ExtCommunity *rhs) {
-        return lhs->CompareTo(*rhs) < 0;
-    }
-};
-
 class ExtCommunityDB : public BgpPathAttributeDB<ExtCommunity, ExtCommunityPtr,
                                                  ExtCommunitySpec,
-                                                 ExtCommunityCompare,
                                                  ExtCommunityDB> {
 public:
     ExtCommunityDB(BgpServer *server);
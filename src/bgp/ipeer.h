@@ -20,6 +20,11 @@ public:
     // Send an update. Returns true if the peer can send additional messages,
     // false if it is send blocked.
     virtual bool SendUpdate(const uint8_t *msg, size_t msgsize) = 0;
+
+    // Flush updates held back by SendUpdate. Called at the end of every
+    // send task work item that may have sent updates to the peer. Returns
+    // false if the peer is send blocked, like SendUpdate.
+    virtual bool FlushUpdate() { return true; }
 };
 
 class IPeerDebugStats {
@@ -60,6 +60,36 @@ TableState::~TableState() {
 void TableState::ManagedDelete() {
 }
 
+void TableState::AddRouteTarget(const RouteTarget &rtarget, BgpRoute *rt) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    rtarget_index_[rtarget].insert(rt);
+}
+
+void TableState::RemoveRouteTarget(const RouteTarget &rtarget, BgpRoute *rt) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    RouteTargetIndex::iterator loc = rtarget_index_.find(rtarget);
+    if (loc == rtarget_index_.end())
+        return;
+    loc->second.erase(rt);
+    if (loc->second.empty())
+        rtarget_index_.erase(loc);
+}
+
+void TableState::GetRoutes(const RouteTarget &rtarget, const BgpRoute *after,
+                           size_t limit, RouteList *list) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    RouteTargetIndex::const_iterator loc = rtarget_index_.find(rtarget);
+    if (loc == rtarget_index_.end())
+        return;
+    RouteList::const_iterator it = loc->second.begin();
+    if (after)
+        it = loc->second.upper_bound(const_cast<BgpRoute *>(after));
+    for (size_t count = 0; it != loc->second.end() && count < limit;
+         ++it, ++count) {
+        list->insert(*it);
+    }
+}
+
 RoutePathReplicator::RoutePathReplicator(
         BgpServer *server, Address::Family family)
         : server_(server),
@@ -138,9 +168,79 @@ RoutePathReplicator::RequestWalk(BgpTable *table) {
     }
 }
 
+//
+// Re-evaluate the routes of the table that carry the RouteTarget, instead of
+// walking the whole table. Only valid if the RouteTargets of the routes are
+// not affected by the change, i.e. for import changes and for export changes
+// of the default routing instance.
+//
+// A table that exports no RouteTarget drops its routes from the index, and a
+// table walk re-evaluates every route anyway, so such tables are walked.
+// The walk also lets BulkReplicationDone release the TableState.
+//
+void
+RoutePathReplicator::RequestRouteSync(BgpTable *table, const RouteTarget &rt) {
+    CHECK_CONCURRENCY("bgp::Config");
+    RtGroupTableState::iterator loc = table_state_.find(table);
+    if (loc == table_state_.end())
+        return;
+    if (loc->second->GetGroupList().empty() ||
+        bulk_sync_.find(table) != bulk_sync_.end()) {
+        RequestWalk(table);
+        return;
+    }
+    RouteSyncState &state = route_sync_[table];
+    if (state.rtargets.insert(rt).second)
+        state.last = NULL;
+}
+
+//
+// Re-evaluate at most kMaxRouteSyncCount routes, in route order. Returns
+// false if routes are left for the next run.
+//
+// The routes in the index have DBState, so they are valid until the listener
+// clears it. Each route is handled once, since that could delete it. The
+// routes are looked up again on each run since the DB tasks may change the
+// index in between.
+//
+bool
+RoutePathReplicator::SyncRoutes() {
+    size_t budget = kMaxRouteSyncCount;
+    RouteSyncOrders::iterator it = route_sync_.begin();
+    while (it != route_sync_.end()) {
+        BgpTable *table = it->first;
+        RouteSyncState *state = &it->second;
+        RtGroupTableState::iterator loc = table_state_.find(table);
+        if (loc == table_state_.end()) {
+            route_sync_.erase(it++);
+            continue;
+        }
+        TableState *ts = loc->second;
+        TableState::RouteList routes;
+        BOOST_FOREACH(const RouteTarget &rt, state->rtargets) {
+            ts->GetRoutes(rt, state->last, budget, &routes);
+        }
+        size_t count = 0;
+        for (TableState::RouteList::iterator rit = routes.begin();
+             rit != routes.end() && count < budget; ++rit, ++count) {
+            BgpRoute *route = *rit;
+            BgpTableListener(table->GetTablePartition(route), route);
+            state->last = route;
+        }
+        RPR_TRACE(RouteSync, table->name(), count);
+        if (routes.size() >= budget)
+            return false;
+        budget -= count;
+        route_sync_.erase(it++);
+    }
+    return true;
+}
+
 bool
 RoutePathReplicator::StartWalk() {
     CHECK_CONCURRENCY("bgp::Config");
+    bool done = SyncRoutes();
+
     DBTableWalker::WalkCompleteFn walk_complete
         = boost::bind(&RoutePathReplicator::BulkReplicationDone, this, _1);
 
@@ -160,7 +260,7 @@ RoutePathReplicator::StartWalk() {
         it->second->SetWalkerId(id);
         it->second->SetWalkAgain(false);
     }
-    return true;
+    return done;
 }
 
 bool 
@@ -206,6 +306,35 @@ RoutePathReplicator::BulkReplicationDone(DBTableBase *table) {
     unreg_trigger_->Set();
 }
 
+void RoutePathReplicator::AddImportTable(RtGroup *group, BgpTable *table) {
+    ImportIndexMap::iterator loc = import_index_map_.find(table);
+    if (loc == import_index_map_.end()) {
+        size_t index = import_index_bits_.find_first_clear();
+        import_index_bits_.set(index);
+        if (index >= import_tables_.size())
+            import_tables_.resize(index + 1);
+        import_tables_[index] = table;
+        loc = import_index_map_.insert(
+            std::make_pair(table, std::make_pair(index, 0))).first;
+    }
+    if (group->AddImportTable(table, loc->second.first))
+        loc->second.second++;
+}
+
+void RoutePathReplicator::RemoveImportTable(RtGroup *group, BgpTable *table) {
+    ImportIndexMap::iterator loc = import_index_map_.find(table);
+    if (loc == import_index_map_.end())
+        return;
+    size_t index = loc->second.first;
+    if (!group->RemoveImportTable(table, index))
+        return;
+    if (--loc->second.second == 0) {
+        import_tables_[index] = NULL;
+        import_index_bits_.reset(index);
+        import_index_map_.erase(loc);
+    }
+}
+
 void RoutePathReplicator::Join(BgpTable *table, const RouteTarget &rt,
                                bool import) {
     CHECK_CONCURRENCY("bgp::Config");
@@ -214,14 +343,14 @@ void RoutePathReplicator::Join(BgpTable *table, const RouteTarget &rt,
 
     // Add the Table to Group
     if (import)
-        group->AddImportTable(table);
+        AddImportTable(group, table);
     else
         group->AddExportTable(table);
 
     RPR_TRACE(TableJoin, table->name(), rt.ToString(), import);
     if (import) {
         BOOST_FOREACH(BgpTable *bgptable, group->GetExportTables()) {
-            RequestWalk(bgptable);
+            RequestRouteSync(bgptable, rt);
         }
         walk_trigger_->Set();
         return;
@@ -238,7 +367,17 @@ void RoutePathReplicator::Join(BgpTable *table, const RouteTarget &rt,
         RPR_TRACE(RegTable, table->name());
     } else {
         TableState *ts = loc->second;
+        bool was_empty = ts->GetGroupList().empty();
         ts->MutableGroupList()->push_back(group);
+
+        // Routes in the default instance carry their own RouteTargets. The
+        // index is empty if the table exported nothing, so walk it then.
+        if (!was_empty &&
+            table->routing_instance()->IsDefaultRoutingInstance()) {
+            RequestRouteSync(table, rt);
+            walk_trigger_->Set();
+            return;
+        }
     }
 
     RequestWalk(table);
@@ -255,22 +394,23 @@ void RoutePathReplicator::Leave(BgpTable *table, const RouteTarget &rt,
     RPR_TRACE(TableLeave, table->name(), rt.ToString(), import);
 
     if (import) {
-        group->RemoveImportTable(table);
+        RemoveImportTable(group, table);
         BOOST_FOREACH(BgpTable *bgptable, group->GetExportTables()) {
-            RequestWalk(bgptable);
+            RequestRouteSync(bgptable, rt);
         }
     } else {
         group->RemoveExportTable(table);
-        RequestWalk(table);
-    }
-
-    if (!import) {
         RtGroupTableState::iterator loc = table_state_.find(table);
         assert(loc != table_state_.end());
         TableState *ts = loc->second;
         ts->MutableGroupList()->remove(group);
         // The unregister from DBTable and delete of the TableState
         // after the TableWalk is completed (started by BgpBulkSync)
+        if (table->routing_instance()->IsDefaultRoutingInstance()) {
+            RequestRouteSync(table, rt);
+        } else {
+            RequestWalk(table);
+        }
     }
 
     if ((group->GetImportTables().size() == 1) &&
@@ -287,7 +427,9 @@ void RoutePathReplicator::Leave(BgpTable *table, const RouteTarget &rt,
                 assert(loc != table_state_.end());
                 TableState *ts = loc->second;
                 ts->MutableGroupList()->remove(group);
-                group->RemoveImportTable(vpntable);
+                if (ts->GetGroupList().empty())
+                    RequestWalk(vpntable);
+                RemoveImportTable(group, vpntable);
                 group->RemoveExportTable(vpntable);
                 rt_group_map_.erase(rt);
             }
@@ -342,12 +484,30 @@ RoutePathReplicator::DBStateSync(BgpTable *table, BgpRoute *rt,
         DeleteSecondaryPath(table, rt, *dbstate_it);
         dbstate->GetMutableList()->erase(dbstate_it);
     }
-    if (dbstate->GetList().empty()) {
+    if (dbstate->GetList().empty() && dbstate->GetRouteTargetList().empty()) {
         rt->ClearState(table, id);
         delete dbstate;
     }
 }
 
+//
+// Move the route to the given RouteTargets in the index of the table.
+//
+void RoutePathReplicator::UpdateRouteTargets(TableState *ts, BgpRoute *rt,
+        RtReplicated *dbstate, const RtReplicated::RouteTargetList &rtargets) {
+    RtReplicated::RouteTargetList *current =
+        dbstate->GetMutableRouteTargetList();
+    BOOST_FOREACH(const RouteTarget &rtarget, *current) {
+        if (rtargets.find(rtarget) == rtargets.end())
+            ts->RemoveRouteTarget(rtarget, rt);
+    }
+    BOOST_FOREACH(const RouteTarget &rtarget, rtargets) {
+        if (current->find(rtarget) == current->end())
+            ts->AddRouteTarget(rtarget, rt);
+    }
+    *current = rtargets;
+}
+
 //
 // Update the ExtCommunity with the RouteTargets from the export list
 // and the OriginVn. The OriginVn is derived from the RouteTargets in
@@ -413,14 +573,17 @@ bool RoutePathReplicator::BgpTableListener(DBTablePartBase *root,
         static_cast<RtReplicated *>(rt->GetState(table, id));
 
     RtReplicated::ReplicatedRtPathList replicated_path_list;
+    RtReplicated::RouteTargetList rtargets;
 
     // Cleanup if the route is marked for deletion, or there is no best path or
-    // if the best path is infeasible
+    // if the best path is infeasible, or if the table no longer exports any
+    // RouteTarget
     if (entry->IsDeleted() || !rt->BestPath() ||
-            !rt->BestPath()->IsFeasible()) {
+            !rt->BestPath()->IsFeasible() || ts->GetGroupList().empty()) {
         if (!dbstate) {
             return true;
         }
+        UpdateRouteTargets(ts, rt, dbstate, rtargets);
         DBStateSync(table, rt, id, dbstate, replicated_path_list);
         return true;
     }
@@ -457,13 +620,13 @@ bool RoutePathReplicator::BgpTableListener(DBTablePartBase *root,
         if (!ext_community)
             continue;
 
-        RtGroup::RtGroupMemberList super_set;
+        BitSet super_set;
 
         // Go through all extended communities.
         //
         // Get the vn_index from the OriginVn extended community.
-        // For each RouteTarget extended community, get the list of tables
-        // to which we need to replicate the path.
+        // For each RouteTarget extended community, add the tables to which
+        // we need to replicate the path and index the route under it.
         int vn_index = 0;
         BOOST_FOREACH(const ExtCommunity::ExtCommunityValue &comm, 
                       ext_community->communities()) {
@@ -471,23 +634,19 @@ bool RoutePathReplicator::BgpTableListener(DBTablePartBase *root,
                 OriginVn origin_vn(comm);
                 vn_index = origin_vn.vn_index();
             } else if (ExtCommunity::is_route_target(comm)) {
-                RtGroup *rtgroup = GetRtGroup(comm);
+                RouteTarget rtarget(comm);
+                rtargets.insert(rtarget);
+                RtGroup *rtgroup = GetRtGroup(rtarget);
                 if (!rtgroup)
                     continue;
-                super_set.insert(super_set.end(), 
-                                 rtgroup->GetImportTables().begin(),
-                                 rtgroup->GetImportTables().end());
+                super_set |= rtgroup->GetImportBits();
             }
         }
 
-        if (super_set.empty()) continue;
-
-        // Duplicate tables to be removed
-        super_set.sort();
-        super_set.unique();
-
         // To all destination tables.. call replicate
-        BOOST_FOREACH(BgpTable *dest, super_set) {
+        for (size_t idx = super_set.find_first(); idx != BitSet::npos;
+             idx = super_set.find_next(idx)) {
+            BgpTable *dest = import_tables_[idx];
             // same as source table... skip
             if (dest == table) continue;
 
@@ -525,6 +684,7 @@ bool RoutePathReplicator::BgpTableListener(DBTablePartBase *root,
         }
     }
 
+    UpdateRouteTargets(ts, rt, dbstate, rtargets);
     DBStateSync(table, rt, id, dbstate, replicated_path_list);
     return true;
 }
@@ -6,12 +6,17 @@
 #define ctrlplane_routepath_replicator_h
 
 #include <list>
+#include <map>
+#include <set>
+#include <vector>
 
 #include <boost/ptr_container/ptr_map.hpp>
 #include <tbb/mutex.h>
 
+#include "base/bitset.h"
 #include "bgp/bgp_table.h"
 #include "bgp/community.h"
+#include "bgp/rtarget/rtarget_address.h"
 #include "db/db_table_walker.h"
 
 #include <sandesh/sandesh_trace.h>
@@ -19,17 +24,25 @@
 class BgpRoute;
 class BgpServer;
 class RtGroup;
-class RouteTarget;
 class TaskTrigger;
 
 class TableState {
 public:
     typedef std::list<RtGroup *> GroupList;
+    typedef std::set<BgpRoute *> RouteList;
     TableState(BgpTable *table, DBTableBase::ListenerId id);
     ~TableState();
 
     void ManagedDelete();
 
+    // Index of the routes carrying a RouteTarget, updated from the table
+    // listener which runs concurrently on all partitions.
+    void AddRouteTarget(const RouteTarget &rtarget, BgpRoute *rt);
+    void RemoveRouteTarget(const RouteTarget &rtarget, BgpRoute *rt);
+    // Adds at most limit routes, those ordered after the given one if any.
+    void GetRoutes(const RouteTarget &rtarget, const BgpRoute *after,
+                   size_t limit, RouteList *list);
+
     const GroupList &GetGroupList() const {
         return list_;
     }
@@ -41,9 +54,13 @@ public:
     }
 
 private:
+    typedef std::map<RouteTarget, RouteList> RouteTargetIndex;
+
     DBTableBase::ListenerId id_;
     LifetimeRef<TableState> table_delete_ref_;
     GroupList list_;
+    tbb::mutex mutex_;
+    RouteTargetIndex rtarget_index_;
     DISALLOW_COPY_AND_ASSIGN(TableState);
 };
 
@@ -117,6 +134,7 @@ public:
     };  
 
     typedef std::set<SecondaryRouteInfo> ReplicatedRtPathList;
+    typedef std::set<RouteTarget> RouteTargetList;
 
     // Get the list of replicated route for given Primary Route
     const ReplicatedRtPathList &GetList() const {
@@ -127,6 +145,15 @@ public:
         return &replicate_list_;
     }
 
+    // RouteTargets under which the route is in the TableState index
+    const RouteTargetList &GetRouteTargetList() const {
+        return rtarget_list_;
+    }
+
+    RouteTargetList *GetMutableRouteTargetList() {
+        return &rtarget_list_;
+    }
+
     // Add a replicated route to List
     void AddReplicatedRt(BgpTable *dest, const IPeer *peer, BgpRoute *rt);
 
@@ -136,6 +163,7 @@ public:
 
 private:
     ReplicatedRtPathList  replicate_list_;
+    RouteTargetList rtarget_list_;
 };
 
 // Matrix of RouteTarget and BgpTable that imports & exports route belonging
@@ -183,6 +211,14 @@ public:
 
     void RequestWalk(BgpTable *table);
 
+    // Re-evaluate only the routes of the table that carry the RouteTarget
+    void RequestRouteSync(BgpTable *table, const RouteTarget &rt);
+
+    // Table with the given bit in the import bitmap of the RtGroups
+    BgpTable *GetImportTable(size_t index) const {
+        return import_tables_[index];
+    }
+
     SandeshTraceBufferPtr trace_buffer() const { return trace_buf_; }
 
     bool UnregisterTables();
@@ -191,8 +227,29 @@ private:
     typedef std::map<BgpTable *, TableState *> RtGroupTableState;
     typedef std::map<BgpTable *, BulkSyncState *> BulkSyncOrders;
     typedef std::set<BgpTable *> UnregTableList;
+    // RouteTargets whose routes are to be re-evaluated, and the last route
+    // re-evaluated so far.
+    struct RouteSyncState {
+        RouteSyncState() : last(NULL) { }
+        std::set<RouteTarget> rtargets;
+        const BgpRoute *last;
+    };
+    typedef std::map<BgpTable *, RouteSyncState> RouteSyncOrders;
+    // Import table bit index and the number of RtGroups using it
+    typedef std::map<BgpTable *, std::pair<size_t, int> > ImportIndexMap;
+
+    // Routes re-evaluated in one run of the walk trigger
+    static const size_t kMaxRouteSyncCount = 512;
 
     bool StartWalk();
+    bool SyncRoutes();
+
+    void AddImportTable(RtGroup *group, BgpTable *table);
+    void RemoveImportTable(RtGroup *group, BgpTable *table);
+
+    void UpdateRouteTargets(TableState *ts, BgpRoute *rt,
+                            RtReplicated *dbstate,
+                            const RtReplicated::RouteTargetList &rtargets);
 
     void DeleteSecondaryPath(BgpTable  *table, BgpRoute *rt,
                              const RtReplicated::SecondaryRouteInfo &rtinfo);
@@ -206,6 +263,10 @@ private:
     tbb::mutex mutex_;
     RtGroupTableState table_state_;
     BulkSyncOrders bulk_sync_;
+    RouteSyncOrders route_sync_;
+    ImportIndexMap import_index_map_;
+    std::vector<BgpTable *> import_tables_;
+    BitSet import_index_bits_;
     UnregTableList unreg_table_list_;
     BgpServer *server_;
     Address::Family family_;
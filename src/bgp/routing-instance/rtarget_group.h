@@ -7,6 +7,7 @@
 
 #include <list>
 
+#include "base/bitset.h"
 #include "bgp/bgp_table.h"
 #include "bgp/rtarget/rtarget_address.h"
 
@@ -14,6 +15,9 @@
 // Contains two lists of tables 
 //       1. Tables that imports the route belonging to this RouteTarget
 //       2. Tables to which route needs to be exported
+// The import tables are also kept as a bitmap of the table indexes assigned
+// by the RoutePathReplicator, so that the import tables of all RouteTargets
+// of a path are found with a bitset union.
 class RtGroup {
 public:
     typedef std::list<BgpTable *> RtGroupMemberList;
@@ -29,10 +33,18 @@ public:
         return export_list_;
     }
 
-    void AddImportTable(BgpTable *tbl) {
+    const BitSet &GetImportBits() const {
+        return import_bits_;
+    }
+
+    // Returns false if the table was already in the group.
+    bool AddImportTable(BgpTable *tbl, size_t index) {
+        if (import_bits_.test(index))
+            return false;
+        import_bits_.set(index);
         import_list_.push_back(tbl);
         import_list_.sort();
-        import_list_.unique();
+        return true;
     }
 
     void AddExportTable(BgpTable *tbl) {
@@ -41,8 +53,13 @@ public:
         export_list_.unique();
     }
 
-    void RemoveImportTable(BgpTable *tbl) {
+    // Returns false if the table was not in the group.
+    bool RemoveImportTable(BgpTable *tbl, size_t index) {
+        if (!import_bits_.test(index))
+            return false;
+        import_bits_.reset(index);
         import_list_.remove(tbl);
+        return true;
     }
 
     void RemoveExportTable(BgpTable *tbl) {
@@ -58,6 +75,7 @@ public:
     }
 private:
     RtGroupMemberList import_list_;
+    BitSet import_bits_;
     RtGroupMemberList export_list_;
     RouteTarget rt_;
     DISALLOW_COPY_AND_ASSIGN(RtGroup);
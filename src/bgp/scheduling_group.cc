@@ -4,6 +4,8 @@
 
 #include "bgp/scheduling_group.h"
 
+#include <stdlib.h>
+#include <algorithm>
 #include <boost/bind.hpp>
 #include <boost/iterator/iterator_facade.hpp>
 
@@ -21,6 +23,7 @@ using namespace std;
 using namespace tbb;
 
 int SchedulingGroup::send_task_id_ = -1;
+int SchedulingGroup::max_workers_ = 0;
 
 //
 // This struct represents RibOut specific state for a PeerState.  There's one
@@ -394,6 +397,11 @@ struct SchedulingGroup::WorkBase {
     };
     WorkBase(Type type) : type(type) { }
     Type type;
+
+    // RibOut indexes and peers that processing the entry can touch. Valid
+    // while the entry is being processed.
+    BitSet ribs;
+    GroupPeerSet peers;
 };
 
 struct SchedulingGroup::WorkRibOut : public SchedulingGroup::WorkBase {
@@ -419,7 +427,7 @@ public:
         CHECK_CONCURRENCY("bgp::SendTask");
 
         while (true) {
-            auto_ptr<WorkBase> wentry = group_->WorkDequeue();
+            auto_ptr<WorkBase> wentry = group_->WorkDequeue(this);
             if (wentry.get() == NULL) {
                 break;
             }
@@ -435,6 +443,8 @@ public:
                 break;
             }
             }
+            group_->WorkFlush(wentry.get());
+            group_->WorkDone(wentry.get());
         }
 
         return true;
@@ -444,17 +454,24 @@ private:
     SchedulingGroup *group_;
 };
 
-SchedulingGroup::SchedulingGroup() : running_(false), worker_task_(NULL) {
+SchedulingGroup::SchedulingGroup() {
     if (send_task_id_ == -1) {
         TaskScheduler *scheduler = TaskScheduler::GetInstance();
         send_task_id_ = scheduler->GetTaskId("bgp::SendTask");
     }
+    if (max_workers_ == 0) {
+        TaskScheduler *scheduler = TaskScheduler::GetInstance();
+        char *str = getenv("BGP_SCHEDULING_GROUP_WORKERS");
+        int count = str ? strtol(str, NULL, 0) : scheduler->HardwareThreadCount();
+        max_workers_ = max(count, 1);
+    }
 }
 
 SchedulingGroup::~SchedulingGroup() {
-    if (worker_task_) {
-        TaskScheduler *scheduler = TaskScheduler::GetInstance();
-        scheduler->Cancel(worker_task_);
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    for (WorkerSet::iterator iter = workers_.begin(); iter != workers_.end();
+         ++iter) {
+        scheduler->Cancel(*iter);
     }
 }
 
@@ -810,38 +827,129 @@ bool SchedulingGroup::IsSendReady(IPeerUpdate *peer) const {
 }
 
 //
-// Dequeue the first WorkBase item from the work queue and return an
-// auto_ptr to it.  Clear out Worker related state if the work queue
-// is empty.
+// Fill in the RibOuts and peers that processing the WorkBase entry can touch.
+//
+// A WorkRibOut dequeues updates for all peers of the RibOut. A WorkPeer
+// dequeues updates from all RibOuts of the peer and may merge other peers
+// of those RibOuts with its marker.
+//
+void SchedulingGroup::WorkFootprint(WorkBase *wentry) {
+    wentry->ribs.clear();
+    wentry->peers.clear();
+    switch (wentry->type) {
+    case WorkBase::WRibOut: {
+        WorkRibOut *work = static_cast<WorkRibOut *>(wentry);
+        RibState *rs = rib_state_imap_.Find(work->ribout);
+        if (rs == NULL)
+            break;
+        wentry->ribs.set(rs->index());
+        wentry->peers.Set(rs->peer_set());
+        break;
+    }
+    case WorkBase::WPeer: {
+        WorkPeer *work = static_cast<WorkPeer *>(wentry);
+        PeerState *ps = peer_state_imap_.Find(work->peer);
+        if (ps == NULL)
+            break;
+        wentry->peers.set(ps->index());
+        for (PeerState::iterator iter = ps->begin(rib_state_imap_);
+             iter != ps->end(rib_state_imap_); ++iter) {
+            wentry->ribs.set(iter.index());
+            wentry->peers.Set(iter.rib_state()->peer_set());
+        }
+        break;
+    }
+    }
+}
+
+//
+// Dequeue the first WorkBase item from the work queue that doesn't overlap
+// with the items being processed by other Workers or with the items ahead
+// of it on the work queue, and return an auto_ptr to it. Only the first
+// kMaxWorkScan items are considered. Clear out Worker related state if
+// there's no such item. If the work queue isn't empty, the Workers that
+// are still busy take care of the rest.
 //
-auto_ptr<SchedulingGroup::WorkBase> SchedulingGroup::WorkDequeue() {
+auto_ptr<SchedulingGroup::WorkBase> SchedulingGroup::WorkDequeue(
+        Worker *worker) {
     CHECK_CONCURRENCY("bgp::SendTask");
 
     mutex::scoped_lock lock(mutex_);
     auto_ptr<WorkBase> wentry;
-    if (work_queue_.empty()) {
-        worker_task_ = NULL;
-        running_ = false;
-    } else {
-        wentry.reset(work_queue_.pop_front().release());
+    BitSet ribs = busy_ribs_;
+    GroupPeerSet peers = busy_peers_;
+    int count = 0;
+    for (WorkQueue::iterator iter = work_queue_.begin();
+         iter != work_queue_.end() && count < kMaxWorkScan; ++iter, ++count) {
+        WorkBase *entry = iter.operator->();
+        WorkFootprint(entry);
+        if (!entry->ribs.intersects(ribs) &&
+            !entry->peers.intersects(peers)) {
+            busy_ribs_.Set(entry->ribs);
+            busy_peers_.Set(entry->peers);
+            wentry.reset(work_queue_.release(iter).release());
+            return wentry;
+        }
+
+        // The entries behind this one must not overtake it.
+        ribs.Set(entry->ribs);
+        peers.Set(entry->peers);
     }
+
+    workers_.erase(worker);
     return wentry;
 }
 
 //
 // Enqueue a WorkBase entry into the the work queue and start a new Worker
-// task if required.
+// task if there's more work than the running Workers can take on.
 //
 void SchedulingGroup::WorkEnqueue(WorkBase *wentry) {
     CHECK_CONCURRENCY("db::DBTable", "bgp::SendTask", "bgp::SendReadyTask");
 
     mutex::scoped_lock lock(mutex_);
     work_queue_.push_back(wentry);
-    if (!running_) {
-        worker_task_ = new Worker(this);
+    if (workers_.size() < (size_t) max_workers_ &&
+        work_queue_.size() > workers_.size()) {
+        Worker *worker = new Worker(this);
+        workers_.insert(worker);
         TaskScheduler *scheduler = TaskScheduler::GetInstance();
-        scheduler->Enqueue(worker_task_);
-        running_ = true;
+        scheduler->Enqueue(worker);
+    }
+}
+
+//
+// Release the RibOuts and peers used by a WorkBase entry that has been
+// processed.
+//
+void SchedulingGroup::WorkDone(WorkBase *wentry) {
+    CHECK_CONCURRENCY("bgp::SendTask");
+
+    mutex::scoped_lock lock(mutex_);
+    busy_ribs_.Reset(wentry->ribs);
+    busy_peers_.Reset(wentry->peers);
+}
+
+//
+// Flush the updates batched by the peers used by a WorkBase entry that has
+// been processed. The peers are still owned by the Worker. A peer that gets
+// blocked by the flush is marked send blocked, the same as when SendUpdate
+// blocks it. Its updates have all been dequeued, so no queue is marked
+// active for it.
+//
+void SchedulingGroup::WorkFlush(WorkBase *wentry) {
+    CHECK_CONCURRENCY("bgp::SendTask");
+
+    for (size_t bit = wentry->peers.find_first(); bit != GroupPeerSet::npos;
+         bit = wentry->peers.find_next(bit)) {
+        PeerState *ps = peer_state_imap_.At(bit);
+        if (ps == NULL)
+            continue;
+        if (!ps->peer()->FlushUpdate() && ps->send_ready()) {
+            BGP_LOG_SCHEDULING_GROUP_MESSAGE(ps->peer(), ": send-blocked");
+            ps->clear_sync();
+            ps->set_send_ready(false);
+        }
     }
 }
 
@@ -7,6 +7,7 @@
 
 #include <list>
 #include <map>
+#include <set>
 #include <vector>
 #include <boost/ptr_container/ptr_deque.hpp>
 #include <tbb/mutex.h>
@@ -49,11 +50,18 @@ class GroupPeerSet : public BitSet {
 // to a peer dequeue.
 //
 // A mutex is used to control access to the WorkQueue between producers that
-// need to enqueue WorkBase entries and the Worker which dequeues the entries
-// and processes them. The producers are the BgpExport class which creates a
+// need to enqueue WorkBase entries and the Workers which dequeue the entries
+// and process them. The producers are the BgpExport class which creates a
 // WorkRibOut entry after adding a RouteUpdate to an empty UpdateQueue, and
 // the IPeer class which create a WorkPeer entry when it becomes unblocked.
 //
+// Up to max_workers_ Workers process the WorkQueue concurrently. A WorkBase
+// entry is only handed to a Worker if none of the RibOuts and IPeers it can
+// touch are in use by another Worker or by an earlier entry that is still on
+// the WorkQueue. Hence a given IPeerUpdate is written to by a single Worker
+// at a time, and entries that touch it are processed in the order in which
+// they were enqueued.
+//
 class SchedulingGroup {
 public:
     typedef std::vector<RibOut *> RibOutList;
@@ -114,16 +122,24 @@ private:
     struct WorkBase;
     struct WorkRibOut;
     struct WorkPeer;
+    class Worker;
+
+    // Number of work queue entries a Worker looks at to find one that it
+    // can process in parallel with the other Workers.
+    static const int kMaxWorkScan = 32;
 
     typedef boost::ptr_deque<WorkBase> WorkQueue;
+    typedef std::set<Worker *> WorkerSet;
     typedef IndexMap<IPeerUpdate *, PeerState, GroupPeerSet> PeerStateMap;
     typedef IndexMap<RibOut *, RibState> RibStateMap;
-    class Worker;
 
     class PeerIterator;
 
-    std::auto_ptr<WorkBase> WorkDequeue();
+    std::auto_ptr<WorkBase> WorkDequeue(Worker *worker);
     void WorkEnqueue(WorkBase *wentry);
+    void WorkDone(WorkBase *wentry);
+    void WorkFlush(WorkBase *wentry);
+    void WorkFootprint(WorkBase *wentry);
 
     void UpdateRibOut(RibOut *ribout, int queue_id);
     void UpdatePeer(IPeerUpdate *peer);
@@ -151,13 +167,15 @@ private:
     // The mutex controls access to WorkQueue and related Worker state.
     tbb::mutex mutex_;
     WorkQueue work_queue_;
-    bool running_;
-    Worker *worker_task_;
+    WorkerSet workers_;
+    GroupPeerSet busy_peers_;   // peers in use by a Worker
+    BitSet busy_ribs_;          // RibOut indexes in use by a Worker
 
     PeerStateMap peer_state_imap_;
     RibStateMap rib_state_imap_;
     
     static int send_task_id_;
+    static int max_workers_;
 
     DISALLOW_COPY_AND_ASSIGN(SchedulingGroup);
 };
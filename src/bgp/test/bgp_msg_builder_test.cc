@@ -2,10 +2,13 @@
  * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <stdlib.h>
+
 #include "base/logging.h"
 #include "base/task.h"
 #include "base/task_annotations.h"
 #include "base/test/task_test_util.h"
+#include "base/util.h"
 #include "testing/gunit.h"
 
 #include "bgp/bgp_config.h"
@@ -14,6 +17,8 @@
 #include "bgp/bgp_proto.h"
 #include "bgp/bgp_ribout.h"
 #include "bgp/bgp_server.h"
+#include "bgp/evpn/evpn_route.h"
+#include "bgp/inet/inet_route.h"
 #include "bgp/l3vpn/inetvpn_address.h"
 #include "bgp/l3vpn/inetvpn_route.h"
 #include "bgp/bgp_message_builder.h"
@@ -174,6 +179,118 @@ TEST_F(BgpMsgBuilderTest, Build) {
     delete ext_community;
     delete result;
 }
+
+static Ip4Prefix RandomIp4Prefix() {
+    int plen = rand() % 33;
+    uint32_t addr = (static_cast<uint32_t>(rand()) << 16) ^ rand();
+    if (plen < 32)
+        addr &= ~(0xffffffffU >> plen);
+    return Ip4Prefix(Ip4Address(addr), plen);
+}
+
+static RouteDistinguisher RandomRd() {
+    return RouteDistinguisher((static_cast<uint32_t>(rand()) << 16) ^ rand(),
+                              rand() % 65536);
+}
+
+static MacAddress RandomMac() {
+    uint8_t data[MacAddress::kSize];
+    for (int i = 0; i < MacAddress::kSize; i++) {
+        data[i] = rand() % 256;
+    }
+    return MacAddress(data);
+}
+
+//
+// The direct NLRI encoder must produce the same bytes as the generic
+// BgpProto::Encode based one for every family it handles.
+//
+static void VerifyNlri(const BgpRoute *route, uint32_t label) {
+    uint8_t expected[BgpProto::kMaxMessageSize];
+    uint8_t actual[BgpProto::kMaxMessageSize];
+    int expected_len = BgpMessage::EncodeNlriGeneric(route, label, expected,
+                                                     sizeof(expected));
+    int actual_len = BgpMessage::EncodeNlri(route, label, actual,
+                                            sizeof(actual));
+    ASSERT_GT(expected_len, 0);
+    ASSERT_EQ(expected_len, actual_len) << route->ToString();
+    EXPECT_EQ(0, memcmp(expected, actual, actual_len)) << route->ToString();
+
+    // Short buffers are rejected rather than overrun.
+    EXPECT_LT(BgpMessage::EncodeNlri(route, label, actual, actual_len - 1), 0);
+}
+
+TEST_F(BgpMsgBuilderTest, EncodeNlri) {
+    srand(0x1234);
+    for (int i = 0; i < 1000; i++) {
+        uint32_t label = rand() % (1 << 20);
+
+        InetRoute inet_route(RandomIp4Prefix());
+        VerifyNlri(&inet_route, label);
+
+        Ip4Prefix ip_prefix = RandomIp4Prefix();
+        InetVpnRoute inetvpn_route(InetVpnPrefix(RandomRd(),
+            ip_prefix.ip4_addr(), ip_prefix.prefixlen()));
+        VerifyNlri(&inetvpn_route, label);
+
+        EvpnRoute evpn_route(EvpnPrefix(RandomRd(), RandomMac(),
+                                        RandomIp4Prefix()));
+        VerifyNlri(&evpn_route, label);
+    }
+}
+
+//
+// Encoding rate of the direct NLRI encoder against the generic one.
+//
+// Environment variables:
+//     BGP_NLRI_BENCH_ROUTES - number of inet-vpn routes (default 100000)
+//
+TEST_F(BgpMsgBuilderTest, EncodeNlriBenchmark) {
+    size_t route_count = 100000;
+    char *str = getenv("BGP_NLRI_BENCH_ROUTES");
+    if (str) route_count = strtoul(str, NULL, 0);
+
+    srand(0x4321);
+    vector<InetVpnRoute *> routes;
+    for (size_t i = 0; i < route_count; i++) {
+        Ip4Prefix ip_prefix = RandomIp4Prefix();
+        routes.push_back(new InetVpnRoute(InetVpnPrefix(RandomRd(),
+            ip_prefix.ip4_addr(), ip_prefix.prefixlen())));
+    }
+
+    // Fill whole messages worth of NLRI, as AddRoute does.
+    vector<uint8_t> generic(BgpProto::kMaxMessageSize * 2);
+    vector<uint8_t> direct(BgpProto::kMaxMessageSize * 2);
+    size_t generic_len = 0, direct_len = 0;
+
+    uint64_t t0 = UTCTimestampUsec();
+    for (size_t i = 0; i < route_count; i++) {
+        if (generic_len + 64 > generic.size())
+            generic_len = 0;
+        generic_len += BgpMessage::EncodeNlriGeneric(routes[i], i,
+            &generic[generic_len], generic.size() - generic_len);
+    }
+    uint64_t generic_usecs = UTCTimestampUsec() - t0 + 1;
+
+    t0 = UTCTimestampUsec();
+    for (size_t i = 0; i < route_count; i++) {
+        if (direct_len + 64 > direct.size())
+            direct_len = 0;
+        direct_len += BgpMessage::EncodeNlri(routes[i], i,
+            &direct[direct_len], direct.size() - direct_len);
+    }
+    uint64_t direct_usecs = UTCTimestampUsec() - t0 + 1;
+
+    EXPECT_EQ(generic_len, direct_len);
+    EXPECT_TRUE(generic == direct);
+
+    cout << "routes: " << route_count << endl;
+    cout << "generic nlri/sec: "
+         << route_count * 1000000 / generic_usecs << endl;
+    cout << "direct  nlri/sec: "
+         << route_count * 1000000 / direct_usecs << endl;
+    STLDeleteValues(&routes);
+}
 }  // namespace
 
 static void SetUp() {
@@ -1099,6 +1099,16 @@ TEST_P(BgpPeerCloseTest, ClosePeersWithRouteStaling) {
     WaitForIdle();
     // VerifyXmppRoutes(n_instances_ * n_routes_);
 
+    // All the stale paths have been learned again, nothing is left to sweep
+    BOOST_FOREACH(BgpNullPeer *npeer, peers_) {
+        TASK_UTIL_EXPECT_EQ(0, npeer->peer()->peer_close()->close_manager()->
+                                   stale_path_count());
+    }
+    BOOST_FOREACH(BgpXmppChannel *peer, xmpp_peers_) {
+        TASK_UTIL_EXPECT_EQ(0, peer->Peer()->peer_close()->close_manager()->
+                                   stale_path_count());
+    }
+
     // Invoke stale timer callbacks as evm is not running in this unit test
     CallStaleTimer(true);
 
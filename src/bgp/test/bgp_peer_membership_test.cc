@@ -375,6 +375,42 @@ TEST_F(PeerMembershipMgrTest, MultiplePeersSingleTable) {
     TASK_UTIL_EXPECT_TRUE(size() == 0);
 }
 
+// Pending register and unregister requests of different peers for the same
+// table are served by a single walk.
+TEST_F(PeerMembershipMgrTest, CombinedWalk) {
+    PeerRibMembershipManager *mgr = server()->membership_mgr();
+
+    // Make sure we start out clean.
+    ASSERT_EQ(size(), 0);
+
+    // Register peers 0 and 1.
+    mgr->Register(peers_[0], red_tbl_, peers_[0]->GetRibExportPolicy(), -1);
+    mgr->Register(peers_[1], red_tbl_, peers_[1]->GetRibExportPolicy(), -1);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(2, size());
+
+    // Unregister peer 0 and register peer 2 while the queue is stopped.
+    static_cast<PeerRibMembershipManagerTest *>(mgr)->SetQueueDisable(true);
+    uint64_t walk_count = mgr->walk_count();
+    mgr->Unregister(peers_[0], red_tbl_);
+    mgr->Register(peers_[2], red_tbl_, peers_[2]->GetRibExportPolicy(), -1);
+    EXPECT_EQ(2U, mgr->GetPendingRequestCount());
+
+    static_cast<PeerRibMembershipManagerTest *>(mgr)->SetQueueDisable(false);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(2, size());
+    EXPECT_TRUE(mgr->IPeerRibFind(peers_[0], red_tbl_) == NULL);
+    EXPECT_TRUE(mgr->IPeerRibFind(peers_[2], red_tbl_) != NULL);
+    EXPECT_EQ(walk_count + 1, mgr->walk_count());
+    EXPECT_EQ(0U, mgr->GetPendingRequestCount());
+
+    // Unregister all peers.
+    mgr->Unregister(peers_[1], red_tbl_);
+    mgr->Unregister(peers_[2], red_tbl_);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(0, size());
+}
+
 // Delete a peer with membership request pending
 TEST_F(PeerMembershipMgrTest, PeerDeleteWithPendingMembershipRequestPending) {
     PeerRibMembershipManager *mgr = server()->membership_mgr();
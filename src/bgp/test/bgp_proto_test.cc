@@ -376,6 +376,96 @@ TEST_F(BgpProtoTest, EvpnUpdate) {
     }
 }
 
+// Prefixes of a section, as (prefixlen, bytes) pairs.
+static vector<pair<int, vector<uint8_t> > > ReadPrefixes(
+        const vector<BgpProtoPrefix *> &prefixes, const vector<uint8_t> &raw,
+        bool evpn) {
+    vector<pair<int, vector<uint8_t> > > result;
+    BgpProtoPrefixReader reader(prefixes, raw, evpn);
+    for (const BgpProtoPrefix *prefix = reader.Next(); prefix != NULL;
+         prefix = reader.Next()) {
+        result.push_back(make_pair(prefix->prefixlen, prefix->prefix));
+    }
+    return result;
+}
+
+static const BgpMpNlri *FindMpNlri(const BgpProto::Update *update) {
+    for (size_t i = 0; i < update->path_attributes.size(); i++) {
+        const BgpAttribute *attr = update->path_attributes[i];
+        if (attr->code == BgpAttribute::MPReachNlri ||
+            attr->code == BgpAttribute::MPUnreachNlri)
+            return static_cast<const BgpMpNlri *>(attr);
+    }
+    return NULL;
+}
+
+// DecodeUpdate must yield the same prefixes and attributes as Decode.
+TEST_F(BgpProtoTest, DecodeUpdate) {
+    uint16_t afi[] = { BgpAf::IPv4, BgpAf::IPv4, BgpAf::L2Vpn };
+    uint8_t safi[] = { BgpAf::Unicast, BgpAf::Vpn, BgpAf::EVpn };
+    for (size_t i = 0; i < sizeof(afi) / sizeof(afi[0]); i++) {
+        BgpProto::Update update;
+        BgpMessageTest::GenerateUpdateMessage(&update, afi[i], safi[i]);
+        uint8_t data[256];
+        int res = BgpProto::Encode(&update, data, 256);
+        ASSERT_NE(-1, res);
+
+        auto_ptr<const BgpProto::Update> expected(
+            static_cast<const BgpProto::Update *>(BgpProto::Decode(data, res)));
+        ASSERT_TRUE(expected.get() != NULL);
+        auto_ptr<const BgpProto::Update> result(
+            BgpProto::DecodeUpdate(data, res));
+        ASSERT_TRUE(result.get() != NULL);
+
+        EXPECT_TRUE(result->withdrawn_routes.empty());
+        EXPECT_TRUE(result->nlri.empty());
+        EXPECT_EQ(ReadPrefixes(expected->withdrawn_routes,
+                               expected->raw_withdrawn_routes, false),
+                  ReadPrefixes(result->withdrawn_routes,
+                               result->raw_withdrawn_routes, false));
+        EXPECT_EQ(ReadPrefixes(expected->nlri, expected->raw_nlri, false),
+                  ReadPrefixes(result->nlri, result->raw_nlri, false));
+        ASSERT_EQ(expected->path_attributes.size(),
+                  result->path_attributes.size());
+
+        const BgpMpNlri *expected_mp = FindMpNlri(expected.get());
+        const BgpMpNlri *result_mp = FindMpNlri(result.get());
+        ASSERT_TRUE(expected_mp != NULL);
+        ASSERT_TRUE(result_mp != NULL);
+        EXPECT_TRUE(result_mp->nlri.empty());
+        EXPECT_EQ(expected_mp->afi, result_mp->afi);
+        EXPECT_EQ(expected_mp->safi, result_mp->safi);
+        EXPECT_EQ(expected_mp->nexthop, result_mp->nexthop);
+        bool evpn = (afi[i] == BgpAf::L2Vpn);
+        EXPECT_EQ(ReadPrefixes(expected_mp->nlri, expected_mp->raw_nlri, evpn),
+                  ReadPrefixes(result_mp->nlri, result_mp->raw_nlri, evpn));
+    }
+}
+
+// Malformed messages are left to Decode.
+TEST_F(BgpProtoTest, DecodeUpdateError) {
+    BgpProto::Update update;
+    BgpMessageTest::GenerateUpdateMessage(&update, BgpAf::IPv4, BgpAf::Unicast);
+    uint8_t data[256];
+    int res = BgpProto::Encode(&update, data, 256);
+    ASSERT_NE(-1, res);
+
+    // Truncated message.
+    EXPECT_TRUE(BgpProto::DecodeUpdate(data, res - 1) == NULL);
+
+    // Withdrawn routes length beyond the end of the message.
+    uint8_t copy[256];
+    memcpy(copy, data, res);
+    put_value(copy + BgpProto::kMinMessageSize, 2, res);
+    EXPECT_TRUE(BgpProto::DecodeUpdate(copy, res) == NULL);
+
+    // Not an UPDATE.
+    BgpProto::Keepalive keepalive;
+    res = BgpProto::Encode(&keepalive, data, 256);
+    ASSERT_NE(-1, res);
+    EXPECT_TRUE(BgpProto::DecodeUpdate(data, res) == NULL);
+}
+
 TEST_F(BgpProtoTest, OpenError) {
 
     uint8_t data[] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
@@ -12,6 +12,7 @@
 #include "bgp/bgp_log.h"
 #include "bgp/bgp_path.h"
 #include "bgp/bgp_server.h"
+#include "bgp/bgp_table.h"
 #include "bgp/inet/inet_route.h"
 #include "control-node/control_node.h"
 #include "io/event_manager.h"
@@ -134,6 +135,43 @@ TEST_F(BgpRouteTest, Paths) {
     route.RemovePath(&peer);
 }
 
+// Paths inserted in any order must end up where a full sort puts them.
+TEST_F(BgpRouteTest, SortedInsert) {
+    BgpAttrDB *db = server_.attr_db();
+    std::vector<BgpAttrPtr> attrs;
+    for (int i = 0; i < 3; i++) {
+        BgpAttrSpec spec;
+        BgpAttrLocalPref local_pref(100 * (i + 1));
+        spec.push_back(&local_pref);
+        attrs.push_back(db->Locate(spec));
+    }
+
+    // Higher local pref first, lower path id first among equals.
+    Ip4Prefix prefix;
+    InetRoute route(prefix);
+    const uint32_t kPaths = 30;
+    for (uint32_t i = 0; i < kPaths; i++) {
+        uint32_t path_id = (i * 7) % kPaths + 1;
+        BgpPath *path = new BgpPath(path_id, BgpPath::StaticRoute,
+                                    attrs[path_id % 3], 0, 0);
+        route.InsertPath(path);
+    }
+    EXPECT_EQ(kPaths, route.count());
+
+    while (route.count() > 0) {
+        const Path *prev = NULL;
+        for (Route::PathList::const_iterator it =
+             route.GetPathList().begin(); it != route.GetPathList().end();
+             ++it) {
+            if (prev) {
+                EXPECT_TRUE(BgpTable::PathSelection(*prev, *it));
+            }
+            prev = it.operator->();
+        }
+        route.DeletePath(const_cast<BgpPath *>(route.BestPath()));
+    }
+}
+
 }  // namespace
 
 static void SetUp() {
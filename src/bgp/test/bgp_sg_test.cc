@@ -54,7 +54,7 @@ static const int kPeerCount = 4;
 
 class BgpTestPeer : public IPeerUpdate {
 public:
-    BgpTestPeer() : index_(gbl_peer_index++) { }
+    BgpTestPeer() : index_(gbl_peer_index++), flush_blocked_(false) { }
     virtual ~BgpTestPeer() { }
 
     virtual std::string ToString() const {
@@ -67,8 +67,15 @@ public:
         return true;
     }
 
+    virtual bool FlushUpdate() {
+        return !flush_blocked_;
+    }
+
+    void set_flush_blocked(bool blocked) { flush_blocked_ = blocked; }
+
 private:
     int index_;
+    bool flush_blocked_;
 };
 
 class SGTest : public ::testing::Test {
@@ -378,6 +385,43 @@ TEST_F(SGTest, TailDequeueAllBlock1) {
     VerifyPeerBlock(0, kPeerCount-1, true);
 }
 
+//
+// Peers that get blocked when their batched updates are flushed are marked
+// blocked and out of sync. They get back in sync once they are send ready.
+//
+TEST_F(SGTest, TailDequeueFlushBlock) {
+    RibPeerSet peerset;
+    BuildPeerSet(peerset, 0, 0, kPeerCount-1);
+    for (int idx = 0; idx < kPeerCount; idx += 2) {
+        peers_[idx]->set_flush_blocked(true);
+    }
+
+    // Expect 1 call to TailDequeue which blocks no peer.
+    EXPECT_CALL(*updates_[0],
+        TailDequeue(RibOutUpdates::QUPDATE, peerset,
+                    Property(&RibPeerSet::empty, true)))
+        .Times(1)
+        .WillOnce(Return(true));
+
+    RibOutActive(ribouts_[0], RibOutUpdates::QUPDATE);
+
+    // Verify that the even peers are blocked by the flush.
+    task_util::WaitForIdle();
+    VerifyEvenPeerBlock(0, kPeerCount-1, true);
+    VerifyEvenPeerInSync(0, kPeerCount-1, false);
+    VerifyOddPeerBlock(0, kPeerCount-1, false);
+    VerifyOddPeerInSync(0, kPeerCount-1, true);
+
+    // Unblock the even peers and verify that they get back in sync.
+    for (int idx = 0; idx < kPeerCount; idx += 2) {
+        peers_[idx]->set_flush_blocked(false);
+    }
+    SetEvenPeerUnblockNow(0, kPeerCount-1);
+    task_util::WaitForIdle();
+    VerifyPeerBlock(0, kPeerCount-1, false);
+    VerifyEvenPeerInSync(0, kPeerCount-1, true);
+}
+
 //
 // Setting the blocked mask to include all peers during TailDequeue for one
 // qid causes TailDequeue for the next qid to be invoked with an empty msync
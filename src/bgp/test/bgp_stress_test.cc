@@ -2949,6 +2949,37 @@ void BgpStressTest::InitParams() {
     xmpp_close_from_control_node_ = ::std::tr1::get<5>(GetParam());
 }
 
+//
+// Measure how fast routes fed by the agents get advertised to all the
+// agents. All the agents subscribe to all the instances, which puts their
+// RibOuts in a single scheduling group. Run with different values of
+// BGP_SCHEDULING_GROUP_WORKERS to see the update throughput scale with the
+// number of cores.
+//
+TEST_P(BgpStressTest, UpdateThroughput) {
+    SCOPED_TRACE(__FUNCTION__);
+    InitParams();
+
+    AddRoutingInstances(n_instances_, n_targets_);
+    BringUpXmppAgents(n_agents_);
+    SubscribeAgents(n_instances_, n_agents_);
+
+    uint64_t start = UTCTimestampUsec();
+    AddAllXmppRoutes(n_instances_, n_agents_, n_routes_);
+    VerifyAgentRoutes(n_agents_, n_instances_,
+                      n_instances_ * n_agents_ * n_routes_);
+    uint64_t elapsed = UTCTimestampUsec() - start + 1;
+
+    size_t count = GetAllAgentRouteCount(n_agents_, n_instances_);
+    const char *workers = getenv("BGP_SCHEDULING_GROUP_WORKERS");
+    cout << "workers: " << (workers ? workers : "default")
+         << " routes: " << count << " usecs: " << elapsed
+         << " routes/sec: " << count * 1000000 / elapsed << endl;
+
+    DeleteAllXmppRoutes(n_instances_, n_agents_, n_routes_);
+    VerifyAgentRoutes(n_agents_, n_instances_, 0);
+}
+
 #define COMBINE_PARAMS \
     Combine(ValuesIn(GetInstanceParameters()),                      \
             ValuesIn(GetRouteParameters()),                         \
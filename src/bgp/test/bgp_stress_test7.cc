@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "bgp_stress_test.cc"
+
+// Update throughput with many agents in one scheduling group.
+int main(int argc, char **argv) {
+
+    // Give more time for TASK_UTIL_EXPECT_* to timeout.
+    setenv("TASK_UTIL_RETRY_COUNT", "60000", false);
+    setenv("TASK_UTIL_DEFAULT_WAIT_TIME", "10000", false);
+    setenv("WAIT_FOR_IDLE", "120", false);
+
+    const char *largv[] = {
+        __FILE__, "--log-disable",
+        "--gtest_filter=*UpdateThroughput*",
+
+        "--nagents=16",
+        "--nroutes=1000",
+        "--ninstances=4",
+        "--npeers=0",
+    };
+
+    return bgp_stress_test_main(sizeof(largv)/sizeof(largv[0]), largv);
+}
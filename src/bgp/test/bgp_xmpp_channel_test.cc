@@ -47,6 +47,11 @@ public:
     bool Send(const uint8_t *, size_t, xmps::PeerId, SendReadyCb) {
         return true;
     }
+    bool SendBatch(const uint8_t *, size_t, xmps::PeerId, SendReadyCb) {
+        return true;
+    }
+    void SetBatchSend(size_t) { }
+    bool Flush(SendReadyCb) { return true; }
     MOCK_METHOD2(RegisterReceive, void(xmps::PeerId, ReceiveCb));
     MOCK_METHOD1(UnRegisterReceive, void(xmps::PeerId));
     std::string ToString() const { return string("fake"); }
@@ -219,6 +219,41 @@ TEST_F(RibOutAttributesTest, Paths) {
     (void) route.RemovePath(&peer3);
 }
 
+// RibOutAttrs with the same attributes and nexthops share the interned
+// RibOutAttrData.
+TEST_F(RibOutAttributesTest, Interning) {
+    RibOutAttrDB *db = RibOutAttrDB::GetInstance();
+    size_t size = db->Size();
+
+    BgpAttrSpec spec;
+    BgpAttrNextHop nexthop(0x01010101);
+    spec.push_back(&nexthop);
+    BgpAttrPtr attr = server_.attr_db()->Locate(spec);
+
+    {
+    RibOutAttr roattr1(attr.get(), 100);
+    RibOutAttr roattr2(attr.get(), 100);
+    RibOutAttr roattr3(attr.get(), 200);
+    EXPECT_TRUE(roattr1 == roattr2);
+    EXPECT_TRUE(roattr1 != roattr3);
+    EXPECT_EQ(&roattr1.nexthop_list(), &roattr2.nexthop_list());
+    EXPECT_EQ(size + 2, db->Size());
+
+    RibOutAttr roattr4 = roattr3;
+    roattr4.set_attr(attr, 300);
+    EXPECT_TRUE(roattr3 == roattr4);
+    EXPECT_EQ(200U, roattr4.label());
+
+    roattr4.clear();
+    EXPECT_FALSE(roattr4.IsReachable());
+    EXPECT_TRUE(roattr4.nexthop_list().empty());
+    EXPECT_EQ(0U, roattr4.label());
+    EXPECT_EQ(size + 2, db->Size());
+    }
+
+    EXPECT_EQ(size, db->Size());
+}
+
 }  // namespace
 
 static void SetUp() {
@@ -4,6 +4,8 @@
 
 #include "bgp/routing-instance/routepath_replicator.h"
 
+#include <sstream>
+
 #include <boost/foreach.hpp>
 #include <boost/assign/list_of.hpp>
 
@@ -16,6 +18,7 @@
 #include "bgp/routing-instance/routing_instance.h"
 #include "bgp/test/bgp_test_util.h"
 #include "control-node/control_node.h"
+#include "db/db.h"
 #include "db/db_graph.h"
 #include "db/test/db_test_util.h"
 #include "ifmap/ifmap_link_table.h"
@@ -947,6 +950,103 @@ TEST_F(ReplicationTest, ConnectNetwork) {
     VERIFY_EQ(0, RouteCount("green"));
 }
 
+// Import changes only re-evaluate the routes with the affected targets.
+TEST_F(ReplicationTest, ConnectNetworkNoWalk) {
+    vector<string> instance_names = list_of("blue")("red")("green");
+    multimap<string, string> connections = map_list_of("blue", "red");
+    NetworkConfig(instance_names, connections);
+    task_util::WaitForIdle();
+
+    error_code ec;
+    peers_.push_back(
+        new BgpPeerMock(Ip4Address::from_string("192.168.0.1", ec)));
+
+    // VPN routes with target "blue".
+    AddVPNRoute(peers_[0], "192.168.0.1:1:10.0.1.1/32", 100, list_of("blue"));
+    AddVPNRoute(peers_[0], "192.168.0.1:1:10.0.1.2/32", 100, list_of("blue"));
+    task_util::WaitForIdle();
+    VERIFY_EQ(2, RouteCount("blue"));
+    VERIFY_EQ(2, RouteCount("red"));
+    VERIFY_EQ(0, RouteCount("green"));
+
+    DBTableWalker *walker = bgp_server_->database()->GetWalker();
+    uint64_t walk_count = walker->walk_request_count();
+
+    ifmap_test_util::IFMapMsgLink(&config_db_,
+                                    "routing-instance", "blue",
+                                    "routing-instance", "green",
+                                    "connection");
+    task_util::WaitForIdle();
+    VERIFY_EQ(2, RouteCount("green"));
+
+    ifmap_test_util::IFMapMsgUnlink(&config_db_,
+                                    "routing-instance", "blue",
+                                    "routing-instance", "green",
+                                    "connection");
+    task_util::WaitForIdle();
+    VERIFY_EQ(2, RouteCount("blue"));
+    VERIFY_EQ(2, RouteCount("red"));
+    VERIFY_EQ(0, RouteCount("green"));
+    EXPECT_EQ(walk_count, walker->walk_request_count());
+
+    DeleteVPNRoute(peers_[0], "192.168.0.1:1:10.0.1.1/32");
+    DeleteVPNRoute(peers_[0], "192.168.0.1:1:10.0.1.2/32");
+    task_util::WaitForIdle();
+    VERIFY_EQ(0, RouteCount("blue"));
+    VERIFY_EQ(0, RouteCount("red"));
+}
+
+// Import changes that affect more routes than are re-evaluated in one run
+// of the walk trigger.
+TEST_F(ReplicationTest, ConnectNetworkManyRoutes) {
+    vector<string> instance_names = list_of("blue")("red")("green");
+    multimap<string, string> connections = map_list_of("blue", "red");
+    NetworkConfig(instance_names, connections);
+    task_util::WaitForIdle();
+
+    error_code ec;
+    peers_.push_back(
+        new BgpPeerMock(Ip4Address::from_string("192.168.0.1", ec)));
+
+    // VPN routes with target "blue".
+    const int kRouteCount = 1200;
+    vector<string> prefixes;
+    for (int i = 0; i < kRouteCount; i++) {
+        ostringstream oss;
+        oss << "192.168.0.1:1:10.0." << (i / 256) << "." << (i % 256)
+            << "/32";
+        prefixes.push_back(oss.str());
+        AddVPNRoute(peers_[0], oss.str(), 100, list_of("blue"));
+    }
+    task_util::WaitForIdle();
+    VERIFY_EQ(kRouteCount, RouteCount("blue"));
+    VERIFY_EQ(kRouteCount, RouteCount("red"));
+    VERIFY_EQ(0, RouteCount("green"));
+
+    ifmap_test_util::IFMapMsgLink(&config_db_,
+                                    "routing-instance", "blue",
+                                    "routing-instance", "green",
+                                    "connection");
+    task_util::WaitForIdle();
+    VERIFY_EQ(kRouteCount, RouteCount("green"));
+
+    ifmap_test_util::IFMapMsgUnlink(&config_db_,
+                                    "routing-instance", "blue",
+                                    "routing-instance", "green",
+                                    "connection");
+    task_util::WaitForIdle();
+    VERIFY_EQ(kRouteCount, RouteCount("blue"));
+    VERIFY_EQ(kRouteCount, RouteCount("red"));
+    VERIFY_EQ(0, RouteCount("green"));
+
+    BOOST_FOREACH(const string &prefix, prefixes) {
+        DeleteVPNRoute(peers_[0], prefix);
+    }
+    task_util::WaitForIdle();
+    VERIFY_EQ(0, RouteCount("blue"));
+    VERIFY_EQ(0, RouteCount("red"));
+}
+
 TEST_F(ReplicationTest, DeleteNetwork) {
     vector<string> instance_names = list_of("blue")("red")("green");
     multimap<string, string> connections = map_list_of("blue", "red");
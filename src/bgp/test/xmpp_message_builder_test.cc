@@ -0,0 +1,466 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "bgp/xmpp_message_builder.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sstream>
+#include <boost/foreach.hpp>
+#include <pugixml/pugixml.hpp>
+
+#include "base/logging.h"
+#include "base/task.h"
+#include "base/test/task_test_util.h"
+#include "base/util.h"
+#include "bgp/bgp_attr.h"
+#include "bgp/bgp_config.h"
+#include "bgp/bgp_log.h"
+#include "bgp/bgp_ribout.h"
+#include "bgp/bgp_server.h"
+#include "bgp/enet/enet_route.h"
+#include "bgp/inet/inet_route.h"
+#include "bgp/inetmcast/inetmcast_route.h"
+#include "bgp/routing-instance/routing_instance.h"
+#include "bgp/security_group/security_group.h"
+#include "bgp/tunnel_encap/tunnel_encap.h"
+#include "control-node/control_node.h"
+#include "ifmap/autogen.h"
+#include "io/event_manager.h"
+#include "schema/xmpp_unicast_types.h"
+#include "testing/gunit.h"
+#include "xmpp/xmpp_init.h"
+
+using namespace std;
+
+namespace {
+
+class PeerUpdateMock : public IPeerUpdate {
+public:
+    virtual std::string ToString() const { return "agent-a"; }
+    virtual bool SendUpdate(const uint8_t *msg, size_t msgsize) {
+        return true;
+    }
+};
+
+//
+// The benchmark is disabled by default, run it with
+// --gtest_also_run_disabled_tests.
+//
+// Environment variables for the benchmark:
+//     XMPP_BENCH_ROUTES - number of routes in the message (default 10000)
+//
+class XmppMsgBuilderTest : public ::testing::Test {
+protected:
+    XmppMsgBuilderTest()
+        : server_(&evm_),
+          instance_config_(BgpConfigManager::kMasterInstance),
+          blue_config_("blue"),
+          blue_(NULL),
+          table_(NULL) {
+        route_count_ = 10000;
+        char *str = getenv("XMPP_BENCH_ROUTES");
+        if (str) route_count_ = strtoul(str, NULL, 0);
+    }
+
+    virtual void SetUp() {
+        ConcurrencyScope scope("bgp::Config");
+        RoutingInstance *rti =
+            server_.routing_instance_mgr()->CreateRoutingInstance(
+                &instance_config_);
+        table_ = rti->GetTable(Address::INET);
+        blue_ = server_.routing_instance_mgr()->CreateRoutingInstance(
+            &blue_config_);
+
+        BgpAttrSpec spec;
+        BgpAttrNextHop nexthop(0x0a0b0c0d);
+        spec.push_back(&nexthop);
+        ExtCommunitySpec ext_community;
+        ext_community.communities.push_back(
+            SecurityGroup(64512, 100).GetExtCommunityValue());
+        ext_community.communities.push_back(
+            SecurityGroup(64512, 200).GetExtCommunityValue());
+        ext_community.communities.push_back(
+            TunnelEncap("udp").GetExtCommunityValue());
+        spec.push_back(&ext_community);
+        attr_ = server_.attr_db()->Locate(spec);
+
+        BgpOList *olist = new BgpOList();
+        vector<string> encap;
+        encap.push_back("gre");
+        olist->elements.push_back(
+            BgpOListElem(Ip4Address::from_string("10.1.1.1"), 2000, encap));
+        olist->elements.push_back(
+            BgpOListElem(Ip4Address::from_string("10.1.1.2"), 2001, encap));
+        BgpAttrOList olist_attr(olist);
+        spec.push_back(&olist_attr);
+        mcast_attr_ = server_.attr_db()->Locate(spec);
+    }
+
+    virtual void TearDown() {
+        attr_.reset();
+        mcast_attr_.reset();
+        STLDeleteValues(&routes_);
+        server_.Shutdown();
+        task_util::WaitForIdle();
+    }
+
+    void AddRoutes(size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            Ip4Prefix prefix(Ip4Address(0x14000000 + i), 32);
+            routes_.push_back(new InetRoute(prefix));
+        }
+    }
+
+    void AddEnetRoutes(size_t count) {
+        table_ = blue_->GetTable(Address::ENET);
+        for (size_t i = 0; i < count; i++) {
+            char mac[32];
+            snprintf(mac, sizeof(mac), "00:01:02:03:04:%02x", int(i));
+            EnetPrefix prefix(MacAddress::FromString(mac),
+                Ip4Prefix(Ip4Address(0x14000000 + i), 32));
+            routes_.push_back(new EnetRoute(prefix));
+        }
+    }
+
+    void AddMcastRoutes(size_t count) {
+        table_ = blue_->GetTable(Address::INETMCAST);
+        for (size_t i = 0; i < count; i++) {
+            InetMcastPrefix prefix(RouteDistinguisher(),
+                Ip4Address(0xe0010100 + i), Ip4Address(0x0a010101));
+            routes_.push_back(new InetMcastRoute(prefix));
+        }
+    }
+
+    string BuildMessage(const RibOutAttr *roattr) {
+        Message *message = BgpXmppMessageBuilder::GetInstance()->Create(
+            table_, roattr, routes_[0]);
+        for (size_t i = 1; i < routes_.size(); i++) {
+            message->AddRoute(routes_[i], roattr);
+        }
+        message->Finish();
+        size_t length;
+        const uint8_t *data = message->GetData(&peer_, &length);
+        string result(reinterpret_cast<const char *>(data), length);
+        delete message;
+        return result;
+    }
+
+    // The pugixml DOM based encoding the streaming writer replaced.
+    string BuildDomMessage(const RibOutAttr *roattr) {
+        pugi::xml_document xdoc;
+        pugi::xml_node message = xdoc.append_child("message");
+        message.append_attribute("from") = XmppInit::kControlNodeJID;
+        message.append_attribute("to") = "agent-a/bgp-peer";
+        pugi::xml_node event = message.append_child("event");
+        event.append_attribute("xmlns") = "http://jabber.org/protocol/pubsub";
+        pugi::xml_node items = event.append_child("items");
+        string node_name =
+            "1/1/" + table_->routing_instance()->name();
+        items.append_attribute("node") = node_name.c_str();
+        BOOST_FOREACH(const BgpRoute *route, routes_) {
+            autogen::ItemType item;
+            item.entry.nlri.af = route->Afi();
+            item.entry.nlri.safi = route->Safi();
+            item.entry.nlri.address = route->ToString();
+            item.entry.version = 1;
+            item.entry.virtual_network = "unresolved";
+            BOOST_FOREACH(const RibOutAttr::NextHop &nexthop,
+                          roattr->nexthop_list()) {
+                autogen::NextHopType item_nexthop;
+                item_nexthop.af = route->Afi();
+                item_nexthop.address = nexthop.address().to_v4().to_string();
+                item_nexthop.label = nexthop.label();
+                item_nexthop.tunnel_encapsulation_list.tunnel_encapsulation =
+                    nexthop.encap();
+                item.entry.next_hops.next_hop.push_back(item_nexthop);
+            }
+            item.entry.security_group_list.security_group.push_back(100);
+            item.entry.security_group_list.security_group.push_back(200);
+            pugi::xml_node node = items.append_child("item");
+            node.append_attribute("id") = route->ToXmppIdString().c_str();
+            item.Encode(&node);
+        }
+        ostringstream oss;
+        xdoc.save(oss);
+        return oss.str();
+    }
+
+    // Parse the message and return the items node.
+    pugi::xml_node ParseItems(const string &data) {
+        pugi::xml_parse_result result = xdoc_.load(data.c_str());
+        EXPECT_TRUE(result);
+        pugi::xml_node message = xdoc_.child("message");
+        EXPECT_STREQ(XmppInit::kControlNodeJID,
+                     message.attribute("from").value());
+        EXPECT_STREQ("agent-a/bgp-peer", message.attribute("to").value());
+        pugi::xml_node event = message.child("event");
+        EXPECT_STREQ("http://jabber.org/protocol/pubsub",
+                     event.attribute("xmlns").value());
+        return event.child("items");
+    }
+
+    EventManager evm_;
+    BgpServer server_;
+    BgpInstanceConfig instance_config_;
+    BgpInstanceConfig blue_config_;
+    RoutingInstance *blue_;
+    BgpTable *table_;
+    BgpAttrPtr attr_;
+    BgpAttrPtr mcast_attr_;
+    PeerUpdateMock peer_;
+    vector<BgpRoute *> routes_;
+    pugi::xml_document xdoc_;
+    size_t route_count_;
+};
+
+TEST_F(XmppMsgBuilderTest, Reach) {
+    AddRoutes(100);
+    RibOutAttr roattr(attr_.get(), 1000);
+    string data = BuildMessage(&roattr);
+
+    pugi::xml_node items = ParseItems(data);
+    auto_ptr<AutogenProperty> xparser(new AutogenProperty());
+    ASSERT_TRUE(autogen::ItemsType::XmlParseProperty(items, &xparser));
+    autogen::ItemsType *result =
+        static_cast<autogen::ItemsType *>(xparser.get());
+    ASSERT_EQ(routes_.size(), result->item.size());
+
+    size_t idx = 0;
+    for (pugi::xml_node node = items.first_child(); node;
+         node = node.next_sibling(), idx++) {
+        EXPECT_STREQ("item", node.name());
+        EXPECT_EQ(routes_[idx]->ToXmppIdString(),
+                  node.attribute("id").value());
+
+        const autogen::EntryType &entry = result->item[idx].entry;
+        EXPECT_EQ(BgpAf::IPv4, entry.nlri.af);
+        EXPECT_EQ(BgpAf::Unicast, entry.nlri.safi);
+        EXPECT_EQ(routes_[idx]->ToString(), entry.nlri.address);
+        EXPECT_EQ(1, entry.version);
+        EXPECT_EQ("unresolved", entry.virtual_network);
+        ASSERT_EQ(1U, entry.next_hops.next_hop.size());
+        const autogen::NextHopType &nexthop = entry.next_hops.next_hop[0];
+        EXPECT_EQ(BgpAf::IPv4, nexthop.af);
+        EXPECT_EQ("10.11.12.13", nexthop.address);
+        EXPECT_EQ(1000, nexthop.label);
+        ASSERT_EQ(1U,
+            nexthop.tunnel_encapsulation_list.tunnel_encapsulation.size());
+        EXPECT_EQ("udp",
+            nexthop.tunnel_encapsulation_list.tunnel_encapsulation[0]);
+        ASSERT_EQ(2U, entry.security_group_list.security_group.size());
+        EXPECT_EQ(100, entry.security_group_list.security_group[0]);
+        EXPECT_EQ(200, entry.security_group_list.security_group[1]);
+    }
+    EXPECT_EQ(routes_.size(), idx);
+}
+
+TEST_F(XmppMsgBuilderTest, Unreach) {
+    AddRoutes(10);
+    RibOutAttr roattr;
+    string data = BuildMessage(&roattr);
+
+    pugi::xml_node items = ParseItems(data);
+    size_t idx = 0;
+    for (pugi::xml_node node = items.first_child(); node;
+         node = node.next_sibling(), idx++) {
+        EXPECT_STREQ("retract", node.name());
+        EXPECT_EQ(routes_[idx]->ToXmppIdString(),
+                  node.first_attribute().value());
+    }
+    EXPECT_EQ(routes_.size(), idx);
+}
+
+// The streaming writer must carry the same items as the DOM encoding.
+TEST_F(XmppMsgBuilderTest, DomEncoding) {
+    AddRoutes(100);
+    RibOutAttr roattr(attr_.get(), 1000);
+    string dom_data = BuildDomMessage(&roattr);
+    string data = BuildMessage(&roattr);
+
+    pugi::xml_node items = ParseItems(data);
+    auto_ptr<AutogenProperty> xparser(new AutogenProperty());
+    ASSERT_TRUE(autogen::ItemsType::XmlParseProperty(items, &xparser));
+    autogen::ItemsType *result =
+        static_cast<autogen::ItemsType *>(xparser.get());
+
+    pugi::xml_document dom_xdoc;
+    ASSERT_TRUE(dom_xdoc.load(dom_data.c_str()));
+    pugi::xml_node dom_items =
+        dom_xdoc.child("message").child("event").child("items");
+    EXPECT_STREQ(dom_items.attribute("node").value(),
+                 items.attribute("node").value());
+    auto_ptr<AutogenProperty> dom_xparser(new AutogenProperty());
+    ASSERT_TRUE(autogen::ItemsType::XmlParseProperty(dom_items, &dom_xparser));
+    autogen::ItemsType *dom_result =
+        static_cast<autogen::ItemsType *>(dom_xparser.get());
+
+    ASSERT_EQ(dom_result->item.size(), result->item.size());
+    for (size_t i = 0; i < result->item.size(); i++) {
+        const autogen::EntryType &entry = result->item[i].entry;
+        const autogen::EntryType &dom_entry = dom_result->item[i].entry;
+        EXPECT_EQ(dom_entry.nlri.address, entry.nlri.address);
+        EXPECT_EQ(dom_entry.next_hops.next_hop[0].address,
+                  entry.next_hops.next_hop[0].address);
+        EXPECT_EQ(dom_entry.next_hops.next_hop[0].label,
+                  entry.next_hops.next_hop[0].label);
+        EXPECT_EQ(dom_entry.security_group_list.security_group,
+                  entry.security_group_list.security_group);
+    }
+}
+
+TEST_F(XmppMsgBuilderTest, EnetReach) {
+    AddEnetRoutes(10);
+    RibOutAttr roattr(attr_.get(), 1000);
+    string data = BuildMessage(&roattr);
+
+    pugi::xml_node items = ParseItems(data);
+    EXPECT_STREQ("25/242/blue", items.attribute("node").value());
+    size_t idx = 0;
+    for (pugi::xml_node node = items.first_child(); node;
+         node = node.next_sibling(), idx++) {
+        EXPECT_STREQ("item", node.name());
+        EXPECT_EQ(routes_[idx]->ToXmppIdString(),
+                  node.attribute("id").value());
+
+        const EnetRoute *route = static_cast<const EnetRoute *>(routes_[idx]);
+        pugi::xml_node entry = node.child("entry");
+        pugi::xml_node nlri = entry.child("nlri");
+        EXPECT_EQ(BgpAf::L2Vpn, nlri.child("af").text().as_int());
+        EXPECT_EQ(BgpAf::Enet, nlri.child("safi").text().as_int());
+        EXPECT_EQ(route->GetPrefix().mac_addr().ToString(),
+                  nlri.child("mac").text().get());
+        EXPECT_EQ(route->GetPrefix().ip_prefix().ToString(),
+                  nlri.child("address").text().get());
+
+        pugi::xml_node nexthop = entry.child("next-hops").child("next-hop");
+        ASSERT_TRUE(nexthop);
+        EXPECT_FALSE(nexthop.next_sibling("next-hop"));
+        EXPECT_EQ(BgpAf::IPv4, nexthop.child("af").text().as_int());
+        EXPECT_STREQ("10.11.12.13", nexthop.child("address").text().get());
+        EXPECT_EQ(1000, nexthop.child("label").text().as_int());
+        pugi::xml_node encap = nexthop.child("tunnel-encapsulation-list")
+            .child("tunnel-encapsulation");
+        EXPECT_STREQ("udp", encap.text().get());
+        EXPECT_FALSE(encap.next_sibling());
+    }
+    EXPECT_EQ(routes_.size(), idx);
+}
+
+TEST_F(XmppMsgBuilderTest, EnetUnreach) {
+    AddEnetRoutes(10);
+    RibOutAttr roattr;
+    string data = BuildMessage(&roattr);
+
+    pugi::xml_node items = ParseItems(data);
+    size_t idx = 0;
+    for (pugi::xml_node node = items.first_child(); node;
+         node = node.next_sibling(), idx++) {
+        EXPECT_STREQ("retract", node.name());
+        EXPECT_EQ(routes_[idx]->ToXmppIdString(),
+                  node.attribute("id").value());
+    }
+    EXPECT_EQ(routes_.size(), idx);
+}
+
+TEST_F(XmppMsgBuilderTest, McastReach) {
+    AddMcastRoutes(10);
+    RibOutAttr roattr(mcast_attr_.get(), 1000);
+    string data = BuildMessage(&roattr);
+
+    pugi::xml_node items = ParseItems(data);
+    EXPECT_STREQ("1/241/blue", items.attribute("node").value());
+    size_t idx = 0;
+    for (pugi::xml_node node = items.first_child(); node;
+         node = node.next_sibling(), idx++) {
+        EXPECT_STREQ("item", node.name());
+        EXPECT_EQ(routes_[idx]->ToXmppIdString(),
+                  node.attribute("id").value());
+
+        const InetMcastRoute *route =
+            static_cast<const InetMcastRoute *>(routes_[idx]);
+        pugi::xml_node entry = node.child("entry");
+        pugi::xml_node nlri = entry.child("nlri");
+        EXPECT_EQ(BgpAf::IPv4, nlri.child("af").text().as_int());
+        EXPECT_EQ(BgpAf::Mcast, nlri.child("safi").text().as_int());
+        EXPECT_EQ(route->GetPrefix().group().to_string(),
+                  nlri.child("group").text().get());
+        EXPECT_STREQ("10.1.1.1", nlri.child("source").text().get());
+        EXPECT_EQ(1000, nlri.child("source-label").text().as_int());
+
+        EXPECT_TRUE(entry.child("next-hops"));
+        EXPECT_FALSE(entry.child("next-hops").first_child());
+        size_t olist_idx = 0;
+        for (pugi::xml_node nexthop = entry.child("olist").first_child();
+             nexthop; nexthop = nexthop.next_sibling(), olist_idx++) {
+            const BgpOListElem &elem =
+                mcast_attr_->olist()->elements[olist_idx];
+            EXPECT_STREQ("next-hop", nexthop.name());
+            EXPECT_EQ(BgpAf::IPv4, nexthop.child("af").text().as_int());
+            EXPECT_EQ(elem.address.to_string(),
+                      nexthop.child("address").text().get());
+            EXPECT_EQ(elem.label, nexthop.child("label").text().as_uint());
+            EXPECT_STREQ("gre", nexthop.child("tunnel-encapsulation-list")
+                .child("tunnel-encapsulation").text().get());
+        }
+        EXPECT_EQ(2U, olist_idx);
+    }
+    EXPECT_EQ(routes_.size(), idx);
+}
+
+TEST_F(XmppMsgBuilderTest, McastUnreach) {
+    AddMcastRoutes(10);
+    RibOutAttr roattr;
+    string data = BuildMessage(&roattr);
+
+    pugi::xml_node items = ParseItems(data);
+    size_t idx = 0;
+    for (pugi::xml_node node = items.first_child(); node;
+         node = node.next_sibling(), idx++) {
+        EXPECT_STREQ("retract", node.name());
+        EXPECT_EQ(routes_[idx]->ToXmppIdString(),
+                  node.attribute("id").value());
+    }
+    EXPECT_EQ(routes_.size(), idx);
+}
+
+// Messages per second of the streaming writer against the DOM encoding.
+TEST_F(XmppMsgBuilderTest, DISABLED_Benchmark) {
+    AddRoutes(route_count_);
+    RibOutAttr roattr(attr_.get(), 1000);
+
+    uint64_t t0 = UTCTimestampUsec();
+    string dom_data = BuildDomMessage(&roattr);
+    uint64_t dom_usecs = UTCTimestampUsec() - t0 + 1;
+
+    t0 = UTCTimestampUsec();
+    string data = BuildMessage(&roattr);
+    uint64_t stream_usecs = UTCTimestampUsec() - t0 + 1;
+
+    cout << "routes: " << routes_.size() << endl;
+    cout << "dom    usecs: " << dom_usecs << " bytes: " << dom_data.size()
+         << endl;
+    cout << "stream usecs: " << stream_usecs << " bytes: " << data.size()
+         << endl;
+}
+
+}  // namespace
+
+static void SetUp() {
+    ControlNode::SetDefaultSchedulingPolicy();
+}
+
+static void TearDown() {
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    scheduler->Terminate();
+}
+
+int main(int argc, char **argv) {
+    bgp_log_test::init();
+    ::testing::InitGoogleTest(&argc, argv);
+    SetUp();
+    int result = RUN_ALL_TESTS();
+    TearDown();
+    return result;
+}
@@ -5,7 +5,6 @@
 #include "bgp/xmpp_message_builder.h"
 
 #include <boost/foreach.hpp>
-#include <pugixml/pugixml.hpp>
 
 #include "base/parse_object.h"
 #include "base/logging.h"
@@ -18,36 +17,129 @@
 #include "bgp/origin-vn/origin_vn.h"
 #include "bgp/security_group/security_group.h"
 #include "net/bgp_af.h"
-#include "schema/xmpp_unicast_types.h"
-#include "schema/xmpp_multicast_types.h"
-#include "schema/xmpp_enet_types.h"
 #include "xmpp/xmpp_init.h"
 
-using namespace pugi;
 using namespace std;
 
+//
+// Writes XML straight into a string. Element values are converted with the
+// Append overloads, which escape strings as needed for character data and
+// attribute values.
+//
+class XmlWriter {
+public:
+    explicit XmlWriter(string *buf) : buf_(buf) { }
+
+    void Open(const char *tag) {
+        buf_->push_back('<');
+        buf_->append(tag);
+        buf_->push_back('>');
+    }
+
+    void Open(const char *tag, const char *attr, const string &value) {
+        buf_->push_back('<');
+        buf_->append(tag);
+        buf_->push_back(' ');
+        buf_->append(attr);
+        buf_->append("=\"");
+        Append(value);
+        buf_->append("\">");
+    }
+
+    void Close(const char *tag) {
+        buf_->append("</");
+        buf_->append(tag);
+        buf_->push_back('>');
+    }
+
+    template <typename T>
+    void Element(const char *tag, const T &value) {
+        Open(tag);
+        Append(value);
+        Close(tag);
+    }
+
+    void Append(const string &value) {
+        size_t start = 0;
+        for (size_t i = 0; i < value.size(); i++) {
+            const char *entity;
+            switch (value[i]) {
+            case '&': entity = "&amp;"; break;
+            case '<': entity = "&lt;"; break;
+            case '>': entity = "&gt;"; break;
+            case '"': entity = "&quot;"; break;
+            default: continue;
+            }
+            buf_->append(value, start, i - start);
+            buf_->append(entity);
+            start = i + 1;
+        }
+        buf_->append(value, start, string::npos);
+    }
+
+    void Append(int value) {
+        if (value < 0) {
+            buf_->push_back('-');
+            AppendDecimal(-static_cast<int64_t>(value));
+        } else {
+            AppendDecimal(value);
+        }
+    }
+
+    void Append(uint32_t value) {
+        AppendDecimal(value);
+    }
+
+private:
+    void AppendDecimal(uint64_t value) {
+        char tmp[24];
+        char *end = tmp + sizeof(tmp);
+        char *ptr = end;
+        do {
+            *--ptr = '0' + value % 10;
+            value /= 10;
+        } while (value != 0);
+        buf_->append(ptr, end - ptr);
+    }
+
+    string *buf_;
+};
+
+//
+// Streams the pubsub XML for the routes straight into repr_ instead of
+// building a DOM. All routes in a message share the same attributes, so
+// the part of an item that comes from the attributes is written once and
+// copied for every route.
+//
 class BgpXmppMessage : public Message {
 public:
     BgpXmppMessage(const BgpTable *table, const RibOutAttr *roattr)
         : table_(table),
           is_reachable_(roattr->IsReachable()),
-          virtual_network_("unresolved") {
+          virtual_network_("unresolved"),
+          repr_part1_(0),
+          finished_(false) {
     }
     virtual ~BgpXmppMessage() { }
     void Start(const RibOutAttr *roattr, const BgpRoute *route);
     virtual bool AddRoute(const BgpRoute *route, const RibOutAttr *roattr);
-    virtual void Finish() { }
+    virtual void Finish();
     virtual const uint8_t *GetData(IPeerUpdate *peer, size_t *lenp);
 
 private:
-    void EncodeNextHop(const BgpRoute *route, RibOutAttr::NextHop nexthop,
-                       autogen::ItemType &item);
+    static const size_t kInitialSize = 4096;
+
+    bool AttrFragmentValid(const RibOutAttr *roattr);
+
+    void EncodeNextHop(const BgpRoute *route,
+                       const RibOutAttr::NextHop &nexthop, XmlWriter *writer);
     void AddInetReach(const BgpRoute *route, const RibOutAttr *roattr);
     void AddInetUnreach(const BgpRoute *route);
     bool AddInetRoute(const BgpRoute *route, const RibOutAttr *roattr);
 
-    void EncodeEnetNextHop(const BgpRoute *route, RibOutAttr::NextHop nexthop,
-                           autogen::EnetItemType &item);
+    void EncodeEnetNextHop(const BgpRoute *route,
+                           const RibOutAttr::NextHop &nexthop,
+                           XmlWriter *writer);
     void AddEnetReach(const BgpRoute *route, const RibOutAttr *roattr);
     void AddEnetUnreach(const BgpRoute *route);
     bool AddEnetRoute(const BgpRoute *route, const RibOutAttr *roattr);
@@ -79,25 +171,29 @@ private:
 
     const BgpTable *table_;
     bool is_reachable_;
-    xml_document xdoc_;
-    xml_node xitems_;
     std::string virtual_network_;
     std::vector<int> security_group_list_;
     string repr_;
     string repr_new_;
+    // Offset in repr_ where the 'to' attribute goes
     size_t repr_part1_;
-    size_t repr_part2_;
+    bool finished_;
+
+    // Attribute part of the items, valid for cache_roattr_
+    RibOutAttr cache_roattr_;
+    string cache_fragment_;
     DISALLOW_COPY_AND_ASSIGN(BgpXmppMessage);
 };
 
 void BgpXmppMessage::Start(const RibOutAttr *roattr, const BgpRoute *route) {
-    // Build the DOM tree
-    xml_node message = xdoc_.append_child("message");
-    message.append_attribute("from") = XmppInit::kControlNodeJID;
-
-    xml_node event = message.append_child("event");
-    event.append_attribute("xmlns") = "http://jabber.org/protocol/pubsub";
-    xitems_ = event.append_child("items");
+    XmlWriter writer(&repr_);
+    repr_ = "<?xml version=\"1.0\"?>\n<message from=\"";
+    repr_.reserve(kInitialSize);
+    writer.Append(string(XmppInit::kControlNodeJID));
+    repr_.push_back('"');
+    repr_part1_ = repr_.size();
+    repr_.push_back('>');
+    writer.Open("event", "xmlns", "http://jabber.org/protocol/pubsub");
 
     if (is_reachable_) {
         const BgpAttr *attr = roattr->attr();
@@ -107,17 +203,8 @@ void BgpXmppMessage::Start(const RibOutAttr *roattr, const BgpRoute *route) {
     stringstream ss;
     ss << route->Afi() << "/" << int(route->Safi()) << "/" <<
           table_->routing_instance()->name();
-    std::string node(ss.str());
-    if (table_->family() == Address::INETMCAST) {
-        xitems_.append_attribute("node") = node.c_str();
-        AddMcastRoute(route, roattr);
-    } else if (table_->family() == Address::ENET) {
-        xitems_.append_attribute("node") = node.c_str();
-        AddEnetRoute(route, roattr);
-    } else {
-        xitems_.append_attribute("node") = node.c_str();
-        AddInetRoute(route, roattr);
-    }
+    writer.Open("items", "node", ss.str());
+    AddRoute(route, roattr);
 }
 
 bool BgpXmppMessage::AddRoute(const BgpRoute *route, const RibOutAttr *roattr) {
@@ -130,56 +217,93 @@ bool BgpXmppMessage::AddRoute(const BgpRoute *route, const RibOutAttr *roattr) {
     }
 }
 
-void BgpXmppMessage::EncodeNextHop(const BgpRoute *route,
-                                   RibOutAttr::NextHop nexthop,
-                                   autogen::ItemType &item) {
-    autogen::NextHopType item_nexthop;
+void BgpXmppMessage::Finish() {
+    if (finished_)
+        return;
+    XmlWriter writer(&repr_);
+    writer.Close("items");
+    writer.Close("event");
+    writer.Close("message");
+    repr_.push_back('\n');
+    finished_ = true;
+}
+
+//
+// Return true if cache_fragment_ holds the attribute part of the item for
+// the given attributes. Otherwise clear it for the caller to fill in.
+//
+bool BgpXmppMessage::AttrFragmentValid(const RibOutAttr *roattr) {
+    if (cache_roattr_ == *roattr) {
+        return true;
+    }
+
+    cache_roattr_ = *roattr;
+    cache_fragment_.clear();
+    return false;
+}
 
-    item_nexthop.af = route->Afi();
-    item_nexthop.address = nexthop.address().to_v4().to_string();
-    item_nexthop.label = nexthop.label();
+void BgpXmppMessage::EncodeNextHop(const BgpRoute *route,
+                                   const RibOutAttr::NextHop &nexthop,
+                                   XmlWriter *writer) {
+    writer->Open("next-hop");
+    writer->Element("af", route->Afi());
+    writer->Element("address", nexthop.address().to_v4().to_string());
+    writer->Element("label", nexthop.label());
+    writer->Open("tunnel-encapsulation-list");
     if (nexthop.encap().empty()) {
         // If encap list is empty, routes from non-control-node, 
         // use mpls over gre as default encap
-        item_nexthop.tunnel_encapsulation_list.tunnel_encapsulation.push_back(std::string("gre"));
+        writer->Element("tunnel-encapsulation", string("gre"));
     } else {
-        item_nexthop.tunnel_encapsulation_list.tunnel_encapsulation= nexthop.encap();
+        BOOST_FOREACH(const string &encap, nexthop.encap()) {
+            writer->Element("tunnel-encapsulation", encap);
+        }
     }
-
-    item.entry.next_hops.next_hop.push_back(item_nexthop);
+    writer->Close("tunnel-encapsulation-list");
+    writer->Close("next-hop");
 }
 
 void BgpXmppMessage::AddInetReach(const BgpRoute *route, const RibOutAttr *roattr) {
-    autogen::ItemType item;
-
-    item.entry.nlri.af = route->Afi();
-    item.entry.nlri.safi = route->Safi();
-    item.entry.nlri.address = route->ToString();
-    item.entry.version = 1;
-    item.entry.virtual_network = virtual_network_;
-
-    assert(!roattr->nexthop_list().empty());
-
-    //
-    // Encode all next-hops in the list
-    //
-    BOOST_FOREACH(RibOutAttr::NextHop nexthop, roattr->nexthop_list()) {
-        EncodeNextHop(route, nexthop, item);
-    }
-
-    for (std::vector<int>::iterator it = security_group_list_.begin(); 
-         it !=  security_group_list_.end(); it++) {
-        item.entry.security_group_list.security_group.push_back(*it);
+    XmlWriter writer(&repr_);
+    writer.Open("item", "id", route->ToXmppIdString());
+    writer.Open("entry");
+    writer.Open("nlri");
+    writer.Element("af", route->Afi());
+    writer.Element("safi", route->Safi());
+    writer.Element("address", route->ToString());
+    writer.Close("nlri");
+
+    if (!AttrFragmentValid(roattr)) {
+        XmlWriter attr_writer(&cache_fragment_);
+        assert(!roattr->nexthop_list().empty());
+
+        //
+        // Encode all next-hops in the list
+        //
+        attr_writer.Open("next-hops");
+        BOOST_FOREACH(const RibOutAttr::NextHop &nexthop,
+                      roattr->nexthop_list()) {
+            EncodeNextHop(route, nexthop, &attr_writer);
+        }
+        attr_writer.Close("next-hops");
+        attr_writer.Element("version", 1);
+        attr_writer.Element("virtual-network", virtual_network_);
+        attr_writer.Open("security-group-list");
+        for (std::vector<int>::iterator it = security_group_list_.begin(); 
+             it !=  security_group_list_.end(); it++) {
+            attr_writer.Element("security-group", *it);
+        }
+        attr_writer.Close("security-group-list");
+        attr_writer.Close("entry");
+        attr_writer.Close("item");
     }
-
-    xml_node node = xitems_.append_child("item");
-    node.append_attribute("id") = route->ToXmppIdString().c_str();
-    item.Encode(&node);
+    repr_.append(cache_fragment_);
 }
 
 void BgpXmppMessage::AddInetUnreach(const BgpRoute *route) {
-    xml_node node = xitems_.append_child("retract");
-    node.append_attribute("id") = route->ToXmppIdString().c_str();
+    XmlWriter writer(&repr_);
+    writer.Open("retract", "id", route->ToXmppIdString());
+    writer.Close("retract");
 }
 
 bool BgpXmppMessage::AddInetRoute(const BgpRoute *route, const RibOutAttr *roattr) {
@@ -194,47 +318,58 @@ bool BgpXmppMessage::AddInetRoute(const BgpRoute *route, const RibOutAttr *roatt
 }
 
 void BgpXmppMessage::EncodeEnetNextHop(const BgpRoute *route,
-                                       RibOutAttr::NextHop nexthop,
-                                       autogen::EnetItemType &item) {
-    autogen::EnetNextHopType item_nexthop;
-
-    item_nexthop.af = BgpAf::IPv4;
-    item_nexthop.address = nexthop.address().to_v4().to_string();
-    item_nexthop.label = nexthop.label();
+                                       const RibOutAttr::NextHop &nexthop,
+                                       XmlWriter *writer) {
+    writer->Open("next-hop");
+    writer->Element("af", BgpAf::IPv4);
+    writer->Element("address", nexthop.address().to_v4().to_string());
+    writer->Element("label", nexthop.label());
+    writer->Open("tunnel-encapsulation-list");
     if (nexthop.encap().empty()) {
         // If encap list is empty, routes from non-control-node, 
         // use mpls over gre as default encap
-        item_nexthop.tunnel_encapsulation_list.tunnel_encapsulation.push_back(std::string("gre"));
+        writer->Element("tunnel-encapsulation", string("gre"));
     } else {
-        item_nexthop.tunnel_encapsulation_list.tunnel_encapsulation= nexthop.encap();
+        BOOST_FOREACH(const string &encap, nexthop.encap()) {
+            writer->Element("tunnel-encapsulation", encap);
+        }
     }
-    item.entry.next_hops.next_hop.push_back(item_nexthop);
+    writer->Close("tunnel-encapsulation-list");
+    writer->Close("next-hop");
 }
 
 void BgpXmppMessage::AddEnetReach(const BgpRoute *route, const RibOutAttr *roattr) {
-
-    autogen::EnetItemType item;
-    item.entry.nlri.af = route->Afi();
-    item.entry.nlri.safi = route->Safi();
-
-    EnetRoute *enet_route =
-        static_cast<EnetRoute *>(const_cast<BgpRoute *>(route));
-    item.entry.nlri.mac = enet_route->GetPrefix().mac_addr().ToString();
-    item.entry.nlri.address =  enet_route->GetPrefix().ip_prefix().ToString();
-
-    assert(!roattr->nexthop_list().empty());
-    BOOST_FOREACH(RibOutAttr::NextHop nexthop, roattr->nexthop_list()) {
-        EncodeEnetNextHop(route, nexthop, item);
+    XmlWriter writer(&repr_);
+    writer.Open("item", "id", route->ToXmppIdString());
+    writer.Open("entry");
+    writer.Open("nlri");
+    writer.Element("af", route->Afi());
+    writer.Element("safi", route->Safi());
+
+    const EnetRoute *enet_route = static_cast<const EnetRoute *>(route);
+    writer.Element("mac", enet_route->GetPrefix().mac_addr().ToString());
+    writer.Element("address", enet_route->GetPrefix().ip_prefix().ToString());
+    writer.Close("nlri");
+
+    if (!AttrFragmentValid(roattr)) {
+        XmlWriter attr_writer(&cache_fragment_);
+        assert(!roattr->nexthop_list().empty());
+        attr_writer.Open("next-hops");
+        BOOST_FOREACH(const RibOutAttr::NextHop &nexthop,
+                      roattr->nexthop_list()) {
+            EncodeEnetNextHop(route, nexthop, &attr_writer);
+        }
+        attr_writer.Close("next-hops");
+        attr_writer.Close("entry");
+        attr_writer.Close("item");
     }
-
-    xml_node node = xitems_.append_child("item");
-    node.append_attribute("id") = route->ToXmppIdString().c_str();
-    item.Encode(&node);
+    repr_.append(cache_fragment_);
 }
 
 void BgpXmppMessage::AddEnetUnreach(const BgpRoute *route) {
-    xml_node node = xitems_.append_child("retract");
-    node.append_attribute("id") = route->ToXmppIdString().c_str();
+    XmlWriter writer(&repr_);
+    writer.Open("retract", "id", route->ToXmppIdString());
+    writer.Close("retract");
 }
 
 bool BgpXmppMessage::AddEnetRoute(const BgpRoute *route, const RibOutAttr *roattr) {
@@ -249,41 +384,52 @@ bool BgpXmppMessage::AddEnetRoute(const BgpRoute *route, const RibOutAttr *roatt
 }
 
 void BgpXmppMessage::AddMcastReach(const BgpRoute *route, const RibOutAttr *roattr) {
-
-    autogen::McastItemType item;
-    item.entry.nlri.af = route->Afi();
-    item.entry.nlri.safi = route->Safi();
-
-    InetMcastRoute *mcast_route =
-        static_cast<InetMcastRoute *>(const_cast<BgpRoute *>(route));
-    item.entry.nlri.group = mcast_route->GetPrefix().group().to_string();
-    item.entry.nlri.source =  mcast_route->GetPrefix().source().to_string();
-    item.entry.nlri.source_label = roattr->label();
-
-    BgpOList *olist = roattr->attr()->olist().get();
-    std::vector<BgpOListElem>::const_iterator iterator;
-    for (iterator = olist->elements.begin();
-         iterator != olist->elements.end(); ++iterator) {
-        BgpOListElem elem = static_cast<BgpOListElem>(*iterator);
-
-        autogen::McastNextHopType nh;
-        nh.af = BgpAf::IPv4;
-        nh.address = elem.address.to_string();
-        stringstream label;
-        label << elem.label;
-        nh.label = label.str();
-        nh.tunnel_encapsulation_list.tunnel_encapsulation = elem.encap;
-        item.entry.olist.next_hop.push_back(nh);
+    XmlWriter writer(&repr_);
+    writer.Open("item", "id", route->ToXmppIdString());
+    writer.Open("entry");
+    writer.Open("nlri");
+    writer.Element("af", route->Afi());
+    writer.Element("safi", route->Safi());
+
+    const InetMcastRoute *mcast_route =
+        static_cast<const InetMcastRoute *>(route);
+    writer.Element("group", mcast_route->GetPrefix().group().to_string());
+    writer.Element("source", mcast_route->GetPrefix().source().to_string());
+    writer.Element("source-label", roattr->label());
+    writer.Close("nlri");
+
+    if (!AttrFragmentValid(roattr)) {
+        XmlWriter attr_writer(&cache_fragment_);
+        attr_writer.Open("next-hops");
+        attr_writer.Close("next-hops");
+        attr_writer.Open("olist");
+        BgpOList *olist = roattr->attr()->olist().get();
+        std::vector<BgpOListElem>::const_iterator iterator;
+        for (iterator = olist->elements.begin();
+             iterator != olist->elements.end(); ++iterator) {
+            const BgpOListElem &elem = *iterator;
+            attr_writer.Open("next-hop");
+            attr_writer.Element("af", BgpAf::IPv4);
+            attr_writer.Element("address", elem.address.to_string());
+            attr_writer.Element("label", elem.label);
+            attr_writer.Open("tunnel-encapsulation-list");
+            BOOST_FOREACH(const string &encap, elem.encap) {
+                attr_writer.Element("tunnel-encapsulation", encap);
+            }
+            attr_writer.Close("tunnel-encapsulation-list");
+            attr_writer.Close("next-hop");
+        }
+        attr_writer.Close("olist");
+        attr_writer.Close("entry");
+        attr_writer.Close("item");
     }
-
-    xml_node node = xitems_.append_child("item");
-    node.append_attribute("id") = route->ToXmppIdString().c_str();
-    item.Encode(&node);
+    repr_.append(cache_fragment_);
 }
 
 void BgpXmppMessage::AddMcastUnreach(const BgpRoute *route) {
-    xml_node node = xitems_.append_child("retract");
-    node.append_attribute("id") = route->ToXmppIdString().c_str();
+    XmlWriter writer(&repr_);
+    writer.Open("retract", "id", route->ToXmppIdString());
+    writer.Close("retract");
 }
 
 bool BgpXmppMessage::AddMcastRoute(const BgpRoute *route, const RibOutAttr *roattr) {
@@ -298,34 +444,21 @@ bool BgpXmppMessage::AddMcastRoute(const BgpRoute *route, const RibOutAttr *roat
 }
 
 const uint8_t *BgpXmppMessage::GetData(IPeerUpdate *peer, size_t *lenp) {
-    std::string str = peer->ToString() + "/" + XmppInit::kBgpPeer;
-
-    // If the message has already been constructed, just replace the 'to' part.
-    if (!repr_.empty()) {
-        repr_new_ = string(repr_, 0, repr_part1_) + "to=\"" + str + "\">" +
-                    string(repr_, repr_part2_);
-
-        *lenp = repr_new_.size();
-        return reinterpret_cast<const uint8_t *>(repr_new_.c_str());
-    }
-
-    xml_node message =  xdoc_.child("message");
-    xml_attribute attr_to = message.attribute("to");
-    if (!attr_to) {
-        attr_to = message.append_attribute("to");
-    }
-    attr_to.set_value(str.c_str());
-    ostringstream oss;
-    xdoc_.save(oss);
-    repr_ = oss.str();
-
-    repr_part1_ = repr_.find("to=", 0);
-    assert(repr_part1_ != string::npos);
-    repr_part2_ = repr_.find("\n\t<event xmlns");
-    assert(repr_part2_ != string::npos);
-
-    *lenp = repr_.size();
-    return reinterpret_cast<const uint8_t *>(repr_.c_str());
+    Finish();
+
+    // Only the 'to' part differs between peers.
+    string str = peer->ToString() + "/" + XmppInit::kBgpPeer;
+    repr_new_.clear();
+    repr_new_.reserve(repr_.size() + str.size() + 8);
+    repr_new_.append(repr_, 0, repr_part1_);
+    repr_new_.append(" to=\"");
+    XmlWriter writer(&repr_new_);
+    writer.Append(str);
+    repr_new_.push_back('"');
+    repr_new_.append(repr_, repr_part1_, string::npos);
+
+    *lenp = repr_new_.size();
+    return reinterpret_cast<const uint8_t *>(repr_new_.c_str());
 }
 
 Message *BgpXmppMessageBuilder::Create(const BgpTable *table,
@@ -439,6 +439,8 @@ int main(int argc, char *argv[]) {
         ("xmpp-port",
             opt::value<int>()->default_value(ContrailPorts::ControlXmpp),
             "XMPP listener port")
+        ("xmpp-batch-send-bytes", opt::value<int>()->default_value(0),
+            "Batch route updates to XMPP peers up to this many bytes; 0 disables")
         ("version", "Display version information")
         ("use-certs", opt::value<string>(),
             "Use certificates to communicate with MAP server; Specify certificate store")
@@ -547,6 +549,8 @@ int main(int argc, char *argv[]) {
     // Register XMPP channel peers 
     boost::scoped_ptr<BgpXmppChannelManager> bgp_peer_manager(
                     new BgpXmppChannelManager(xmpp_server, bgp_server.get()));
+    bgp_peer_manager->set_batch_send_bytes(
+        var_map["xmpp-batch-send-bytes"].as<int>());
     sandesh_context.xmpp_peer_manager = bgp_peer_manager.get();
     IFMapChannelManager ifmap_channel_mgr(xmpp_server, &ifmap_server);
     ifmap_server.set_ifmap_channel_manager(&ifmap_channel_mgr);
@@ -14,11 +14,7 @@ void DBEntryBase::SetState(DBTableBase *tbl_base, ListenerId listener,
                            DBState *state) {
     DBTablePartBase *tpart = tbl_base->GetTablePartition(this);
     tbb::mutex::scoped_lock lock(tpart->dbstate_mutex());
-    pair<StateMap::iterator, bool> res = state_.insert(
-        make_pair(listener, state));
-    if (!res.second) {
-        res.first->second = state;
-    } else {
+    if (state_.Set(listener, state)) {
         assert(!IsDeleted());
     }
 }
@@ -26,11 +22,7 @@ void DBEntryBase::SetState(DBTableBase *tbl_base, ListenerId listener,
 DBState *DBEntryBase::GetState(DBTableBase *tbl_base, ListenerId listener) {
     DBTablePartBase *tpart = tbl_base->GetTablePartition(this);
     tbb::mutex::scoped_lock lock(tpart->dbstate_mutex());
-    StateMap::iterator loc = state_.find(listener);
-    if (loc != state_.end()) {
-        return loc->second;
-    }
-    return NULL;
+    return state_.Get(listener);
 }
 
 const DBState *DBEntryBase::GetState(const DBTableBase *tbl_base,
@@ -38,18 +30,15 @@ const DBState *DBEntryBase::GetState(const DBTableBase *tbl_base,
     DBTableBase *table = const_cast<DBTableBase *>(tbl_base);
     DBTablePartBase *tpart = table->GetTablePartition(this);
     tbb::mutex::scoped_lock lock(tpart->dbstate_mutex());
-    StateMap::const_iterator loc = state_.find(listener);
-    if (loc != state_.end()) {
-        return loc->second;
-    }
-    return NULL;
+    return state_.Get(listener);
 }
 
 void DBEntryBase::ClearState(DBTableBase *tbl_base, ListenerId listener) {
     DBTablePartBase *tpart = tbl_base->GetTablePartition(this);
     tbb::mutex::scoped_lock lock(tpart->dbstate_mutex());
-    state_.erase(listener);
-    if (state_.empty() && IsDeleted() && !is_onlist()) {
+    state_.Clear(listener);
+    if (state_.empty() && IsDeleted() && !is_onlist() &&
+        !is_on_final_list()) {
         assert(!IsOnRemoveQ());
         tbl_base->EnqueueRemove(this);
     }
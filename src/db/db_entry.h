@@ -7,6 +7,7 @@
 
 #include <map>
 
+#include "db/db_state_vector.h"
 #include "db/db_table.h"
 
 #include <boost/intrusive/list.hpp>
@@ -22,7 +23,9 @@ public:
     typedef DBTableBase::ListenerId ListenerId;
     typedef std::auto_ptr<DBRequestKey> KeyPtr;
 
-    DBEntryBase() : table_(NULL), flags(0), last_change_at_(UTCTimestampUsec()) {
+    DBEntryBase()
+        : table_(NULL), flags(0), generation_(0),
+          last_change_at_(UTCTimestampUsec()) {
     }
     virtual ~DBEntryBase() { }
     virtual std::string ToString() const = 0;
@@ -50,6 +53,16 @@ public:
     void ClearOnRemoveQ() { flags &= ~OnRemoveQ; }
     bool IsOnRemoveQ() { return (flags & OnRemoveQ); }
 
+    // Pending notification for final-state-only listeners.
+    void set_on_final_list() { flags |= OnFinalList; }
+    void clear_on_final_list() { flags &= ~OnFinalList; }
+    bool is_on_final_list() const { return (flags & OnFinalList); }
+
+    // Number of changes notified on the entry, including changes that were
+    // coalesced into an already pending notification.
+    uint32_t generation() const { return generation_; }
+    void increment_generation() { generation_++; }
+
     //member hook in change list
     boost::intrusive::list_member_hook<> chg_list_;
 
@@ -65,11 +78,12 @@ private:
         Onlist       = 1 << 0,
         DeleteMarked = 1 << 1,
         OnRemoveQ    = 1 << 2,
+        OnFinalList  = 1 << 3,
     };
-    typedef std::map<ListenerId, DBState *> StateMap;
     DBTableBase *table_;
-    StateMap state_;
+    DBStateVector state_;
     uint8_t flags;
+    uint32_t generation_;
     uint64_t last_change_at_; // time at which entry was last 'changed'
     DISALLOW_COPY_AND_ASSIGN(DBEntryBase);
 };
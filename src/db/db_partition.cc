@@ -5,6 +5,7 @@
 #include "db/db_partition.h"
 
 #include <list>
+#include <boost/scoped_array.hpp>
 #include <tbb/atomic.h>
 #include <tbb/concurrent_queue.h>
 #include <tbb/mutex.h>
@@ -17,15 +18,37 @@ using namespace tbb;
 
 int DBPartition::db_partition_task_id_ = -1;
 
+// A single request or a batch of requests enqueued in one shot. Batched
+// requests are stored in one array rather than in an entry per request.
+// next is the first request of the batch that has not been processed yet.
 struct RequestQueueEntry {
+    struct BatchItem {
+        DBTablePartBase *tpart;
+        DBRequest request;
+    };
+
     // Constructor takes ownership of DBRequest key, data.
     RequestQueueEntry(DBTablePartBase *tpart, DBClient *client, DBRequest *req)
-        : tpart(tpart), client(client) {
+        : tpart(tpart), client(client), count(1), next(0) {
         request.Swap(req);
     }
+
+    RequestQueueEntry(DBClient *client,
+                      const DBPartition::RequestList &requests)
+        : tpart(NULL), client(client), count(requests.size()), next(0),
+          batch(new BatchItem[requests.size()]) {
+        for (size_t i = 0; i < count; i++) {
+            batch[i].tpart = requests[i].first;
+            batch[i].request.Swap(requests[i].second);
+        }
+    }
+
     DBTablePartBase *tpart;
     DBClient *client;
     DBRequest request;
+    size_t count;
+    size_t next;
+    boost::scoped_array<BatchItem> batch;
 };
 
 struct RemoveQueueEntry {
@@ -39,15 +62,18 @@ struct RemoveQueueEntry {
 class DBPartition::WorkQueue {
 public:
     static const int kThreshold = 1024;
+    static const int kMaxFinalDefer = 8;
     typedef concurrent_queue<RequestQueueEntry *> RequestQueue;
     typedef concurrent_queue<RemoveQueueEntry *> RemoveQueue;
     typedef std::list<DBTablePartBase *> TablePartList;
 
     explicit WorkQueue(int partition_id) 
-        : db_partition_id_(partition_id), disable_(false), running_(false) {
+        : db_partition_id_(partition_id), current_(NULL), disable_(false),
+          running_(false), final_defer_count_(0) {
         request_count_ = 0;
     }
     ~WorkQueue() {
+        delete current_;
         for (RequestQueue::iterator iter = request_queue_.unsafe_begin();
              iter != request_queue_.unsafe_end();) {
             RequestQueueEntry *req_entry = *iter;
@@ -58,19 +84,35 @@ public:
     }
 
     bool EnqueueRequest(RequestQueueEntry *req_entry) {
+        long count = req_entry->count;
         request_queue_.push(req_entry);
         MaybeStartRunner();
-        return request_count_.fetch_and_increment() < (kThreshold - 1);
+        return request_count_.fetch_and_add(count) < (kThreshold - count);
     }
 
     bool DequeueRequest(RequestQueueEntry **req_entry) {
         bool success = request_queue_.try_pop(*req_entry);
         if (success) {
-            request_count_.fetch_and_decrement();
+            request_count_.fetch_and_add(-(long) (*req_entry)->count);
         }
         return success;
     }
 
+    // The entry being processed. It is kept across runs of the QueueRunner
+    // until RequestDone, so that a batch can be resumed.
+    bool CurrentRequest(RequestQueueEntry **req_entry) {
+        if (current_ == NULL && !DequeueRequest(&current_)) {
+            return false;
+        }
+        *req_entry = current_;
+        return true;
+    }
+
+    void RequestDone() {
+        delete current_;
+        current_ = NULL;
+    }
+
     void EnqueueRemove(RemoveQueueEntry *rm_entry) {
         remove_queue_.push(rm_entry);
         MaybeStartRunner();
@@ -98,12 +140,40 @@ public:
         return tpart;
     }
 
+    void SetFinalActive(DBTablePartBase *tpart) {
+        final_change_list_.push_back(tpart);
+    }
+
+    // Final-state notifications are held back while input requests are
+    // pending, but for no more than kMaxFinalDefer runs of the QueueRunner.
+    bool FinalNotifyReady() {
+        if (final_change_list_.empty()) {
+            return false;
+        }
+        if (request_queue_.empty() ||
+            ++final_defer_count_ >= kMaxFinalDefer) {
+            final_defer_count_ = 0;
+            return true;
+        }
+        return false;
+    }
+
+    DBTablePartBase *GetFinalActiveTable() {
+        DBTablePartBase *tpart = NULL;
+        if (!final_change_list_.empty()) {
+            tpart = final_change_list_.front();
+            final_change_list_.pop_front();
+        }
+        return tpart;
+    }
+
     int db_partition_id() {
         return db_partition_id_;
     }
 
     bool IsDBQueueEmpty() {
-        return (request_queue_.empty() && change_list_.empty());
+        return (current_ == NULL && request_queue_.empty() &&
+                change_list_.empty() && final_change_list_.empty());
     }
 
     bool disable() { return disable_; }
@@ -111,13 +181,16 @@ public:
 
 private:
     RequestQueue request_queue_;
+    RequestQueueEntry *current_;
     TablePartList change_list_;
+    TablePartList final_change_list_;
     atomic<long> request_count_;
     RemoveQueue remove_queue_;
     mutex mutex_;
     int db_partition_id_;
     bool disable_;
     bool running_;
+    int final_defer_count_;
     DISALLOW_COPY_AND_ASSIGN(WorkQueue);
 };
 
@@ -129,42 +202,58 @@ void DBPartition::SetQueueDisable(bool disable) {
     work_queue_->set_disable(disable);
 }
 
+// The runner yields once it has used up its time budget rather than after a
+// fixed number of requests, so that cheap requests are not penalized by
+// scheduling overhead. The clock is only read every kTimeCheckInterval work
+// items.
 class DBPartition::QueueRunner : public Task {
 public:
-    static const int kMaxIterations = 32;
+    static const uint64_t kMaxRunTimeUsec = 2000;
+    static const int kTimeCheckInterval = 16;
+
     QueueRunner(WorkQueue *queue) 
         : Task(db_partition_task_id_, queue->db_partition_id()), 
-          queue_(queue) {
+          queue_(queue), count_(0), next_time_check_(0), start_time_(0) {
     }
 
     virtual bool Run() {
-        int count = 0;
+        count_ = 0;
+        next_time_check_ = kTimeCheckInterval;
+        start_time_ = UTCTimestampUsec();
 
         //
         // Skip if the queue is disabled from running
         //
         if (queue_->disable()) return false;
 
+        // An entry on the final list is removed by RunFinalNotify.
         RemoveQueueEntry *rm_entry = NULL;
         while (queue_->DequeueRemove(&rm_entry)) {
             if (rm_entry->db_entry->IsDeleted() &&
                 !rm_entry->db_entry->is_onlist() &&
+                !rm_entry->db_entry->is_on_final_list() &&
                 rm_entry->db_entry->is_state_empty(rm_entry->tpart)) {
                 rm_entry->tpart->Remove(rm_entry->db_entry);
             } else {
                 rm_entry->db_entry->ClearOnRemoveQ();
             }
             delete rm_entry;
-            if (++count == kMaxIterations) {
+            count_++;
+            if (BudgetExhausted()) {
                 return false;
             }
         }
 
-        RequestQueueEntry *req_entry = NULL;
-        while (queue_->DequeueRequest(&req_entry)) {
-            req_entry->tpart->Process(req_entry->client, &req_entry->request);
-            delete req_entry;
-            if (++count == kMaxIterations) {
+        // Requests are processed in enqueue order, also across tables, since
+        // table inputs may depend on each other (e.g. a route add following
+        // its routing instance add).
+        RequestQueueEntry *req_entry;
+        while (queue_->CurrentRequest(&req_entry)) {
+            if (!ProcessRequest(req_entry)) {
+                return false;
+            }
+            queue_->RequestDone();
+            if (BudgetExhausted()) {
                 return false;
             }
         }
@@ -177,6 +266,16 @@ public:
             tpart->RunNotify();
         }
 
+        if (queue_->FinalNotifyReady()) {
+            while (true) {
+                DBTablePartBase *tpart = queue_->GetFinalActiveTable();
+                if (tpart == NULL) {
+                    break;
+                }
+                tpart->RunFinalNotify();
+            }
+        }
+
         // Running is done only if queue_ is empty. It's possible that more
         // entries are added into in the input or remove queues during the
         // time we were processing those queues.
@@ -184,7 +283,38 @@ public:
     }
     
 private:
+    // Returns false if the budget is used up in the middle of a batch. The
+    // rest of the batch is processed on the next run.
+    bool ProcessRequest(RequestQueueEntry *req_entry) {
+        if (!req_entry->batch) {
+            req_entry->tpart->Process(req_entry->client, &req_entry->request);
+            count_++;
+            return true;
+        }
+        while (req_entry->next < req_entry->count) {
+            RequestQueueEntry::BatchItem &item =
+                req_entry->batch[req_entry->next++];
+            item.tpart->Process(req_entry->client, &item.request);
+            count_++;
+            if (req_entry->next < req_entry->count && BudgetExhausted()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool BudgetExhausted() {
+        if (count_ < next_time_check_) {
+            return false;
+        }
+        next_time_check_ = count_ + kTimeCheckInterval;
+        return (UTCTimestampUsec() - start_time_ >= kMaxRunTimeUsec);
+    }
+
     WorkQueue *queue_;
+    uint64_t count_;
+    uint64_t next_time_check_;
+    uint64_t start_time_;
 };
 
 void DBPartition::WorkQueue::MaybeStartRunner() {
@@ -200,7 +330,8 @@ void DBPartition::WorkQueue::MaybeStartRunner() {
 
 bool DBPartition::WorkQueue::RunnerDone() {
     mutex::scoped_lock lock(mutex_);
-    if (request_queue_.empty() && remove_queue_.empty()) {
+    if (current_ == NULL && request_queue_.empty() && remove_queue_.empty() &&
+        final_change_list_.empty()) {
         running_ = false;
         return true;
     }
@@ -228,6 +359,15 @@ bool DBPartition::EnqueueRequest(DBTablePartBase *tpart, DBClient *client,
     return work_queue_->EnqueueRequest(entry);
 }
 
+bool DBPartition::EnqueueRequestList(DBClient *client,
+                                     const RequestList &requests) {
+    if (requests.empty()) {
+        return true;
+    }
+    RequestQueueEntry *entry = new RequestQueueEntry(client, requests);
+    return work_queue_->EnqueueRequest(entry);
+}
+
 void DBPartition::EnqueueRemove(DBTablePartBase *tpart, DBEntryBase *db_entry) {
     RemoveQueueEntry *entry = new RemoveQueueEntry(tpart, db_entry);
     db_entry->SetOnRemoveQ();
@@ -238,3 +378,8 @@ void DBPartition::EnqueueRemove(DBTablePartBase *tpart, DBEntryBase *db_entry) {
 void DBPartition::OnTableChange(DBTablePartBase *tablepart) {
     work_queue_->SetActive(tablepart);
 }
+
+// concurrency: called from DBPartition task.
+void DBPartition::OnTableFinalChange(DBTablePartBase *tablepart) {
+    work_queue_->SetFinalActive(tablepart);
+}
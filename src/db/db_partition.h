@@ -5,6 +5,8 @@
 #ifndef ctrlplane_db_partition_h
 #define ctrlplane_db_partition_h
 
+#include <utility>
+#include <vector>
 #include <boost/function.hpp>
 
 #include "base/util.h"
@@ -20,6 +22,8 @@ class DBTablePartBase;
 class DBPartition {
 public:
     typedef boost::function<void(void)> Callback;
+    typedef std::vector<std::pair<DBTablePartBase *, DBRequest *> >
+        RequestList;
 
     explicit DBPartition(int partition_id);
     ~DBPartition();
@@ -29,10 +33,19 @@ public:
     bool EnqueueRequest(DBTablePartBase *tpart, DBClient *client,
                         DBRequest *req);
 
+    // Enqueue a list of requests as a single work queue entry. Takes
+    // ownership of the key and data of each request. Requests are processed
+    // in list order.
+    bool EnqueueRequestList(DBClient *client, const RequestList &requests);
+
     void EnqueueRemove(DBTablePartBase *tpart, DBEntryBase *db_entry);
 
     // Enqueue table on change list.
     void OnTableChange(DBTablePartBase *tpart);
+
+    // Enqueue table on the list of tables with pending final-state
+    // notifications.
+    void OnTableFinalChange(DBTablePartBase *tpart);
     bool IsDBQueueEmpty();
     void SetQueueDisable(bool disable);
         
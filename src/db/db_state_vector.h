@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef ctrlplane_db_state_vector_h
+#define ctrlplane_db_state_vector_h
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "base/util.h"
+
+struct DBState;
+
+// Listener state of a DBEntryBase, indexed by ListenerId.
+//
+// Listener ids are small dense integers handed out (and recycled) by
+// DBTableBase::Register. The states are kept in a heap array indexed by
+// listener id, which makes lookups O(1) and avoids a tree node per state.
+// A NULL state is a valid value; it is stored as a sentinel so that it still
+// counts towards the entry having state.
+class DBStateVector {
+public:
+    DBStateVector() : states_(NULL), size_(0), count_(0) {
+    }
+    ~DBStateVector() {
+        delete [] states_;
+    }
+
+    DBState *Get(int id) const {
+        if (id < 0 || id >= size_ || states_[id] == NullState())
+            return NULL;
+        return states_[id];
+    }
+
+    // Returns true if the listener did not have state before.
+    bool Set(int id, DBState *state) {
+        assert(id >= 0 && id < kMaxSize);
+        if (id >= size_) {
+            Grow(id + 1);
+        }
+        bool added = (states_[id] == NULL);
+        states_[id] = (state == NULL) ? NullState() : state;
+        if (added) {
+            count_++;
+        }
+        return added;
+    }
+
+    // Returns true if the listener had state.
+    bool Clear(int id) {
+        if (id < 0 || id >= size_ || states_[id] == NULL)
+            return false;
+        states_[id] = NULL;
+        count_--;
+        if (count_ == 0) {
+            delete [] states_;
+            states_ = NULL;
+            size_ = 0;
+        }
+        return true;
+    }
+
+    bool empty() const { return (count_ == 0); }
+    size_t size() const { return count_; }
+    size_t capacity() const { return size_; }
+
+private:
+    static const int kMaxSize = 0xFFFF;
+    static const int kGrowSize = 4;
+
+    static DBState *NullState() {
+        static char null_state;
+        return reinterpret_cast<DBState *>(&null_state);
+    }
+
+    void Grow(int size) {
+        int new_size = ((size + kGrowSize - 1) / kGrowSize) * kGrowSize;
+        if (new_size > kMaxSize)
+            new_size = kMaxSize;
+        DBState **states = new DBState *[new_size];
+        memset(states, 0, new_size * sizeof(DBState *));
+        if (states_ != NULL) {
+            memcpy(states, states_, size_ * sizeof(DBState *));
+            delete [] states_;
+        }
+        states_ = states;
+        size_ = new_size;
+    }
+
+    DBState **states_;
+    uint16_t size_;
+    uint16_t count_;
+
+    DISALLOW_COPY_AND_ASSIGN(DBStateVector);
+};
+
+#endif
@@ -3,6 +3,7 @@
  */
 
 #include <vector>
+#include <tbb/atomic.h>
 #include <tbb/spin_rw_mutex.h>
 
 #include <boost/dynamic_bitset.hpp>
@@ -40,29 +41,44 @@ void DBRequest::Swap(DBRequest *rhs) {
 class DBTableBase::ListenerInfo {
 public:
     typedef vector<ChangeCallback> CallbackList;
+    typedef vector<int> FlagsList;
 
-    DBTableBase::ListenerId Register(ChangeCallback callback) {
+    ListenerInfo() {
+        final_state_count_ = 0;
+    }
+
+    DBTableBase::ListenerId Register(ChangeCallback callback, int flags) {
         tbb::spin_rw_mutex::scoped_lock write_lock(rw_mutex_, true);
         size_t i = bmap_.find_first();
         if (i == bmap_.npos) {
             i = callbacks_.size();
             callbacks_.push_back(callback);
+            flags_.push_back(flags);
         } else {
             bmap_.reset(i);
             if (bmap_.none()) {
                 bmap_.clear();
             }
             callbacks_[i] = callback;
+            flags_[i] = flags;
+        }
+        if (flags & LISTENER_FINAL_STATE_ONLY) {
+            final_state_count_++;
         }
         return i;
     }
 
     void Unregister(ListenerId listener) {
         tbb::spin_rw_mutex::scoped_lock write_lock(rw_mutex_, true);
+        if (flags_[listener] & LISTENER_FINAL_STATE_ONLY) {
+            final_state_count_--;
+        }
         callbacks_[listener] = NULL;
+        flags_[listener] = LISTENER_DEFAULT;
         if ((size_t) listener == callbacks_.size() - 1) {
             while (!callbacks_.empty() && callbacks_.back() == NULL) {
                 callbacks_.pop_back();
+                flags_.pop_back();
             }
             if (bmap_.size() > callbacks_.size()) {
                 bmap_.resize(callbacks_.size());
@@ -76,14 +92,19 @@ public:
     }
 
     // concurrency: called from DBPartition task.
-    void RunNotify(DBTablePartBase *tpart, DBEntryBase *entry) {
+    void RunNotify(DBTablePartBase *tpart, DBEntryBase *entry,
+                   bool final_state) {
         tbb::spin_rw_mutex::scoped_lock read_lock(rw_mutex_, false);
-        for (CallbackList::iterator iter = callbacks_.begin();
-             iter != callbacks_.end(); ++iter) {
-            if (*iter != NULL) {
-                ChangeCallback cb = *iter;
-                (cb)(tpart, entry);
+        for (size_t i = 0; i < callbacks_.size(); i++) {
+            if (callbacks_[i] == NULL) {
+                continue;
+            }
+            bool final_listener = (flags_[i] & LISTENER_FINAL_STATE_ONLY);
+            if (final_listener != final_state) {
+                continue;
             }
+            ChangeCallback cb = callbacks_[i];
+            (cb)(tpart, entry);
         }
     }
 
@@ -92,8 +113,14 @@ public:
         return callbacks_.empty(); 
     }
 
+    bool has_final_state() const {
+        return (final_state_count_ != 0);
+    }
+
 private:
     CallbackList callbacks_;
+    FlagsList flags_;
+    tbb::atomic<int> final_state_count_;
     tbb::spin_rw_mutex rw_mutex_;
     boost::dynamic_bitset<> bmap_;      // free list.
 };
@@ -105,8 +132,9 @@ DBTableBase::DBTableBase(DB *db, const string &name)
 DBTableBase::~DBTableBase() {
 }
 
-DBTableBase::ListenerId DBTableBase::Register(ChangeCallback callback) {
-    return info_->Register(callback);
+DBTableBase::ListenerId DBTableBase::Register(ChangeCallback callback,
+                                              int flags) {
+    return info_->Register(callback, flags);
 }
 
 void DBTableBase::Unregister(ListenerId listener) {
@@ -119,6 +147,27 @@ bool DBTableBase::Enqueue(DBRequest *req) {
     return partition->EnqueueRequest(tpart, NULL, req);
 }
 
+bool DBTableBase::EnqueueBatch(const vector<DBRequest *> &reqs) {
+    vector<DBPartition::RequestList> requests(DB::PartitionCount());
+    for (vector<DBRequest *>::const_iterator iter = reqs.begin();
+         iter != reqs.end(); ++iter) {
+        DBTablePartBase *tpart = GetTablePartition((*iter)->key.get());
+        requests[tpart->index()].push_back(make_pair(tpart, *iter));
+    }
+
+    bool ok = true;
+    for (size_t index = 0; index < requests.size(); index++) {
+        if (requests[index].empty()) {
+            continue;
+        }
+        DBPartition *partition = db_->GetPartition(index);
+        if (!partition->EnqueueRequestList(NULL, requests[index])) {
+            ok = false;
+        }
+    }
+    return ok;
+}
+
 void DBTableBase::EnqueueRemove(DBEntryBase *db_entry) {
     DBTablePartBase *tpart = GetTablePartition(db_entry);
     DBPartition *partition = db_->GetPartition(tpart->index());
@@ -126,13 +175,21 @@ void DBTableBase::EnqueueRemove(DBEntryBase *db_entry) {
 }
 
 void DBTableBase::RunNotify(DBTablePartBase *tpart, DBEntryBase *entry) {
-    info_->RunNotify(tpart, entry);
+    info_->RunNotify(tpart, entry, false);
+}
+
+void DBTableBase::RunFinalNotify(DBTablePartBase *tpart, DBEntryBase *entry) {
+    info_->RunNotify(tpart, entry, true);
 }
 
 bool DBTableBase::HasListeners() const {
     return !info_->empty();
 }
 
+bool DBTableBase::HasFinalStateListeners() const {
+    return info_->has_final_state();
+}
+
 ///////////////////////////////////////////////////////////
 // Implementation of DBTable methods
 ///////////////////////////////////////////////////////////
@@ -58,6 +58,11 @@ public:
 
     // Enqueue a request to the table. Takes ownership of the data.
     bool Enqueue(DBRequest *req);
+
+    // Enqueue a list of requests to the table in one shot. Takes ownership
+    // of the data of each request. The requests for each DB partition are
+    // handed to the partition as a single work queue entry.
+    bool EnqueueBatch(const std::vector<DBRequest *> &reqs);
     void EnqueueRemove(DBEntryBase *db_entry);
 
     // Determine the table partition depending on the record key.
@@ -71,11 +76,24 @@ public:
     virtual void Change(DBEntryBase *) = 0;
 
 
+    // Listener registration flags.
+    // FINAL_STATE_ONLY listeners are not notified of intermediate states of
+    // an entry. Their notification is held back while the DB partition still
+    // has input requests pending, so that a burst of changes to an entry
+    // results in a single callback. DBEntryBase::generation() tells the
+    // listener how far the entry has moved since it was last seen.
+    enum ListenerFlags {
+        LISTENER_DEFAULT = 0,
+        LISTENER_FINAL_STATE_ONLY = 1 << 0,
+    };
+
     // Register a DB listener.
-    ListenerId Register(ChangeCallback callback);
+    ListenerId Register(ChangeCallback callback,
+                        int flags = LISTENER_DEFAULT);
     void Unregister(ListenerId listener);
 
     void RunNotify(DBTablePartBase *tpart, DBEntryBase *entry);
+    void RunFinalNotify(DBTablePartBase *tpart, DBEntryBase *entry);
 
     // Calcuate the size across all partitions.
     virtual size_t Size() const { return 0; }
@@ -86,6 +104,7 @@ public:
     const std::string &name() const { return name_; }
 
     bool HasListeners() const;
+    bool HasFinalStateListeners() const;
 
     // Translates a DBRequest key to DBentry .... No search
 
@@ -15,6 +15,7 @@ using namespace std;
 
 // concurrency: called from DBPartition task.
 void DBTablePartBase::Notify(DBEntryBase *entry) {
+    entry->increment_generation();
     if (entry->is_onlist()) {
         return;
     }
@@ -30,17 +31,31 @@ void DBTablePartBase::Notify(DBEntryBase *entry) {
 
 // concurrency: called from DBPartition task.
 void DBTablePartBase::RunNotify() {
+    bool final_state = parent()->HasFinalStateListeners();
     while (!change_list_.empty()) {
         DBEntryBase *entry = &change_list_.front();
         change_list_.pop_front();
 
         parent()->RunNotify(this, entry);
 
+        // Final-state-only listeners are notified later, once the DB
+        // partition input has settled.
+        if (final_state && !entry->is_on_final_list()) {
+            entry->set_on_final_list();
+            bool was_empty = final_list_.empty();
+            final_list_.push_back(entry);
+            if (was_empty) {
+                DB *db = parent()->database();
+                DBPartition *partition = db->GetPartition(index_);
+                partition->OnTableFinalChange(this);
+            }
+        }
+
         // If the entry is marked deleted and all DBStates are removed
         // and it's not already on the remove queue, it can be removed
         // from the tree right away.
         if (entry->IsDeleted() && entry->is_state_empty(this) &&
-            !entry->IsOnRemoveQ()) {
+            !entry->IsOnRemoveQ() && !entry->is_on_final_list()) {
             Remove(entry);
         } else {
             entry->clear_onlist();
@@ -48,10 +63,42 @@ void DBTablePartBase::RunNotify() {
     }
 }
 
+// concurrency: called from DBPartition task.
+//
+// An entry that has been changed again since it was put on the final list
+// is skipped. It is put back on the final list when its pending change is
+// notified.
+void DBTablePartBase::RunFinalNotify() {
+    FinalList final_list;
+    final_list.swap(final_list_);
+    for (FinalList::iterator iter = final_list.begin();
+         iter != final_list.end(); ++iter) {
+        DBEntryBase *entry = *iter;
+        entry->clear_on_final_list();
+        if (entry->is_onlist()) {
+            continue;
+        }
+
+        parent()->RunFinalNotify(this, entry);
+
+        if (entry->IsDeleted() && entry->is_state_empty(this) &&
+            !entry->IsOnRemoveQ()) {
+            Remove(entry);
+        }
+    }
+}
+
 void DBTablePartBase::Delete(DBEntryBase *entry) {
     if (parent_->HasListeners()) {
         entry->MarkDelete();
         Notify(entry);
+    } else if (entry->is_on_final_list()) {
+        // The entry is removed by RunFinalNotify.
+        entry->MarkDelete();
+        if (entry->is_onlist()) {
+            change_list_.erase(change_list_.iterator_to(*entry));
+            entry->clear_onlist();
+        }
     } else {
         // Remove from change_list
         if (entry->is_onlist()) {
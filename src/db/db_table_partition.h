@@ -5,6 +5,7 @@
 #ifndef ctrlplane_db_table_partition_h
 #define ctrlplane_db_table_partition_h
 
+#include <vector>
 #include <boost/intrusive/list.hpp>
 #include <tbb/mutex.h>
 
@@ -21,6 +22,7 @@ public:
             &DBEntryBase::chg_list_> ChangeListMember; 
 
     typedef boost::intrusive::list<DBEntryBase, ChangeListMember> ChangeList;
+    typedef std::vector<DBEntryBase *> FinalList;
 
 
     DBTablePartBase(DBTableBase *tbl_base, int index)
@@ -36,6 +38,10 @@ public:
     // Run the notification queue.
     void RunNotify();
 
+    // Notify final-state-only listeners of the entries whose changes have
+    // settled.
+    void RunFinalNotify();
+
     DBTableBase *parent() { return parent_; }
     int index() const { return index_; }
 
@@ -58,6 +64,7 @@ private:
     DBTableBase *parent_;
     int index_;
     ChangeList change_list_;
+    FinalList final_list_;
     DISALLOW_COPY_AND_ASSIGN(DBTablePartBase);
 };
 
@@ -27,6 +27,7 @@ DBTableWalker::DBTableWalker() {
     walk_request_count_ = 0;
     walk_complete_count_ = 0;
     walk_cancel_count_ = 0;
+    walk_merge_count_ = 0;
 }
 class DBTableWalker::Walker {
 public:
@@ -34,6 +35,9 @@ public:
            const DBRequestKey *key, WalkFn walker, 
            WalkCompleteFn walk_done);
 
+    // Start a worker per table partition for a walk with a start key.
+    void StartWorkers();
+
     void StopWalk() {
         should_stop_.fetch_and_store(true);
     }
@@ -151,40 +155,291 @@ bool DBTableWalker::Worker::Run() {
     }
 
 walk_done:
+    PartitionDone(walker_);
+    return true;
+}
+
+// Called when a walker is done with a table partition. The walk complete
+// callback is invoked once the walker is done with all partitions.
+void DBTableWalker::PartitionDone(Walker *walker) {
     // Check whether all other walks on the table is completed
-    long num_walkers_on_tpart = walker_->status_.fetch_and_decrement();
+    long num_walkers_on_tpart = walker->status_.fetch_and_decrement();
     if (num_walkers_on_tpart == 1) {
         // Invoke Walker_Complete callback
-        if (!walker_->should_stop_) {
-            walker_->wkmgr_->update_walk_complete_count(+1);
+        if (!walker->should_stop_) {
+            walker->wkmgr_->update_walk_complete_count(+1);
         }
-        if (walker_->done_fn_ != NULL) {
-            if (!walker_->should_stop_) {
-                walker_->done_fn_(walker_->table_);
+        if (walker->done_fn_ != NULL) {
+            if (!walker->should_stop_) {
+                walker->done_fn_(walker->table_);
             }
         }
         // Release the memory for walker and bitmap
-        walker_->wkmgr_->PurgeWalker(walker_->id_);
+        walker->wkmgr_->PurgeWalker(walker->id_);
+    }
+}
+
+//
+// Per table state of the shared full table walks. There is a cursor per
+// table partition. A cursor is served by at most one SharedWorker at a time;
+// walkers requested while the worker is running are queued on the cursor
+// and picked up by the worker at its current position.
+//
+// Protected by the walkers_mutex_ of the DBTableWalker.
+//
+class DBTableWalker::SharedWalk {
+public:
+    struct Cursor {
+        Cursor() : worker(NULL) {
+            has_pending = false;
+        }
+        SharedWorker *worker;
+        WalkerList pending;
+        tbb::atomic<bool> has_pending;
+    };
+
+    SharedWalk(DBTable *table) : table_(table), active_(0) {
+        for (int i = 0; i < DB::PartitionCount(); i++) {
+            cursors_.push_back(new Cursor());
+        }
+    }
+    ~SharedWalk() {
+        STLDeleteValues(&cursors_);
+    }
+
+    DBTable *table_;
+    std::vector<Cursor *> cursors_;
+    // Number of cursors with a running worker
+    int active_;
+};
+
+class DBTableWalker::SharedWorker : public Task {
+public:
+    SharedWorker(DBTableWalker *wkmgr, SharedWalk *shared, int db_partition_id)
+        : Task(walker_task_id_, db_partition_id), wkmgr_(wkmgr),
+          shared_(shared), cursor_(shared->cursors_[db_partition_id]),
+          at_start_(true) {
+        tbl_partition_ = static_cast<DBTablePartition *>(
+            shared->table_->GetTablePartition(db_partition_id));
+    }
+    virtual ~SharedWorker() {
+        assert(attach_list_.empty());
+    }
+
+    virtual bool Run();
+
+private:
+    // A walker attached to this cursor. A walker attached after the cursor
+    // left the start of the partition remembers where it attached; it is
+    // done once the cursor wraps around to that position again.
+    struct Attachment {
+        Attachment(Walker *walker, DBEntry *start)
+            : walker(walker), start(start), wrapped(false) {
+        }
+        Walker *walker;
+        std::auto_ptr<DBEntry> start;
+        bool wrapped;
+    };
+    typedef std::list<Attachment *> AttachList;
+
+    DBEntry *Resume();
+    void AttachPending(DBEntry *entry);
+    bool Finish();
+    void Detach(AttachList::iterator it);
+
+    DBTableWalker *wkmgr_;
+    SharedWalk *shared_;
+    SharedWalk::Cursor *cursor_;
+    DBTablePartition *tbl_partition_;
+    AttachList attach_list_;
+
+    // Store the next node to visit to continue walk
+    std::auto_ptr<DBRequestKey> walk_ctx_;
+
+    // True if the cursor has not visited any entry in the current pass
+    bool at_start_;
+};
+
+DBEntry *DBTableWalker::SharedWorker::Resume() {
+    if (walk_ctx_.get() == NULL) {
+        return tbl_partition_->GetFirst();
+    }
+    std::auto_ptr<const DBEntryBase> start;
+    start = shared_->table_->AllocEntry(walk_ctx_.get());
+    walk_ctx_.reset();
+    return tbl_partition_->lower_bound(start.get());
+}
+
+// Pick up the walkers queued on the cursor. They start at the entry the
+// cursor is about to visit, which is never the end of a partition that has
+// been visited.
+void DBTableWalker::SharedWorker::AttachPending(DBEntry *entry) {
+    if (!cursor_->has_pending) {
+        return;
+    }
+
+    tbb::mutex::scoped_lock lock(wkmgr_->walkers_mutex_);
+    for (WalkerList::iterator it = cursor_->pending.begin();
+         it != cursor_->pending.end(); ++it) {
+        DBEntry *start = NULL;
+        if (!at_start_) {
+            std::auto_ptr<DBRequestKey> key = entry->GetDBRequestKey();
+            start = shared_->table_->AllocEntry(key.get()).release();
+        }
+        attach_list_.push_back(new Attachment(*it, start));
+    }
+    cursor_->pending.clear();
+    cursor_->has_pending = false;
+}
+
+// Returns true if the worker is done. Walkers may have been queued on the
+// cursor since the last check, in which case the worker keeps going.
+bool DBTableWalker::SharedWorker::Finish() {
+    tbb::mutex::scoped_lock lock(wkmgr_->walkers_mutex_);
+    if (!cursor_->pending.empty()) {
+        return false;
+    }
+    cursor_->worker = NULL;
+    if (--shared_->active_ == 0) {
+        wkmgr_->shared_walks_.erase(shared_->table_);
+        delete shared_;
     }
     return true;
 }
 
+void DBTableWalker::SharedWorker::Detach(AttachList::iterator it) {
+    Attachment *attach = *it;
+    attach_list_.erase(it);
+    Walker *walker = attach->walker;
+    delete attach;
+    PartitionDone(walker);
+}
+
+bool DBTableWalker::SharedWorker::Run() {
+    int count = 0;
+    DBEntry *entry = Resume();
+
+    while (true) {
+        if (entry == NULL && !at_start_) {
+            // End of the partition. Walkers that started at the beginning
+            // or have already wrapped around are done, the others wrap.
+            // Pending walkers are attached after the wrap, at the start.
+            for (AttachList::iterator it = attach_list_.begin();
+                 it != attach_list_.end(); ) {
+                AttachList::iterator curr = it++;
+                Attachment *attach = *curr;
+                if (attach->start.get() == NULL || attach->wrapped) {
+                    Detach(curr);
+                } else {
+                    attach->wrapped = true;
+                }
+            }
+            entry = tbl_partition_->GetFirst();
+            at_start_ = true;
+        }
+
+        AttachPending(entry);
+        if (attach_list_.empty()) {
+            if (Finish()) {
+                return true;
+            }
+            continue;
+        }
+
+        if (entry == NULL) {
+            // The partition is empty, there is nothing left to visit.
+            while (!attach_list_.empty()) {
+                Detach(attach_list_.begin());
+            }
+            continue;
+        }
+
+        if (count == GetIterationToYield()) {
+            // store the context
+            walk_ctx_ = entry->GetDBRequestKey();
+            return false;
+        }
+
+        DBEntry *next = tbl_partition_->GetNext(entry);
+        at_start_ = false;
+        for (AttachList::iterator it = attach_list_.begin();
+             it != attach_list_.end(); ) {
+            AttachList::iterator curr = it++;
+            Attachment *attach = *curr;
+
+            // Check whether Walker was requested to be cancelled
+            if (attach->walker->should_stop_) {
+                Detach(curr);
+                continue;
+            }
+
+            // Check whether the walker wrapped around to where it attached
+            if (attach->wrapped && !(*entry < *attach->start)) {
+                Detach(curr);
+                continue;
+            }
+
+            // Invoke walker function
+            bool more = attach->walker->walker_fn_(tbl_partition_, entry);
+            if (!more) {
+                Detach(curr);
+            }
+        }
+
+        db_walker_wait();
+        count++;
+        entry = next;
+    }
+}
+
 DBTableWalker::Walker::Walker(WalkId id, DBTableWalker *wkmgr,
                               DBTable *table, const DBRequestKey *key,
                               WalkFn walker, WalkCompleteFn walk_done)
     : id_(id), wkmgr_(wkmgr), table_(table),
       key_start_(const_cast<DBRequestKey *>(key)), 
       walker_fn_(walker), done_fn_(walk_done) {
-    int num_worker = DB::PartitionCount(); 
     should_stop_ = false;
-    status_ = num_worker;
+    status_ = DB::PartitionCount();
+}
+
+void DBTableWalker::Walker::StartWorkers() {
+    int num_worker = DB::PartitionCount(); 
     for (int i = 0; i < num_worker; i++) {
-        Worker *task = new Worker(this, i, key);
+        Worker *task = new Worker(this, i, key_start_.get());
         TaskScheduler *scheduler = TaskScheduler::GetInstance();
         scheduler->Enqueue(task);
     }
 }
 
+void DBTableWalker::AttachSharedWalk(Walker *walker) {
+    SharedWalk *shared;
+    SharedWalkMap::iterator loc = shared_walks_.find(walker->table_);
+    if (loc != shared_walks_.end()) {
+        shared = loc->second;
+    } else {
+        shared = new SharedWalk(walker->table_);
+        shared_walks_.insert(std::make_pair(walker->table_, shared));
+    }
+
+    bool merged = false;
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    for (int i = 0; i < DB::PartitionCount(); i++) {
+        SharedWalk::Cursor *cursor = shared->cursors_[i];
+        cursor->pending.push_back(walker);
+        cursor->has_pending = true;
+        if (cursor->worker != NULL) {
+            merged = true;
+            continue;
+        }
+        cursor->worker = new SharedWorker(this, shared, i);
+        shared->active_++;
+        scheduler->Enqueue(cursor->worker);
+    }
+    if (merged) {
+        walk_merge_count_++;
+    }
+}
+
 DBTableWalker::WalkId DBTableWalker::WalkTable(DBTable *table, 
                                                const DBRequestKey *key_start, 
                                                WalkFn walkerfn , 
@@ -192,20 +447,27 @@ DBTableWalker::WalkId DBTableWalker::WalkTable(DBTable *table,
     tbb::mutex::scoped_lock lock(walkers_mutex_);
     walk_request_count_++;
     size_t i = walker_map_.find_first();
+    Walker *walker;
     if (i == walker_map_.npos) {
         i = walkers_.size();
-        Walker *walker = new Walker(i, this, table, key_start, 
-                                    walkerfn, walk_complete);
+        walker = new Walker(i, this, table, key_start, walkerfn,
+                            walk_complete);
         walkers_.push_back(walker);
     } else {
         walker_map_.reset(i);
         if (walker_map_.none()) {
             walker_map_.clear();
         }
-        Walker *walker = new Walker(i, this, table, key_start, 
-                                    walkerfn, walk_complete);
+        walker = new Walker(i, this, table, key_start, walkerfn,
+                            walk_complete);
         walkers_[i] = walker;
     }
+
+    if (key_start == NULL) {
+        AttachSharedWalk(walker);
+    } else {
+        walker->StartWorkers();
+    }
     return i;
 }
 
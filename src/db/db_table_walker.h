@@ -5,6 +5,7 @@
 #ifndef ctrlplane_db_table_walker_h
 #define ctrlplane_db_table_walker_h
 
+#include <map>
 #include <boost/function.hpp>
 #include <boost/dynamic_bitset.hpp>
 #include <tbb/task.h>
@@ -15,6 +16,14 @@
 
 // A DB contains a TableWalker that is able to iterate though all the
 // entries in a certain routing table.
+//
+// Walks of a whole table (no start key) share a single cursor per table
+// partition. A walk requested while another full walk of the same table is
+// in progress attaches to the running cursor: each entry is visited once
+// and handed to all attached walkers. A walker that attached mid-way wraps
+// around to the start of the partition to cover the entries it missed.
+// Each walk keeps its own walk complete callback and can be cancelled
+// independently.
 class DBTableWalker {
 public:
 
@@ -51,6 +60,7 @@ public:
         walk_complete_count_ += inc;
     }
     uint64_t walk_cancel_count() { return walk_cancel_count_; }
+    uint64_t walk_merge_count() { return walk_merge_count_; }
 
 private:
     static const int kIterationToYield = 1024;
@@ -78,8 +88,23 @@ private:
     // A Job for walking through the DBTablePartition
     class Worker;
 
+    // Shared cursors for the full walks of a DBTable
+    class SharedWalk;
+
+    // A Job walking through the DBTablePartition on behalf of all the
+    // walkers attached to the shared cursor.
+    class SharedWorker;
+
     typedef std::vector<Walker *> WalkerList;
     typedef boost::dynamic_bitset<> WalkerMap;
+    typedef std::map<DBTable *, SharedWalk *> SharedWalkMap;
+
+    // Attach the walker to the shared cursors of its table, starting
+    // them if needed. Called with walkers_mutex_ held.
+    void AttachSharedWalk(Walker *walker);
+
+    // Called by a worker when it is done with a walker on its partition.
+    static void PartitionDone(Walker *walker);
 
     // Purge the walker after the walk is completed/cancelled
     void PurgeWalker(WalkId id);
@@ -88,10 +113,12 @@ private:
     tbb::mutex walkers_mutex_;
     WalkerList walkers_;
     WalkerMap walker_map_;
+    SharedWalkMap shared_walks_;
 
     uint64_t walk_request_count_;
     uint64_t walk_complete_count_;
     uint64_t walk_cancel_count_;
+    uint64_t walk_merge_count_;
 
     static int walker_task_id_;
 };
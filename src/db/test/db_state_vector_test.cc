@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <malloc.h>
+#include <iostream>
+#include <map>
+#include <vector>
+#include <boost/scoped_array.hpp>
+
+#include "base/logging.h"
+#include "db/db_entry.h"
+#include "db/db_state_vector.h"
+#include "testing/gunit.h"
+
+using namespace std;
+
+//
+// Environment variables for the benchmark:
+//     DB_STATE_BENCH_ENTRIES   - number of entries (default 200000)
+//     DB_STATE_BENCH_LISTENERS - listeners per entry (default 8)
+//
+class DBStateVectorTest : public ::testing::Test {
+protected:
+    typedef map<int, DBState *> StateMap;
+
+    DBStateVectorTest() {
+        entries_ = 200000;
+        char *str = getenv("DB_STATE_BENCH_ENTRIES");
+        if (str) entries_ = strtoul(str, NULL, 0);
+        listeners_ = 8;
+        str = getenv("DB_STATE_BENCH_LISTENERS");
+        if (str) listeners_ = strtoul(str, NULL, 0);
+    }
+
+    static size_t HeapInUse() {
+        struct mallinfo info = mallinfo();
+        return info.uordblks;
+    }
+
+    size_t entries_;
+    int listeners_;
+    DBState state_;
+};
+
+TEST_F(DBStateVectorTest, Basic) {
+    DBStateVector states;
+    EXPECT_TRUE(states.empty());
+    EXPECT_TRUE(states.Get(0) == NULL);
+    EXPECT_TRUE(states.Get(100) == NULL);
+
+    EXPECT_TRUE(states.Set(3, &state_));
+    EXPECT_FALSE(states.Set(3, &state_));
+    EXPECT_EQ(1U, states.size());
+    EXPECT_EQ(&state_, states.Get(3));
+    EXPECT_TRUE(states.Get(2) == NULL);
+
+    EXPECT_FALSE(states.Clear(2));
+    EXPECT_TRUE(states.Clear(3));
+    EXPECT_FALSE(states.Clear(3));
+    EXPECT_TRUE(states.empty());
+    EXPECT_EQ(0U, states.capacity());
+}
+
+// A NULL state counts towards the entry having state.
+TEST_F(DBStateVectorTest, NullState) {
+    DBStateVector states;
+    EXPECT_TRUE(states.Set(0, NULL));
+    EXPECT_FALSE(states.empty());
+    EXPECT_TRUE(states.Get(0) == NULL);
+    EXPECT_FALSE(states.Set(0, &state_));
+    EXPECT_EQ(&state_, states.Get(0));
+    EXPECT_TRUE(states.Clear(0));
+    EXPECT_TRUE(states.empty());
+}
+
+TEST_F(DBStateVectorTest, Grow) {
+    DBStateVector states;
+    vector<DBState> values(64);
+    for (int id = 63; id >= 0; id -= 3) {
+        EXPECT_TRUE(states.Set(id, &values[id]));
+    }
+    for (int id = 0; id < 64; id++) {
+        if ((63 - id) % 3 == 0) {
+            EXPECT_EQ(&values[id], states.Get(id));
+        } else {
+            EXPECT_TRUE(states.Get(id) == NULL);
+        }
+    }
+    EXPECT_EQ(22U, states.size());
+}
+
+// Compare memory and GetState latency of DBStateVector against the
+// std::map previously used by DBEntryBase.
+TEST_F(DBStateVectorTest, Benchmark) {
+    size_t start = HeapInUse();
+    vector<StateMap> maps(entries_);
+    size_t map_base = HeapInUse();
+    for (size_t i = 0; i < entries_; i++) {
+        for (int id = 0; id < listeners_; id++) {
+            maps[i].insert(make_pair(id, &state_));
+        }
+    }
+    size_t map_bytes = HeapInUse() - start;
+    size_t map_state_bytes = HeapInUse() - map_base;
+
+    uint64_t t0 = UTCTimestampUsec();
+    size_t found = 0;
+    for (size_t i = 0; i < entries_; i++) {
+        for (int id = 0; id < listeners_; id++) {
+            StateMap::const_iterator loc = maps[i].find(id);
+            if (loc != maps[i].end() && loc->second != NULL)
+                found++;
+        }
+    }
+    uint64_t map_usecs = UTCTimestampUsec() - t0;
+    EXPECT_EQ(entries_ * listeners_, found);
+    maps.clear();
+    vector<StateMap>().swap(maps);
+
+    start = HeapInUse();
+    boost::scoped_array<DBStateVector> vectors(new DBStateVector[entries_]);
+    size_t vector_base = HeapInUse();
+    for (size_t i = 0; i < entries_; i++) {
+        for (int id = 0; id < listeners_; id++) {
+            vectors[i].Set(id, &state_);
+        }
+    }
+    size_t vector_bytes = HeapInUse() - start;
+    size_t vector_state_bytes = HeapInUse() - vector_base;
+
+    t0 = UTCTimestampUsec();
+    found = 0;
+    for (size_t i = 0; i < entries_; i++) {
+        for (int id = 0; id < listeners_; id++) {
+            if (vectors[i].Get(id) != NULL)
+                found++;
+        }
+    }
+    uint64_t vector_usecs = UTCTimestampUsec() - t0;
+    EXPECT_EQ(entries_ * listeners_, found);
+
+    cout << "entries: " << entries_ << " listeners: " << listeners_ << endl;
+    cout << "std::map      bytes/entry: " << map_bytes / entries_
+         << " (states " << map_state_bytes / entries_ << ")"
+         << " lookup usecs: " << map_usecs << endl;
+    cout << "DBStateVector bytes/entry: " << vector_bytes / entries_
+         << " (states " << vector_state_bytes / entries_ << ")"
+         << " lookup usecs: " << vector_usecs << endl;
+    EXPECT_LT(vector_bytes, map_bytes);
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -5,6 +5,8 @@
 #ifndef db_test_cmn_h
 #define db_test_cmn_h
 
+#include <set>
+
 #include "io/event_manager.h"
 #include "base/task.h"
 #include "base/test/task_test_util.h"
@@ -23,8 +25,16 @@ class DBTest : public ::testing::Test {
 protected:
     tbb::atomic<long> adc_notification;
     tbb::atomic<long> del_notification;
+    tbb::atomic<long> final_notification;
+    tbb::atomic<uint32_t> final_generation;
+    tbb::atomic<bool> final_deleted;
     tbb::atomic<long> walk_count_;
     tbb::atomic<bool> walk_done_;
+    tbb::atomic<long> shared_walk_count_[3];
+    tbb::atomic<bool> shared_walk_done_[3];
+    std::set<int> shared_walk_tags_[3];
+    tbb::mutex shared_walk_mutex_;
+    tbb::atomic<bool> shared_walk_queued_;
 public:
     DBTest() { 
         itbl = static_cast<VlanTable *>(db_.CreateTable("db.test.vlan.0"));
@@ -50,6 +60,35 @@ public:
         }
     }
 
+    void DBTestFinalListener(DBTablePartBase *root, DBEntryBase *entry) {
+        final_notification++;
+        final_generation = entry->generation();
+        final_deleted = entry->IsDeleted();
+    }
+
+    // On a change of vlan 11, releases the state held on the deleted vlan 10
+    // and notifies it again, with more input pending. Vlan 10 then sits on
+    // both the remove queue and the final list.
+    void DBTestRemoveQListener(DBTablePartBase *root, DBEntryBase *entry) {
+        Vlan *vlan = static_cast<Vlan *>(entry);
+        if (vlan->IsDeleted() || vlan->getTag() != 11) {
+            return;
+        }
+        VlanTableReqKey key(10);
+        Vlan *held = itbl->Find(&key);
+        if (held == NULL || held->GetState(itbl, tid_) == NULL) {
+            return;
+        }
+        held->ClearState(itbl, tid_);
+        itbl->GetTablePartition(held)->Notify(held);
+
+        DBRequest dbReq;
+        dbReq.key.reset(new VlanTableReqKey(12));
+        dbReq.data.reset(new VlanTableReqData("DB Test Vlan"));
+        dbReq.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+        EXPECT_TRUE(itbl->Enqueue(&dbReq));
+    }
+
     bool TableWalk(DBTablePartBase *root, DBEntryBase *entry) {
         walk_count_++;
         return true;
@@ -59,6 +98,42 @@ public:
         walk_done_ = true;
     }
 
+    bool SharedTableWalk(int index, DBTablePartBase *root,
+                         DBEntryBase *entry) {
+        Vlan *vlan = static_cast<Vlan *>(entry);
+        shared_walk_count_[index]++;
+        {
+            tbb::mutex::scoped_lock lock(shared_walk_mutex_);
+            shared_walk_tags_[index].insert(vlan->getTag());
+        }
+        if (index == 0 && shared_walk_count_[0] == 100) {
+            DBTable *table = static_cast<DBTable *>(itbl);
+            db_.GetWalker()->WalkTable(table, NULL,
+                boost::bind(&DBTest::SharedTableWalk, this, 2, _1, _2),
+                boost::bind(&DBTest::SharedWalkDone, this, 2, _1));
+        }
+        return true;
+    }
+
+    // Starts walker 2 when walker 0 visits the last entry of a partition,
+    // so that the new walk is queued while that cursor is at the end.
+    bool SharedTableWalkAtEnd(DBTablePartBase *root, DBEntryBase *entry) {
+        SharedTableWalk(0, root, entry);
+        if (root->GetNext(entry) != NULL ||
+            shared_walk_queued_.compare_and_swap(true, false)) {
+            return true;
+        }
+        DBTable *table = static_cast<DBTable *>(itbl);
+        db_.GetWalker()->WalkTable(table, NULL,
+            boost::bind(&DBTest::SharedTableWalk, this, 2, _1, _2),
+            boost::bind(&DBTest::SharedWalkDone, this, 2, _1));
+        return true;
+    }
+
+    void SharedWalkDone(int index, DBTableBase *tbl) {
+        shared_walk_done_[index] = true;
+    }
+
 
     void DBTestListener_1(DBTablePartBase *root, DBEntryBase *entry) {
         Vlan *vlan = static_cast<Vlan *>(entry);
@@ -520,6 +595,107 @@ TEST_F(DBTest, JWalker) {
     EXPECT_TRUE(del_notification == walk_count);
 }
 
+// To Test:
+// Verify that concurrent full walks of a table share the walk and that a
+// walk started mid-way wraps around to visit every entry
+TEST_F(DBTest, SharedWalk) {
+    DBTable *table = dynamic_cast<DBTable *>(itbl);
+    if (table == NULL) {
+        return;
+    }
+
+    int walk_count = 1024;
+    for (int i = 0; i < walk_count; i++) {
+        DBRequest addReq;
+        addReq.key.reset(new VlanTableReqKey(i));
+        addReq.data.reset(new VlanTableReqData("DB Test Vlan"));
+        addReq.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+        EXPECT_TRUE(itbl->Enqueue(&addReq));
+    }
+    task_util::WaitForIdle();
+
+    for (int i = 0; i < 3; i++) {
+        shared_walk_count_[i] = 0;
+        shared_walk_done_[i] = false;
+        shared_walk_tags_[i].clear();
+    }
+
+    // Walker 1 is requested before walker 0 gets to run and attaches to the
+    // same cursor. Walker 0 starts walker 2 from its walk function.
+    DBTableWalker *walker = db_.GetWalker();
+    uint64_t merge_count = walker->walk_merge_count();
+    task_util::TaskSchedulerStop();
+    for (int i = 0; i < 2; i++) {
+        walker->WalkTable(table, NULL,
+            boost::bind(&DBTest::SharedTableWalk, this, i, _1, _2),
+            boost::bind(&DBTest::SharedWalkDone, this, i, _1));
+    }
+    task_util::TaskSchedulerStart();
+    task_util::WaitForIdle();
+
+    EXPECT_EQ(merge_count + 2, walker->walk_merge_count());
+    for (int i = 0; i < 3; i++) {
+        EXPECT_TRUE(shared_walk_done_[i]);
+        EXPECT_EQ(walk_count, shared_walk_count_[i]);
+        EXPECT_EQ((size_t) walk_count, shared_walk_tags_[i].size());
+    }
+
+    for (int i = 0; i < walk_count; i++) {
+        DBRequest delReq;
+        delReq.key.reset(new VlanTableReqKey(i));
+        delReq.oper = DBRequest::DB_ENTRY_DELETE;
+        EXPECT_TRUE(itbl->Enqueue(&delReq));
+    }
+    task_util::WaitForIdle();
+}
+
+// To Test:
+// Verify that a walk queued while the shared cursor is at the end of a
+// partition still visits that partition
+TEST_F(DBTest, SharedWalkAtPartitionEnd) {
+    DBTable *table = dynamic_cast<DBTable *>(itbl);
+    if (table == NULL) {
+        return;
+    }
+
+    int walk_count = 256;
+    for (int i = 0; i < walk_count; i++) {
+        DBRequest addReq;
+        addReq.key.reset(new VlanTableReqKey(i));
+        addReq.data.reset(new VlanTableReqData("DB Test Vlan"));
+        addReq.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+        EXPECT_TRUE(itbl->Enqueue(&addReq));
+    }
+    task_util::WaitForIdle();
+
+    for (int i = 0; i < 3; i++) {
+        shared_walk_count_[i] = 0;
+        shared_walk_done_[i] = false;
+        shared_walk_tags_[i].clear();
+    }
+    shared_walk_queued_ = false;
+
+    db_.GetWalker()->WalkTable(table, NULL,
+        boost::bind(&DBTest::SharedTableWalkAtEnd, this, _1, _2),
+        boost::bind(&DBTest::SharedWalkDone, this, 0, _1));
+    task_util::WaitForIdle();
+
+    EXPECT_TRUE(shared_walk_queued_);
+    EXPECT_TRUE(shared_walk_done_[0]);
+    EXPECT_EQ(walk_count, shared_walk_count_[0]);
+    EXPECT_TRUE(shared_walk_done_[2]);
+    EXPECT_EQ(walk_count, shared_walk_count_[2]);
+    EXPECT_EQ((size_t) walk_count, shared_walk_tags_[2].size());
+
+    for (int i = 0; i < walk_count; i++) {
+        DBRequest delReq;
+        delReq.key.reset(new VlanTableReqKey(i));
+        delReq.oper = DBRequest::DB_ENTRY_DELETE;
+        EXPECT_TRUE(itbl->Enqueue(&delReq));
+    }
+    task_util::WaitForIdle();
+}
+
 // To Test:
 // Verify Bulk ADD DELETE of objects to DBTable
 TEST_F(DBTest, Bulk) {
@@ -590,6 +766,232 @@ TEST_F(DBTest, Bulk) {
     del_notification = 0;
 }
 
+// To Test:
+// Verify ADD and DELETE of objects enqueued as a single batch
+TEST_F(DBTest, EnqueueBatch) {
+    int bulk_count = 100;
+    tid_ = 
+        itbl->Register(boost::bind(&DBTest::DBTestListener, this, _1, _2));
+    EXPECT_EQ(tid_, 0);
+
+    adc_notification = 0;
+    del_notification = 0;
+
+    // Add all VLANs and delete every other one in the same batch. Requests
+    // must be processed in order.
+    std::vector<DBRequest *> reqs;
+    for (int i = 0; i < bulk_count; i++) {
+        DBRequest *addReq = new DBRequest();
+        addReq->key.reset(new VlanTableReqKey(i));
+        addReq->data.reset(new VlanTableReqData("DB Test Vlan"));
+        addReq->oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+        reqs.push_back(addReq);
+    }
+    for (int i = 0; i < bulk_count; i += 2) {
+        DBRequest *delReq = new DBRequest();
+        delReq->key.reset(new VlanTableReqKey(i));
+        delReq->oper = DBRequest::DB_ENTRY_DELETE;
+        reqs.push_back(delReq);
+    }
+    EXPECT_TRUE(itbl->EnqueueBatch(reqs));
+    STLDeleteValues(&reqs);
+    task_util::WaitForIdle();
+
+    for (int i = 0; i < bulk_count; i++) {
+        VlanTableReqKey lookupKey(i);
+        Vlan *vlan = itbl->Find(&lookupKey);
+        if (i % 2) {
+            EXPECT_TRUE(vlan != NULL);
+        } else {
+            EXPECT_TRUE(vlan == NULL);
+        }
+    }
+
+    for (int i = 1; i < bulk_count; i += 2) {
+        DBRequest *delReq = new DBRequest();
+        delReq->key.reset(new VlanTableReqKey(i));
+        delReq->oper = DBRequest::DB_ENTRY_DELETE;
+        reqs.push_back(delReq);
+    }
+    EXPECT_TRUE(itbl->EnqueueBatch(reqs));
+    STLDeleteValues(&reqs);
+    task_util::WaitForIdle();
+
+    for (int i = 0; i < bulk_count; i++) {
+        VlanTableReqKey lookupKey(i);
+        EXPECT_TRUE(itbl->Find(&lookupKey) == NULL);
+    }
+    itbl->Unregister(tid_);
+
+    adc_notification = 0;
+    del_notification = 0;
+}
+
+// To Test:
+// Verify that a burst of changes results in a single notification with the
+// latest generation for final-state-only listeners
+TEST_F(DBTest, FinalStateListener) {
+    tid_ = 
+        itbl->Register(boost::bind(&DBTest::DBTestListener, this, _1, _2));
+    tid_1_ = itbl->Register(
+        boost::bind(&DBTest::DBTestFinalListener, this, _1, _2),
+        DBTableBase::LISTENER_FINAL_STATE_ONLY);
+    EXPECT_TRUE(itbl->HasFinalStateListeners());
+
+    adc_notification = 0;
+    final_notification = 0;
+    final_generation = 0;
+    final_deleted = false;
+
+    std::vector<DBRequest *> reqs;
+    for (int i = 0; i < 4; i++) {
+        DBRequest *addReq = new DBRequest();
+        addReq->key.reset(new VlanTableReqKey(10));
+        addReq->data.reset(new VlanTableReqData("DB Test Vlan"));
+        addReq->oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+        reqs.push_back(addReq);
+    }
+    EXPECT_TRUE(itbl->EnqueueBatch(reqs));
+    STLDeleteValues(&reqs);
+    task_util::WaitForIdle();
+
+    EXPECT_EQ(1, final_notification);
+    EXPECT_EQ(4U, final_generation);
+    EXPECT_FALSE(final_deleted);
+
+    DBRequest delReq;
+    delReq.key.reset(new VlanTableReqKey(10));
+    delReq.oper = DBRequest::DB_ENTRY_DELETE;
+    EXPECT_TRUE(itbl->Enqueue(&delReq));
+    task_util::WaitForIdle();
+
+    EXPECT_EQ(2, final_notification);
+    EXPECT_EQ(5U, final_generation);
+    EXPECT_TRUE(final_deleted);
+
+    VlanTableReqKey lookupKey(10);
+    EXPECT_TRUE(itbl->Find(&lookupKey) == NULL);
+
+    itbl->Unregister(tid_1_);
+    itbl->Unregister(tid_);
+    EXPECT_FALSE(itbl->HasFinalStateListeners());
+    adc_notification = 0;
+    del_notification = 0;
+}
+
+// To Test:
+// Verify that an entry on both the remove queue and the final list is
+// removed by the final notification, and only once
+TEST_F(DBTest, FinalStateListenerRemoveQueue) {
+    tid_ = itbl->Register(
+        boost::bind(&DBTest::DBTestRemoveQListener, this, _1, _2));
+    tid_1_ = itbl->Register(
+        boost::bind(&DBTest::DBTestFinalListener, this, _1, _2),
+        DBTableBase::LISTENER_FINAL_STATE_ONLY);
+
+    for (int i = 10; i <= 11; i++) {
+        DBRequest addReq;
+        addReq.key.reset(new VlanTableReqKey(i));
+        addReq.data.reset(new VlanTableReqData("DB Test Vlan"));
+        addReq.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+        EXPECT_TRUE(itbl->Enqueue(&addReq));
+    }
+    task_util::WaitForIdle();
+
+    VlanTableReqKey key(10);
+    Vlan *vlan = itbl->Find(&key);
+    ASSERT_TRUE(vlan != NULL);
+    VlanState mystate(5);
+    vlan->SetState(itbl, tid_, &mystate);
+
+    DBRequest delReq;
+    delReq.key.reset(new VlanTableReqKey(10));
+    delReq.oper = DBRequest::DB_ENTRY_DELETE;
+    EXPECT_TRUE(itbl->Enqueue(&delReq));
+    task_util::WaitForIdle();
+
+    vlan = itbl->Find(&key);
+    ASSERT_TRUE(vlan != NULL);
+    EXPECT_TRUE(vlan->IsDeleted());
+
+    final_notification = 0;
+    DBRequest changeReq;
+    changeReq.key.reset(new VlanTableReqKey(11));
+    changeReq.data.reset(new VlanTableReqData("DB Test Vlan"));
+    changeReq.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+    EXPECT_TRUE(itbl->Enqueue(&changeReq));
+    task_util::WaitForIdle();
+
+    EXPECT_TRUE(itbl->Find(&key) == NULL);
+    VlanTableReqKey key12(12);
+    EXPECT_TRUE(itbl->Find(&key12) != NULL);
+    EXPECT_EQ(3, final_notification);
+
+    for (int i = 11; i <= 12; i++) {
+        DBRequest req;
+        req.key.reset(new VlanTableReqKey(i));
+        req.oper = DBRequest::DB_ENTRY_DELETE;
+        EXPECT_TRUE(itbl->Enqueue(&req));
+    }
+    task_util::WaitForIdle();
+
+    itbl->Unregister(tid_1_);
+    itbl->Unregister(tid_);
+    adc_notification = 0;
+    del_notification = 0;
+}
+
+// To Test:
+// Verify that a batch larger than the runner time budget is resumed across
+// runs and stays ordered with the requests enqueued after it
+TEST_F(DBTest, EnqueueLargeBatch) {
+    int bulk_count = 20000;
+    tid_ = 
+        itbl->Register(boost::bind(&DBTest::DBTestListener, this, _1, _2));
+
+    std::vector<DBRequest *> reqs;
+    for (int i = 0; i < bulk_count; i++) {
+        DBRequest *addReq = new DBRequest();
+        addReq->key.reset(new VlanTableReqKey(i));
+        addReq->data.reset(new VlanTableReqData("DB Test Vlan"));
+        addReq->oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+        reqs.push_back(addReq);
+    }
+    itbl->EnqueueBatch(reqs);
+    STLDeleteValues(&reqs);
+
+    // Delete the last VLAN of the batch with a single request.
+    DBRequest delReq;
+    delReq.key.reset(new VlanTableReqKey(bulk_count - 1));
+    delReq.oper = DBRequest::DB_ENTRY_DELETE;
+    itbl->Enqueue(&delReq);
+    task_util::WaitForIdle();
+
+    for (int i = 0; i < bulk_count; i++) {
+        VlanTableReqKey lookupKey(i);
+        Vlan *vlan = itbl->Find(&lookupKey);
+        EXPECT_EQ(i != bulk_count - 1, vlan != NULL);
+    }
+
+    for (int i = 0; i < bulk_count - 1; i++) {
+        DBRequest *delReq = new DBRequest();
+        delReq->key.reset(new VlanTableReqKey(i));
+        delReq->oper = DBRequest::DB_ENTRY_DELETE;
+        reqs.push_back(delReq);
+    }
+    itbl->EnqueueBatch(reqs);
+    STLDeleteValues(&reqs);
+    task_util::WaitForIdle();
+    for (int i = 0; i < bulk_count; i++) {
+        VlanTableReqKey lookupKey(i);
+        EXPECT_TRUE(itbl->Find(&lookupKey) == NULL);
+    }
+    itbl->Unregister(tid_);
+
+    adc_notification = 0;
+    del_notification = 0;
+}
+
 // To Test:
 // Verify that requests enqueued when a notification running is serviced
 TEST_F(DBTest, ReqInNotifyPath) {
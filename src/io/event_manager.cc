@@ -3,15 +3,88 @@
  */
 
 #include "io/event_manager.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <boost/scoped_ptr.hpp>
+#include <tbb/task_scheduler_init.h>
+
 #include "base/logging.h"
+#include "base/task.h"
 #include "io/io_log.h"
 
 using namespace boost::asio;
 
 SandeshTraceBufferPtr IOTraceBuf(SandeshTraceBufferCreate(IO_TRACE_BUF, 1000));
 
+// Thread running an io_service of its own until it is stopped.
+class EventManager::IoThread {
+public:
+    IoThread() : work_(new io_service::work(io_service_)) {
+        int res = pthread_create(&thread_id_, NULL, &ThreadRun, this);
+        assert(res == 0);
+    }
+
+    ~IoThread() {
+        Stop();
+        int res = pthread_join(thread_id_, NULL);
+        assert(res == 0);
+    }
+
+    void Stop() {
+        work_.reset();
+        io_service_.stop();
+    }
+
+    io_service *get_io_service() { return &io_service_; }
+
+private:
+    static void *ThreadRun(void *objp) {
+        IoThread *obj = reinterpret_cast<IoThread *>(objp);
+        tbb::task_scheduler_init init(TaskScheduler::GetThreadCount() + 1);
+        boost::system::error_code ec;
+        obj->io_service_.run(ec);
+        if (ec) {
+            EVENT_MANAGER_LOG_ERROR("io_service run failed: " << ec.message());
+        }
+        return NULL;
+    }
+
+    io_service io_service_;
+    boost::scoped_ptr<io_service::work> work_;
+    pthread_t thread_id_;
+
+    DISALLOW_COPY_AND_ASSIGN(IoThread);
+};
+
 EventManager::EventManager() {
+    int io_threads = 0;
+    char *str = getenv("EVENT_MANAGER_IO_THREADS");
+    if (str) io_threads = strtol(str, NULL, 0);
+    Initialize(io_threads);
+}
+
+EventManager::EventManager(int io_threads) {
+    Initialize(io_threads);
+}
+
+EventManager::~EventManager() {
+    STLDeleteValues(&io_threads_);
+}
+
+void EventManager::Initialize(int io_threads) {
     shutdown_ = false;
+    next_io_thread_ = 0;
+    for (int i = 0; i < io_threads; i++) {
+        io_threads_.push_back(new IoThread());
+    }
+}
+
+io_service *EventManager::NextIoService() {
+    if (io_threads_.empty())
+        return &io_service_;
+    size_t index = next_io_thread_.fetch_and_increment() % io_threads_.size();
+    return io_threads_[index]->get_io_service();
 }
 
 void EventManager::Shutdown() {
@@ -19,6 +92,9 @@ void EventManager::Shutdown() {
 
     // TODO: make sure that are no users of this event manager.
     io_service_.stop();
+    for (size_t i = 0; i < io_threads_.size(); i++) {
+        io_threads_[i]->Stop();
+    }
 }
 
 void EventManager::Run() {
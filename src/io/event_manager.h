@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <vector>
 #include <boost/asio/io_service.hpp>
+#include <tbb/atomic.h>
 #include <tbb/spin_mutex.h>
 
 #include "base/util.h"
@@ -18,9 +20,19 @@
 // Poll directly or indirectly after having started a ServerThread (which
 // calls Run).
 //
+// Optionally, the EventManager also runs a pool of I/O threads, each with an
+// io_service of its own. TcpServer places the socket of every new session on
+// one of them, so socket I/O of different sessions runs in parallel while all
+// the handlers of a session still run one at a time on the same thread.
+// Timers, acceptors and everything else stay on the main io_service. The
+// number of I/O threads defaults to the EVENT_MANAGER_IO_THREADS environment
+// variable, or 0 to run everything on the main io_service.
+//
 class EventManager {
 public:
     EventManager();
+    explicit EventManager(int io_threads);
+    ~EventManager();
 
     // Run until shutdown.
     void Run();
@@ -35,10 +47,22 @@ public:
 
     boost::asio::io_service *io_service() { return &io_service_; }
 
+    // Returns the io_service for the socket of a new session. The I/O threads
+    // take turns, the main io_service is used if there are none.
+    boost::asio::io_service *NextIoService();
+
+    int io_thread_count() const { return io_threads_.size(); }
+
 private:
+    class IoThread;
+
+    void Initialize(int io_threads);
+
     boost::asio::io_service io_service_;
     bool shutdown_;
     tbb::spin_mutex mutex_;
+    std::vector<IoThread *> io_threads_;
+    tbb::atomic<size_t> next_io_thread_;
 
     DISALLOW_COPY_AND_ASSIGN(EventManager);
 };
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "io/tcp_buffer_pool.h"
+
+using tbb::mutex;
+
+const size_t TcpBufferPool::kMinBufferSize;
+const size_t TcpBufferPool::kMaxBufferSize;
+const size_t TcpBufferPool::kMaxFreeBytes;
+
+TcpBufferPool::TcpBufferPool() {
+    alloc_count_ = 0;
+    reuse_count_ = 0;
+}
+
+TcpBufferPool::~TcpBufferPool() {
+    for (int i = 0; i < kSizeClasses; i++) {
+        for (size_t j = 0; j < free_list_[i].size(); j++) {
+            delete[] free_list_[i][j];
+        }
+    }
+}
+
+// Smallest size class that fits size, or the largest one.
+int TcpBufferPool::SizeClass(size_t size) {
+    int size_class = 0;
+    while (size_class < kSizeClasses - 1 && ClassSize(size_class) < size) {
+        size_class++;
+    }
+    return size_class;
+}
+
+uint8_t *TcpBufferPool::Allocate(size_t *size) {
+    int size_class = SizeClass(*size);
+    *size = ClassSize(size_class);
+    {
+        mutex::scoped_lock lock(mutex_);
+        std::vector<uint8_t *> &free_list = free_list_[size_class];
+        if (!free_list.empty()) {
+            uint8_t *data = free_list.back();
+            free_list.pop_back();
+            reuse_count_++;
+            return data;
+        }
+    }
+    alloc_count_++;
+    return new uint8_t[*size];
+}
+
+void TcpBufferPool::Release(uint8_t *data, size_t size) {
+    int size_class = SizeClass(size);
+    if (ClassSize(size_class) == size) {
+        mutex::scoped_lock lock(mutex_);
+        std::vector<uint8_t *> &free_list = free_list_[size_class];
+        if ((free_list.size() + 1) * size <= kMaxFreeBytes) {
+            free_list.push_back(data);
+            return;
+        }
+    }
+    delete[] data;
+}
+
+size_t TcpBufferPool::free_count() const {
+    mutex::scoped_lock lock(mutex_);
+    size_t count = 0;
+    for (int i = 0; i < kSizeClasses; i++) {
+        count += free_list_[i].size();
+    }
+    return count;
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef __TCP_BUFFER_POOL_H__
+#define __TCP_BUFFER_POOL_H__
+
+#include <stdint.h>
+#include <vector>
+#include <tbb/atomic.h>
+#include <tbb/mutex.h>
+
+#include "base/util.h"
+
+// TcpBufferPool
+//
+// Receive buffers shared by the sessions of a TcpServer, in power of two
+// size classes from kMinBufferSize to kMaxBufferSize. Released buffers are
+// kept on a free list per size class, up to kMaxFreeBytes per class, and
+// handed out again by later allocations of the same class.
+//
+// Concurrency: buffers are allocated by the event manager thread and
+// released from the session reader tasks.
+class TcpBufferPool {
+public:
+    static const size_t kMinBufferSize = 4 * 1024;
+    static const size_t kMaxBufferSize = 64 * 1024;
+    static const size_t kMaxFreeBytes = 1024 * 1024;
+
+    TcpBufferPool();
+    ~TcpBufferPool();
+
+    // Returns a buffer of the size class that fits size, capped at
+    // kMaxBufferSize, and updates size to the size of the buffer.
+    uint8_t *Allocate(size_t *size);
+
+    // Size must be the size returned by Allocate.
+    void Release(uint8_t *data, size_t size);
+
+    uint64_t alloc_count() const { return alloc_count_; }
+    uint64_t reuse_count() const { return reuse_count_; }
+    size_t free_count() const;
+
+private:
+    static const int kSizeClasses = 5;
+
+    static int SizeClass(size_t size);
+    static size_t ClassSize(int size_class) {
+        return kMinBufferSize << size_class;
+    }
+
+    mutable tbb::mutex mutex_;
+    std::vector<uint8_t *> free_list_[kSizeClasses];
+    tbb::atomic<uint64_t> alloc_count_;
+    tbb::atomic<uint64_t> reuse_count_;
+
+    DISALLOW_COPY_AND_ASSIGN(TcpBufferPool);
+};
+
+#endif // __TCP_BUFFER_POOL_H__
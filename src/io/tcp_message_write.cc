@@ -4,6 +4,8 @@
 
 #include "io/tcp_message_write.h"
 
+#include <algorithm>
+
 #include "base/util.h"
 #include "base/logging.h"
 #include "io/tcp_session.h"
@@ -13,29 +15,32 @@ using namespace boost::asio;
 using namespace boost::system;
 using tbb::mutex;
 
+const size_t TcpMessageWriter::kChunkSize;
+const size_t TcpMessageWriter::kMaxWriteChunks;
+const size_t TcpMessageWriter::kDefaultHighWatermark;
+const size_t TcpMessageWriter::kDefaultLowWatermark;
+
 TcpMessageWriter::TcpMessageWriter(Socket *socket, TcpSession *session) :
-    socket_(socket), offset_(0), session_(session) {
+    socket_(socket), offset_(0), pending_bytes_(0),
+    high_watermark_(kDefaultHighWatermark),
+    low_watermark_(kDefaultLowWatermark), blocked_(false),
+    session_(session) {
+    write_buffers_.reserve(kMaxWriteChunks);
 }
 
 TcpMessageWriter::~TcpMessageWriter() {
-    for (BufferQueue::iterator iter = buffer_queue_.begin();
-         iter != buffer_queue_.end(); ++iter) {
-        DeleteBuffer(*iter);
-    }
-    buffer_queue_.clear();
 }
 
 int TcpMessageWriter::Send(const uint8_t *data, size_t len, error_code &ec) {
     int wrote = 0;
 
     // Update socket write call statistics.
-    session_->stats_.write_calls++;
     session_->stats_.write_bytes += len;
-
-    session_->server_->stats_.write_calls++;
     session_->server_->stats_.write_bytes += len;
 
     if (buffer_queue_.empty()) {
+        session_->stats_.write_calls++;
+        session_->server_->stats_.write_calls++;
         wrote = socket_->write_some(boost::asio::buffer(data, len), ec);
         if (TcpSession::IsSocketErrorHard(ec)) return -1;
         assert(wrote >= 0);
@@ -52,9 +57,18 @@ int TcpMessageWriter::Send(const uint8_t *data, size_t len, error_code &ec) {
             "Write not ready. Enqueue buffer (len = " << len << ") and return");
         BufferAppend(data, len);
     }
+
+    if (pending_bytes_ > high_watermark_) {
+        blocked_ = true;
+    }
     return wrote;
 }
 
+void TcpMessageWriter::SetWatermarks(size_t high, size_t low) {
+    high_watermark_ = high;
+    low_watermark_ = std::min(low, high);
+}
+
 void TcpMessageWriter::DeferWrite() {
 
     // Update socket write block count.
@@ -68,6 +82,26 @@ void TcpMessageWriter::DeferWrite() {
     return;
 }
 
+// Writes up to kMaxWriteChunks chunks from the head of the queue with a
+// single gathered write.
+int TcpMessageWriter::WriteBuffers(size_t *requested, error_code &ec) {
+    write_buffers_.clear();
+    *requested = 0;
+    size_t offset = offset_;
+    for (BufferQueue::const_iterator iter = buffer_queue_.begin();
+         iter != buffer_queue_.end() &&
+         write_buffers_.size() < kMaxWriteChunks; ++iter) {
+        size_t size = iter->size() - offset;
+        write_buffers_.push_back(const_buffer(&(*iter)[offset], size));
+        *requested += size;
+        offset = 0;
+    }
+
+    session_->stats_.write_calls++;
+    session_->server_->stats_.write_calls++;
+    return socket_->write_some(write_buffers_, ec);
+}
+
 // Socket is ready for write. Flush any pending data and notify 
 // clients aboout it.
 void TcpMessageWriter::HandleWriteReady(TcpSessionPtr session_ptr,
@@ -90,28 +124,25 @@ void TcpMessageWriter::HandleWriteReady(TcpSessionPtr session_ptr,
     if (session_->IsClosedLocked()) return;
 
     while (!buffer_queue_.empty()) {
-        boost::asio::mutable_buffer head = buffer_queue_.front();
-        const uint8_t *data = buffer_cast<const uint8_t *>(head) + offset_;
-        int remaining = buffer_size(head) - offset_;
+        size_t requested;
         error_code ec;
-        int wrote = socket_->write_some(buffer(data, remaining), ec);
+        int wrote = WriteBuffers(&requested, ec);
         if (TcpSession::IsSocketErrorHard(ec)) {
             lock.release();
             if (!cb_.empty()) cb_(ec);
             return;
         }
         assert(wrote >= 0);
-        if (wrote != remaining) {
-            offset_ += wrote;
+        BufferConsume(wrote);
+        if ((size_t)wrote != requested) {
             DeferWrite();
-            return;
-        } else {
-            offset_ = 0;
-            DeleteBuffer(head);
-            buffer_queue_.pop_front();
+            break;
         }
     }
-    buffer_queue_.clear();
+
+    // Only notify a client that was told the writer is not ready.
+    if (!blocked_ || pending_bytes_ > low_watermark_) return;
+    blocked_ = false;
 
 done:
     lock.release();
@@ -124,17 +155,37 @@ done:
     return;
 }
 
-void TcpMessageWriter::BufferAppend(const uint8_t *src, int bytes) {
-    u_int8_t *data = new u_int8_t[bytes];
-    memcpy(data, src, bytes);
-    mutable_buffer buffer = mutable_buffer(data, bytes);
-    buffer_queue_.push_back(buffer);
+// Copies the data at the tail of the queue, filling up the last chunk
+// before starting a new one.
+void TcpMessageWriter::BufferAppend(const uint8_t *src, size_t bytes) {
+    pending_bytes_ += bytes;
+    while (bytes > 0) {
+        if (buffer_queue_.empty() ||
+            buffer_queue_.back().size() == buffer_queue_.back().capacity()) {
+            buffer_queue_.push_back(std::vector<uint8_t>());
+            buffer_queue_.back().reserve(kChunkSize);
+        }
+        std::vector<uint8_t> &tail = buffer_queue_.back();
+        size_t len = std::min(bytes, tail.capacity() - tail.size());
+        tail.insert(tail.end(), src, src + len);
+        src += len;
+        bytes -= len;
+    }
 }
 
-void TcpMessageWriter::DeleteBuffer(mutable_buffer buffer) {
-    const uint8_t *data = buffer_cast<const uint8_t *>(buffer);
-    delete[] data;
-    return;
+// Removes the written bytes from the head of the queue.
+void TcpMessageWriter::BufferConsume(size_t bytes) {
+    pending_bytes_ -= bytes;
+    while (bytes > 0) {
+        std::vector<uint8_t> &head = buffer_queue_.front();
+        size_t len = std::min(bytes, head.size() - offset_);
+        offset_ += len;
+        bytes -= len;
+        if (offset_ == head.size()) {
+            buffer_queue_.pop_front();
+            offset_ = 0;
+        }
+    }
 }
 
 void TcpMessageWriter::RegisterNotification(SendReadyCb cb) {
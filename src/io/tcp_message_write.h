@@ -5,7 +5,8 @@
 #ifndef __MESSAGE_WRITE_H__
 #define __MESSAGE_WRITE_H__
 
-#include <list>
+#include <deque>
+#include <vector>
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
 #include <boost/asio/buffer.hpp>
@@ -18,32 +19,64 @@ using namespace boost::system;
 
 class TcpSession;
 
+// TcpMessageWriter
+//
+// Data that can not be written right away is copied into a queue of
+// contiguous chunks, so that small messages share a chunk, and the queue
+// is flushed with gathered writes when the socket becomes writable.
+//
+// Send reports the writer as not ready once more than the high watermark
+// bytes are queued. The SendReadyCb is then invoked when the queue drains
+// to the low watermark, or on a write error.
 class TcpMessageWriter {
 public:
     typedef boost::asio::ip::tcp::socket Socket;
     static const int kDefaultBufferSize = 4 * 1024;
+    static const size_t kChunkSize = 16 * 1024;
+    // Maximum number of chunks in a single gathered write
+    static const size_t kMaxWriteChunks = 16;
+    static const size_t kDefaultHighWatermark = 64 * 1024;
+    static const size_t kDefaultLowWatermark = 16 * 1024;
+
     explicit TcpMessageWriter(Socket *, TcpSession *session);
     ~TcpMessageWriter();
 
-    // return false for send  
+    // Returns the number of bytes written to the socket or -1 on error.
+    // The rest of the message is queued.
     int Send(const uint8_t *msg, size_t len, error_code &ec);
 
+    // False if the queue is above the high watermark. The SendReadyCb is
+    // invoked once it drains.
+    bool ready() const { return !blocked_; }
+    size_t pending_bytes() const { return pending_bytes_; }
+
+    // A high watermark of 0 reports the writer as not ready as soon as
+    // any data is queued.
+    void SetWatermarks(size_t high, size_t low);
+
     typedef boost::function<void(const error_code &ec)> SendReadyCb;
     void RegisterNotification(SendReadyCb);
 
 private:
     typedef boost::intrusive_ptr<TcpSession> TcpSessionPtr;
-    typedef std::list<boost::asio::mutable_buffer> BufferQueue;
-    void BufferAppend(const uint8_t *data, int len);
-    void DeleteBuffer(boost::asio::mutable_buffer buffer); 
+    typedef std::deque<std::vector<uint8_t> > BufferQueue;
+    void BufferAppend(const uint8_t *data, size_t len);
+    void BufferConsume(size_t len);
+    int WriteBuffers(size_t *requested, error_code &ec);
     void DeferWrite();
     void HandleWriteReady(TcpSessionPtr session_ref, const error_code &ec,
                           uint64_t block_start_time);
 
     BufferQueue buffer_queue_;
+    std::vector<boost::asio::const_buffer> write_buffers_;
     SendReadyCb cb_;
     Socket *socket_;
-    int offset_;
+    // Bytes of the head chunk already written
+    size_t offset_;
+    size_t pending_bytes_;
+    size_t high_watermark_;
+    size_t low_watermark_;
+    bool blocked_;
     TcpSession *session_;
 };
 
@@ -136,7 +136,7 @@ void TcpServer::ClearSessions() {
 }
 
 TcpSession *TcpServer::CreateSession() {
-    Socket *socket = new Socket(*evm_->io_service());
+    Socket *socket = new Socket(*evm_->NextIoService());
     TcpSession *session = AllocSession(socket);
     {
         mutex::scoped_lock lock(mutex_);
@@ -196,7 +196,9 @@ void TcpServer::AsyncAccept() {
     if (acceptor_ == NULL) {
         return;
     }
-    so_accept_.reset(new Socket(*evm_->io_service()));
+    // The session runs its socket I/O on the io_service of the accept
+    // socket, the acceptor itself stays on the main one.
+    so_accept_.reset(new Socket(*evm_->NextIoService()));
     acceptor_->async_accept(*so_accept_.get(),
         boost::bind(&TcpServer::AcceptHandlerInternal, this,
             TcpServerPtr(this), boost::asio::placeholders::error));
@@ -16,6 +16,7 @@
 #endif
 
 #include "base/util.h"
+#include "io/tcp_buffer_pool.h"
 
 class EventManager;
 class TcpSession;
@@ -100,6 +101,8 @@ class TcpServer {
     void GetRxSocketStats(TcpServerSocketStats &socket_stats) const;
     void GetTxSocketStats(TcpServerSocketStats &socket_stats) const;
 
+    const TcpBufferPool &buffer_pool() const { return buffer_pool_; }
+
   protected:
     // Create a session object.
     virtual TcpSession *AllocSession(Socket *socket) = 0;
@@ -145,6 +148,7 @@ class TcpServer {
     void SetName(Endpoint local_endpoint);
 
     SocketStats stats_;
+    TcpBufferPool buffer_pool_;
     EventManager *evm_;
     // mutex protects the session maps
     mutable tbb::mutex mutex_;
@@ -6,7 +6,6 @@
 
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
-#include <boost/scoped_array.hpp>
 #include <boost/asio/detail/socket_option.hpp>
 
 #include "base/logging.h"
@@ -75,8 +74,9 @@ TcpSession::~TcpSession() {
 }
 
 mutable_buffer TcpSession::AllocateBuffer() {
-    u_int8_t *data = new u_int8_t[buffer_size_];
-    mutable_buffer buffer = mutable_buffer(data, buffer_size_);
+    size_t size = buffer_size_;
+    u_int8_t *data = server_->buffer_pool_.Allocate(&size);
+    mutable_buffer buffer = mutable_buffer(data, size);
     {
         mutex::scoped_lock lock(mutex_);
         buffer_queue_.push_back(buffer);
@@ -89,6 +89,17 @@ void TcpSession::DeleteBuffer(mutable_buffer buffer) {
     delete[] data;
 }
 
+// Grow the reads of bulk peers that fill the buffer, and shrink them back
+// when the reads get small again.
+void TcpSession::AdaptBufferSize(size_t capacity, size_t bytes_transferred) {
+    if (bytes_transferred == capacity) {
+        buffer_size_ = min(capacity * 2,
+                           size_t(TcpBufferPool::kMaxBufferSize));
+    } else if (bytes_transferred <= buffer_size_ / 4) {
+        buffer_size_ = max(buffer_size_ / 2, size_t(kDefaultBufferSize));
+    }
+}
+
 static int BufferCmp(const mutable_buffer &lhs, const const_buffer &rhs) {
     const uint8_t *lp = buffer_cast<uint8_t *>(lhs);
     const uint8_t *rp = buffer_cast<const uint8_t *>(rhs);
@@ -110,7 +121,8 @@ void TcpSession::ReleaseBufferLocked(Buffer buffer) {
     for (BufferQueue::iterator iter = buffer_queue_.begin();
          iter != buffer_queue_.end(); ++iter) {
         if (BufferCmp(*iter, buffer) == 0) {
-            DeleteBuffer(*iter);
+            server_->buffer_pool_.Release(buffer_cast<uint8_t *>(*iter),
+                                          buffer_size(*iter));
             buffer_queue_.erase(iter);
             return;
         }
@@ -276,6 +288,7 @@ bool TcpSession::Send(const u_int8_t *data, size_t size, size_t *sent) {
     if (socket_->non_blocking()) {
         boost::system::error_code error;
         int len = writer_->Send(data, size, error);
+        if (!writer_->ready()) ret = false;
         lock.release();
         if (len < 0) {
             TCP_SESSION_LOG_INFO(this, TCP_DIR_OUT,
@@ -284,7 +297,6 @@ bool TcpSession::Send(const u_int8_t *data, size_t size, size_t *sent) {
             CloseInternal(true);
             return false;
         }
-        if (len < 0 || (size_t)len != size) ret = false;
         if (sent) *sent = (len > 0) ? len : 0;
     } else {
         boost::asio::async_write(
@@ -296,6 +308,11 @@ bool TcpSession::Send(const u_int8_t *data, size_t size, size_t *sent) {
     return ret;
 }
 
+void TcpSession::SetWriteWatermarks(size_t high, size_t low) {
+    mutex::scoped_lock lock(mutex_);
+    writer_->SetWatermarks(high, low);
+}
+
 void TcpSession::AsyncReadHandler(
     TcpSessionPtr session, mutable_buffer buffer,
     const boost::system::error_code &error, size_t bytes_transferred) {
@@ -316,6 +333,8 @@ void TcpSession::AsyncReadHandler(
         return;
     }
 
+    session->AdaptBufferSize(buffer_size(buffer), bytes_transferred);
+
     // Update read statistics.
     session->stats_.read_calls++;
     session->stats_.read_bytes += bytes_transferred;
@@ -379,6 +398,15 @@ int TcpMessageReader::AllocBufferSize(int length) {
     return bufsize;
 }
 
+// Returns the reassembly buffer, grown to fit msglength if needed. It is
+// reused for every message that spans buffers.
+uint8_t *TcpMessageReader::MessageBuffer(int msglength) {
+    if (message_.size() < (size_t) msglength) {
+        message_.resize(AllocBufferSize(msglength));
+    }
+    return &message_[0];
+}
+
 uint8_t *TcpMessageReader::BufferConcat(uint8_t *data, Buffer buffer,
                                         int msglength) {
     uint8_t *dst = data;
@@ -467,8 +495,8 @@ void TcpMessageReader::OnRead(Buffer buffer) {
                 queue_.push_back(buffer);
                 return;
             }
-            boost::scoped_array<uint8_t> data(new uint8_t[kHeaderLenSize]);
-            Buffer header = PullUp(data.get(), buffer, kHeaderLenSize);
+            header_.resize(kHeaderLenSize);
+            Buffer header = PullUp(&header_[0], buffer, kHeaderLenSize);
             assert(TcpSession::BufferSize(header) == (size_t) kHeaderLenSize);
 
             msglength = MsgLength(header, 0);
@@ -487,12 +515,11 @@ void TcpMessageReader::OnRead(Buffer buffer) {
         }
 
         // concat the buffers into a contiguous message.
-        boost::scoped_array<uint8_t>
-            data(new uint8_t[AllocBufferSize(msglength)]);
-        BufferConcat(data.get(), buffer, msglength);
+        uint8_t *data = BufferConcat(MessageBuffer(msglength), buffer,
+                                     msglength);
         assert(remain_ == -1);
         // Receive the message
-        callback_(data.get(), msglength);
+        callback_(data, msglength);
     }
 
     int avail = size - offset_;
@@ -7,6 +7,7 @@
 
 #include <list>
 #include <deque>
+#include <vector>
 
 #include <boost/asio/buffer.hpp>
 #include <boost/asio/io_service.hpp>
@@ -56,9 +57,15 @@ class TcpSession {
     // TcpSession constructor takes ownership of socket.
     TcpSession(TcpServer *server, Socket *socket,
                bool async_read_ready = true);
-    // Performs a non-blocking send operation.
+    // Performs a non-blocking send operation. Data that can not be written
+    // right away is queued. Returns false once the queue is above the high
+    // write watermark; WriteReady is then called when it drains to the low
+    // watermark.
     virtual bool Send(const u_int8_t *data, size_t size, size_t *sent);
 
+    // Queued bytes thresholds for Send, see TcpMessageWriter.
+    void SetWriteWatermarks(size_t high, size_t low);
+
     // Called by TcpServer to trigger async read.
     virtual bool Connected(Endpoint remote);
     
@@ -154,7 +161,7 @@ class TcpSession {
     friend class TcpMessageWriter;
     friend void intrusive_ptr_add_ref(TcpSession *session);
     friend void intrusive_ptr_release(TcpSession *session);
-    typedef std::list<boost::asio::mutable_buffer> BufferQueue;
+    typedef std::deque<boost::asio::mutable_buffer> BufferQueue;
 
     class Reader;
 
@@ -178,6 +185,7 @@ class TcpSession {
 
     boost::asio::mutable_buffer AllocateBuffer();
     void DeleteBuffer(boost::asio::mutable_buffer buffer);
+    void AdaptBufferSize(size_t capacity, size_t bytes_transferred);
     void WriteReadyInternal(const boost::system::error_code &);
 
     static int reader_task_id_;
@@ -185,7 +193,8 @@ class TcpSession {
     TcpServer *server_;
     boost::scoped_ptr<Socket> socket_;
     bool read_on_connect_;
-    int buffer_size_;
+    // Size of the next read, adapted to the sizes of the previous reads
+    size_t buffer_size_;
 
     // Protects session state and buffer queue.
     mutable tbb::mutex mutex_;
@@ -247,6 +256,7 @@ private:
 
     // Copy the queue into one contiguous buffer.
     uint8_t *BufferConcat(uint8_t *data, Buffer buffer, int msglength);
+    uint8_t *MessageBuffer(int msglength);
 
     int QueueByteLength() const;
 
@@ -259,6 +269,9 @@ private:
     BufferQueue queue_;
     int offset_;
     int remain_;
+    // Scratch space to reassemble headers and messages spanning buffers
+    std::vector<uint8_t> header_;
+    std::vector<uint8_t> message_;
 
     DISALLOW_COPY_AND_ASSIGN(TcpMessageReader);
 };
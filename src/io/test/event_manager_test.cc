@@ -2,6 +2,8 @@
  * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <boost/bind.hpp>
+
 #include "base/test/task_test_util.h"
 #include "io/test/event_manager_test.h"
 #include "testing/gunit.h"
@@ -39,6 +41,40 @@ TEST_F(EventManagerDeathTest, RunOnce) {
         ::testing::KilledBySignal(SIGABRT), ".*RunOnce.*");
 }
 
+static void PostHandler(tbb::atomic<int> *count, pthread_t *thread_id) {
+    *thread_id = pthread_self();
+    (*count)++;
+}
+
+// Handlers of the io_services handed out to sessions run on the I/O threads.
+TEST(EventManagerIoThreadTest, NextIoService) {
+    EventManager evm(2);
+    EXPECT_EQ(2, evm.io_thread_count());
+    boost::asio::io_service *io1 = evm.NextIoService();
+    boost::asio::io_service *io2 = evm.NextIoService();
+    EXPECT_NE(io1, io2);
+    EXPECT_NE(evm.io_service(), io1);
+    EXPECT_NE(evm.io_service(), io2);
+    EXPECT_EQ(io1, evm.NextIoService());
+
+    tbb::atomic<int> count;
+    count = 0;
+    pthread_t thread1 = pthread_self(), thread2 = pthread_self();
+    io1->post(boost::bind(&PostHandler, &count, &thread1));
+    io2->post(boost::bind(&PostHandler, &count, &thread2));
+    TASK_UTIL_EXPECT_EQ(2, count);
+    EXPECT_FALSE(pthread_equal(thread1, pthread_self()));
+    EXPECT_FALSE(pthread_equal(thread2, pthread_self()));
+    EXPECT_FALSE(pthread_equal(thread1, thread2));
+    evm.Shutdown();
+}
+
+TEST(EventManagerIoThreadTest, NoIoThreads) {
+    EventManager evm(0);
+    EXPECT_EQ(0, evm.io_thread_count());
+    EXPECT_EQ(evm.io_service(), evm.NextIoService());
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     ::testing::FLAGS_gtest_death_test_style = "threadsafe";
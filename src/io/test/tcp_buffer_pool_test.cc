@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "io/tcp_buffer_pool.h"
+
+#include "base/logging.h"
+#include "testing/gunit.h"
+
+class TcpBufferPoolTest : public ::testing::Test {
+protected:
+    TcpBufferPool pool_;
+};
+
+TEST_F(TcpBufferPoolTest, SizeClasses) {
+    size_t size = 1;
+    uint8_t *data = pool_.Allocate(&size);
+    EXPECT_EQ(TcpBufferPool::kMinBufferSize, size);
+    pool_.Release(data, size);
+
+    size = TcpBufferPool::kMinBufferSize + 1;
+    data = pool_.Allocate(&size);
+    EXPECT_EQ(2 * TcpBufferPool::kMinBufferSize, size);
+    pool_.Release(data, size);
+
+    size = 16 * TcpBufferPool::kMaxBufferSize;
+    data = pool_.Allocate(&size);
+    EXPECT_EQ(TcpBufferPool::kMaxBufferSize, size);
+    pool_.Release(data, size);
+
+    EXPECT_EQ(3U, pool_.alloc_count());
+    EXPECT_EQ(0U, pool_.reuse_count());
+    EXPECT_EQ(3U, pool_.free_count());
+}
+
+// Released buffers are handed out again by the same size class only.
+TEST_F(TcpBufferPoolTest, Reuse) {
+    size_t size = TcpBufferPool::kMinBufferSize;
+    uint8_t *data = pool_.Allocate(&size);
+    pool_.Release(data, size);
+
+    size_t other_size = 2 * TcpBufferPool::kMinBufferSize;
+    uint8_t *other = pool_.Allocate(&other_size);
+    EXPECT_NE(data, other);
+    pool_.Release(other, other_size);
+
+    size = TcpBufferPool::kMinBufferSize;
+    EXPECT_EQ(data, pool_.Allocate(&size));
+    EXPECT_EQ(2U, pool_.alloc_count());
+    EXPECT_EQ(1U, pool_.reuse_count());
+    pool_.Release(data, size);
+}
+
+// The free list of a size class is bounded.
+TEST_F(TcpBufferPoolTest, MaxFreeBytes) {
+    size_t count =
+        TcpBufferPool::kMaxFreeBytes / TcpBufferPool::kMaxBufferSize + 4;
+    std::vector<uint8_t *> buffers;
+    for (size_t i = 0; i < count; i++) {
+        size_t size = TcpBufferPool::kMaxBufferSize;
+        buffers.push_back(pool_.Allocate(&size));
+    }
+    for (size_t i = 0; i < count; i++) {
+        pool_.Release(buffers[i], TcpBufferPool::kMaxBufferSize);
+    }
+    EXPECT_EQ(TcpBufferPool::kMaxFreeBytes / TcpBufferPool::kMaxBufferSize,
+              pool_.free_count());
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -250,6 +250,53 @@ TEST_F(EchoServerTest, Basic) {
     server_->GetSession()->ResetTotal();
 }
 
+// Send keeps accepting data until the queue is above the high watermark and
+// WriteReady is called once the receiver drains it.
+TEST_F(EchoServerTest, WriteWatermarks) {
+    server_->Initialize(0);
+    task_util::WaitForIdle();
+    thread_->Start();
+    int port = server_->GetPort();
+    ASSERT_LT(0, port);
+
+    client_->CreateSession();
+    client_->EchoServer::ConnectTest(port);
+    TASK_UTIL_ASSERT_TRUE((server_->GetSession() != NULL));
+    TASK_UTIL_ASSERT_TRUE(client_->GetSession()->IsEstablished());
+    TASK_UTIL_ASSERT_TRUE(server_->GetSession()->IsEstablished());
+
+    const size_t kHighWatermark = 256 * 1024;
+    client_->GetSession()->SetWriteWatermarks(kHighWatermark, 0);
+
+    // Stop the reader tasks so that the socket buffers fill up.
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    scheduler->Stop();
+
+    char msg[512];
+    memset(msg, 0xcd, sizeof(msg));
+    size_t total = 0;
+    size_t queued = 0;
+    bool res = true;
+    while (res) {
+        size_t sent;
+        res = client_->Send((const u_int8_t *) msg, sizeof(msg), &sent);
+        total += sizeof(msg);
+        queued += sizeof(msg) - sent;
+    }
+    EXPECT_LT(kHighWatermark, queued);
+    EXPECT_FALSE(client_->GetSession()->called);
+
+    scheduler->Start();
+    TASK_UTIL_ASSERT_TRUE(client_->GetSession()->called);
+    TASK_UTIL_ASSERT_EQ(total, server_->GetSession()->GetTotal());
+
+    // Queued messages share chunks, so they take far fewer socket writes
+    // than messages.
+    const TcpServer::SocketStats &stats =
+        client_->GetSession()->GetSocketStats();
+    EXPECT_GT(total / sizeof(msg), stats.write_calls);
+}
+
 TEST_F(EchoServerTest, ReadInterrupt) {
     server_->Initialize(0);
     task_util::WaitForIdle();
@@ -26,6 +26,35 @@ void Route::insert(const Path *ipath) {
     path_.push_back(*path);
 }
 
+// Insert a path into a sorted path list
+//
+// A new best path goes to the front and a path no better than the last one
+// goes to the back, which covers most changes. Otherwise the path goes before
+// the first path it is better than, which is where a stable sort of the list
+// with the path appended would leave it.
+bool Route::insert(const Path *ipath, Compare compare) {
+    Path *path = const_cast<Path *> (ipath);
+
+    path->set_time_stamp_usecs(UTCTimestampUsec());
+    if (path_.empty() || compare(*path, path_.front())) {
+        path_.push_front(*path);
+        set_last_change_at_to_now();
+        return true;
+    }
+    if (!compare(*path, path_.back())) {
+        path_.push_back(*path);
+        return true;
+    }
+
+    PathList::iterator it = path_.begin();
+    for (++it; it != path_.end(); ++it) {
+        if (compare(*path, *it))
+            break;
+    }
+    path_.insert(it, *path);
+    return false;
+}
+
 // Remove a path
 void Route::remove(const Path *ipath) {
     Path *path = const_cast<Path *> (ipath);
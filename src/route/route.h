@@ -37,6 +37,11 @@ public:
     // Insert a path
     void insert(const Path *path);
 
+    // Insert a path into a sorted path list at the position Sort would move
+    // it to, without sorting the list again. Returns true if comparing with
+    // the first and last paths was enough to place it.
+    bool insert(const Path *path, Compare compare);
+
     // Remove a path
     void remove(const Path *path);
 
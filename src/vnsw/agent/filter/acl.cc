@@ -107,6 +107,7 @@ DBEntry *AclTable::Add(const DBRequest *req) {
          ++it) {
         acl->AddAclEntry(*it, acl->acl_entries_);
     }
+    acl->BuildClassifier();
     return acl;
 }
 
@@ -116,6 +117,7 @@ bool AclTable::OnChange(DBEntry *entry, const DBRequest *req) {
 
     if (data->ace_id_to_del_) {
         acl->DeleteAclEntry(data->ace_id_to_del_);
+        acl->BuildClassifier();
         return true;
     }
 
@@ -138,6 +140,7 @@ bool AclTable::OnChange(DBEntry *entry, const DBRequest *req) {
         acl->DeleteAllAclEntries();
         acl->SetAclEntries(entries);
     }
+    acl->BuildClassifier();
     return true;
 }
 
@@ -145,6 +148,7 @@ void AclTable::Delete(DBEntry *entry, const DBRequest *req) {
     AclDBEntry *acl = static_cast<AclDBEntry *>(entry);
     ACL_TRACE(Info, "Delete " + UuidToString(acl->GetUuid()));
     acl->DeleteAllAclEntries();
+    acl->BuildClassifier();
 }
 
 void AclTable::ActionInit() {
@@ -618,17 +622,37 @@ void AclDBEntry::DeleteAllAclEntries()
     return;
 }
 
+void AclDBEntry::BuildClassifier()
+{
+    std::vector<const AclEntry *> entries;
+    AclEntries::const_iterator iter;
+    for (iter = acl_entries_.begin(); iter != acl_entries_.end(); ++iter) {
+        entries.push_back(iter.operator->());
+    }
+    classifier_.Build(entries);
+}
+
 bool AclDBEntry::PacketMatch(const PacketHeader &packet_header, 
 			     MatchAclParams &m_acl) const
 {
-    AclEntries::const_iterator iter;
     bool ret_val = false;
     m_acl.terminal_rule = false;
 	m_acl.action_info.action = 0;
-    for (iter = acl_entries_.begin();
-         iter != acl_entries_.end();
-         ++iter) {
-        const AclEntry::ActionList &al = iter->PacketMatch(packet_header);
+
+    uint64_t stack_match[AclClassifier::kStackWords];
+    AclClassifier::Bits heap_match;
+    uint64_t *match = stack_match;
+    if (classifier_.word_count() > AclClassifier::kStackWords) {
+        heap_match.resize(classifier_.word_count());
+        match = &heap_match[0];
+    }
+    classifier_.Match(packet_header, match);
+
+    // Visit the matching entries in order, up to the first terminal one
+    for (size_t i = classifier_.FindNext(match, 0); i < classifier_.size();
+         i = classifier_.FindNext(match, i + 1)) {
+        const AclEntry *entry = classifier_.entry(i);
+        const AclEntry::ActionList &al = entry->Actions();
 	AclEntry::ActionList::const_iterator al_it;
 	for (al_it = al.begin(); al_it != al.end(); ++al_it) {
 	     TrafficAction *ta = static_cast<TrafficAction *>(*al_it.operator->());
@@ -644,13 +668,11 @@ bool AclDBEntry::PacketMatch(const PacketHeader &packet_header,
                  m_acl.action_info.mirror_l.push_back(as);
 	     }
 	}
-        if (!(al.empty())) {
-            ret_val = true;
-            m_acl.ace_id_list.push_back((int32_t)(iter->id()));
-            if (iter->IsTerminal()) {
-	        m_acl.terminal_rule = true;
-                return ret_val;
-            }
+        ret_val = true;
+        m_acl.ace_id_list.push_back((int32_t)(entry->id()));
+        if (entry->IsTerminal()) {
+	    m_acl.terminal_rule = true;
+            return ret_val;
         }
     }
     return ret_val;
@@ -7,6 +7,7 @@
 
 #include "vnsw/agent/filter/acl_entry.h"
 #include "vnsw/agent/filter/acl_entry_spec.h"
+#include "vnsw/agent/filter/acl_classifier.h"
 
 #include <boost/intrusive/list.hpp>
 #include <boost/uuid/uuid.hpp>
@@ -121,6 +122,8 @@ public:
     void DeleteAllAclEntries();
     uint32_t Size() const {return acl_entries_.size();};
     void SetAclEntries(AclEntries &entries);
+    // Recompile the classifier after the entries are changed
+    void BuildClassifier();
     void SetDynamicAcl(bool dyn) {dynamic_acl_ = dyn;};
     bool GetDynamicAcl () const {return dynamic_acl_;};
 
@@ -133,6 +136,7 @@ private:
     bool dynamic_acl_;
     std::string name_;
     AclEntries acl_entries_;
+    AclClassifier classifier_;
     DISALLOW_COPY_AND_ASSIGN(AclDBEntry);
 };
 
@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <algorithm>
+#include "vnsw/agent/filter/acl_classifier.h"
+#include "vnsw/agent/filter/packet_header.h"
+
+static void OrBits(uint64_t *dst, const uint64_t *src, size_t words) {
+    for (size_t i = 0; i < words; i++) {
+        dst[i] |= src[i];
+    }
+}
+
+static void AndBits(uint64_t *dst, const uint64_t *src, size_t words) {
+    for (size_t i = 0; i < words; i++) {
+        dst[i] &= src[i];
+    }
+}
+
+void AclClassifier::RangeField::Build(size_t words,
+                                      const std::vector<const RangeSList *> &m) {
+    words_ = words;
+    bounds_.clear();
+    bounds_.push_back(0);
+    for (size_t i = 0; i < m.size(); i++) {
+        if (m[i] == NULL)
+            continue;
+        for (RangeSList::const_iterator it = m[i]->begin(); it != m[i]->end();
+             ++it) {
+            bounds_.push_back(it->min);
+            bounds_.push_back(static_cast<uint32_t>(it->max) + 1);
+        }
+    }
+    std::sort(bounds_.begin(), bounds_.end());
+    bounds_.erase(std::unique(bounds_.begin(), bounds_.end()), bounds_.end());
+
+    // Every range starts and ends at a bound, so the first value of an
+    // interval stands for all of it.
+    bits_.assign(bounds_.size() * words_, 0);
+    for (size_t k = 0; k < bounds_.size(); k++) {
+        uint32_t value = bounds_[k];
+        uint64_t *bits = &bits_[k * words_];
+        for (size_t i = 0; i < m.size(); i++) {
+            bool match = (m[i] == NULL);
+            if (!match) {
+                for (RangeSList::const_iterator it = m[i]->begin();
+                     it != m[i]->end(); ++it) {
+                    if (value >= it->min && value <= it->max) {
+                        match = true;
+                        break;
+                    }
+                }
+            }
+            if (match) {
+                bits[i / 64] |= (1ULL << (i % 64));
+            }
+        }
+    }
+}
+
+void AclClassifier::RangeField::Clear() {
+    bounds_.clear();
+    bits_.clear();
+}
+
+const uint64_t *AclClassifier::RangeField::Lookup(uint32_t value) const {
+    size_t k = std::upper_bound(bounds_.begin(), bounds_.end(), value) -
+        bounds_.begin() - 1;
+    return &bits_[k * words_];
+}
+
+void AclClassifier::AddressField::Build(
+        size_t words, const std::vector<const AddressMatch *> &m) {
+    Clear();
+    words_ = words;
+    any_.assign(words_, 0);
+    sg_any_.assign(words_, 0);
+    for (size_t i = 0; i < m.size(); i++) {
+        const AddressMatch *addr = m[i];
+        Bits *bits = NULL;
+        if (addr == NULL || addr->policy_id_str() == "any") {
+            bits = &any_;
+        } else if (addr->addr_type() == AddressMatch::IP_ADDR) {
+            // Non IPv4 addresses never match
+            if (!addr->ip_addr().is_v4())
+                continue;
+            uint32_t mask = addr->ip_mask().to_v4().to_ulong();
+            uint32_t ip = addr->ip_addr().to_v4().to_ulong();
+            bits = &masks_[mask][ip];
+        } else if (addr->addr_type() == AddressMatch::NETWORK_ID) {
+            bits = &policies_[addr->policy_id_str()];
+        } else if (addr->addr_type() == AddressMatch::SG) {
+            has_sg_ = true;
+            if (addr->sg_id() == AddressMatch::kAny) {
+                bits = &sg_any_;
+            } else {
+                bits = &sgs_[addr->sg_id()];
+            }
+        } else {
+            continue;
+        }
+        if (bits->empty()) {
+            bits->resize(words_);
+        }
+        SetBit(bits, i);
+    }
+}
+
+void AclClassifier::AddressField::Clear() {
+    any_.clear();
+    masks_.clear();
+    policies_.clear();
+    sgs_.clear();
+    sg_any_.clear();
+    has_sg_ = false;
+}
+
+void AclClassifier::AddressField::Lookup(uint32_t ip,
+                                         const std::string *policy_id,
+                                         const SecurityGroupList *sg_l,
+                                         uint64_t *match) const {
+    OrBits(match, &any_[0], words_);
+
+    for (MaskMap::const_iterator it = masks_.begin(); it != masks_.end();
+         ++it) {
+        IpMap::const_iterator loc = it->second.find(ip & it->first);
+        if (loc != it->second.end()) {
+            OrBits(match, &loc->second[0], words_);
+        }
+    }
+
+    if (policy_id && !policies_.empty()) {
+        PolicyMap::const_iterator loc = policies_.find(*policy_id);
+        if (loc != policies_.end()) {
+            OrBits(match, &loc->second[0], words_);
+        }
+    }
+
+    if (has_sg_ && sg_l) {
+        OrBits(match, &sg_any_[0], words_);
+        for (SecurityGroupList::const_iterator it = sg_l->begin();
+             it != sg_l->end(); ++it) {
+            SgMap::const_iterator loc = sgs_.find(*it);
+            if (loc != sgs_.end()) {
+                OrBits(match, &loc->second[0], words_);
+            }
+        }
+    }
+}
+
+AclClassifier::AclClassifier() : words_(0) {
+    Clear();
+}
+
+AclClassifier::~AclClassifier() {
+}
+
+void AclClassifier::Build(const std::vector<const AclEntry *> &entries) {
+    Clear();
+    entries_ = entries;
+    words_ = (entries_.size() + 63) / 64;
+    valid_.assign(words_, 0);
+
+    std::vector<const RangeSList *> protocol(entries_.size());
+    std::vector<const RangeSList *> src_port(entries_.size());
+    std::vector<const RangeSList *> dst_port(entries_.size());
+    std::vector<const AddressMatch *> src_addr(entries_.size());
+    std::vector<const AddressMatch *> dst_addr(entries_.size());
+    for (size_t i = 0; i < entries_.size(); i++) {
+        const AclEntry *entry = entries_[i];
+        if (!entry->Actions().empty()) {
+            SetBit(&valid_, i);
+        }
+        const std::vector<AclEntryMatch *> &matches = entry->matches();
+        for (size_t j = 0; j < matches.size(); j++) {
+            const AclEntryMatch *m = matches[j];
+            if (const ProtocolMatch *proto =
+                    dynamic_cast<const ProtocolMatch *>(m)) {
+                protocol[i] = &proto->ranges();
+            } else if (const SrcPortMatch *port =
+                    dynamic_cast<const SrcPortMatch *>(m)) {
+                src_port[i] = &port->ranges();
+            } else if (const DstPortMatch *port =
+                    dynamic_cast<const DstPortMatch *>(m)) {
+                dst_port[i] = &port->ranges();
+            } else if (const AddressMatch *addr =
+                    dynamic_cast<const AddressMatch *>(m)) {
+                if (addr->is_source()) {
+                    src_addr[i] = addr;
+                } else {
+                    dst_addr[i] = addr;
+                }
+            }
+        }
+    }
+
+    protocol_.Build(words_, protocol);
+    src_port_.Build(words_, src_port);
+    dst_port_.Build(words_, dst_port);
+    src_addr_.Build(words_, src_addr);
+    dst_addr_.Build(words_, dst_addr);
+}
+
+void AclClassifier::Clear() {
+    entries_.clear();
+    words_ = 0;
+    valid_.clear();
+    protocol_.Clear();
+    src_port_.Clear();
+    dst_port_.Clear();
+    src_addr_.Clear();
+    dst_addr_.Clear();
+}
+
+void AclClassifier::Match(const PacketHeader &hdr, uint64_t *match) const {
+    if (words_ == 0)
+        return;
+
+    std::copy(valid_.begin(), valid_.end(), match);
+    AndBits(match, protocol_.Lookup(hdr.protocol), words_);
+    AndBits(match, src_port_.Lookup(hdr.src_port), words_);
+    AndBits(match, dst_port_.Lookup(hdr.dst_port), words_);
+    if (FindNext(match, 0) == size())
+        return;
+
+    uint64_t stack_addr[kStackWords];
+    Bits heap_addr;
+    uint64_t *addr = stack_addr;
+    if (words_ > kStackWords) {
+        heap_addr.resize(words_);
+        addr = &heap_addr[0];
+    }
+
+    std::fill(addr, addr + words_, 0);
+    src_addr_.Lookup(hdr.src_ip, hdr.src_policy_id,
+                     src_addr_.has_sg() ? hdr.src_sg_id_l : NULL, addr);
+    AndBits(match, addr, words_);
+
+    std::fill(addr, addr + words_, 0);
+    dst_addr_.Lookup(hdr.dst_ip, hdr.dst_policy_id,
+                     dst_addr_.has_sg() ? hdr.dst_sg_id_l : NULL, addr);
+    AndBits(match, addr, words_);
+}
+
+size_t AclClassifier::FindNext(const uint64_t *match, size_t start) const {
+    size_t word = start / 64;
+    if (word >= words_)
+        return size();
+    uint64_t bits = match[word] & (~0ULL << (start % 64));
+    while (bits == 0) {
+        if (++word >= words_)
+            return size();
+        bits = match[word];
+    }
+    size_t index = word * 64 + __builtin_ctzll(bits);
+    return std::min(index, size());
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef __AGENT_ACL_CLASSIFIER_H__
+#define __AGENT_ACL_CLASSIFIER_H__
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "base/util.h"
+#include "vnsw/agent/filter/acl_entry.h"
+
+struct PacketHeader;
+
+// Compiled form of the entries of an ACL, rebuilt whenever the entries change.
+//
+// Every match field is split into classes that all entries treat alike:
+// intervals for the protocol and ports, (mask, address) pairs for IP
+// addresses, VN names and SG ids. Each class maps to a bit-vector of the
+// entries that accept it, with bit i standing for the i-th entry in ACL order.
+// A lookup finds the class of every field, ANDs the bit-vectors and leaves
+// the matching entries set in ACL order, so its cost grows with the number of
+// distinct masks, VN names and SG ids rather than with the number of entries.
+//
+// Entries without actions never match, as in AclEntry::PacketMatch.
+class AclClassifier {
+public:
+    typedef std::vector<uint64_t> Bits;
+    // Lookups of ACLs with up to this many words use stack scratch space
+    static const size_t kStackWords = 16;
+
+    AclClassifier();
+    ~AclClassifier();
+
+    void Build(const std::vector<const AclEntry *> &entries);
+    void Clear();
+
+    // Sets the bits of the entries matching the packet in match, which must
+    // hold word_count() words.
+    void Match(const PacketHeader &hdr, uint64_t *match) const;
+
+    size_t size() const { return entries_.size(); }
+    size_t word_count() const { return words_; }
+    const AclEntry *entry(size_t index) const { return entries_[index]; }
+
+    // Index of the first bit set at or after start, or size() if none.
+    size_t FindNext(const uint64_t *match, size_t start) const;
+
+private:
+    // Protocol or port field: the value space is split at the ends of the
+    // entry ranges and every interval keeps the entries that cover it.
+    class RangeField {
+    public:
+        // A NULL range list accepts every value.
+        void Build(size_t words, const std::vector<const RangeSList *> &m);
+        void Clear();
+        const uint64_t *Lookup(uint32_t value) const;
+    private:
+        size_t words_;
+        std::vector<uint32_t> bounds_;
+        Bits bits_;
+    };
+
+    // Source or destination address field.
+    class AddressField {
+    public:
+        // A NULL match accepts every address.
+        void Build(size_t words, const std::vector<const AddressMatch *> &m);
+        void Clear();
+        // ORs the entries accepting the address into match.
+        void Lookup(uint32_t ip, const std::string *policy_id,
+                    const SecurityGroupList *sg_l, uint64_t *match) const;
+        bool has_sg() const { return has_sg_; }
+    private:
+        typedef std::map<uint32_t, Bits> IpMap;
+        typedef std::map<uint32_t, IpMap> MaskMap;
+        typedef std::map<std::string, Bits> PolicyMap;
+        typedef std::map<int, Bits> SgMap;
+
+        size_t words_;
+        // Entries without an address match or matching "any"
+        Bits any_;
+        MaskMap masks_;
+        PolicyMap policies_;
+        SgMap sgs_;
+        // Entries matching any SG, provided the packet has a SG list
+        Bits sg_any_;
+        bool has_sg_;
+    };
+
+    static void SetBit(Bits *bits, size_t index) {
+        (*bits)[index / 64] |= (1ULL << (index % 64));
+    }
+
+    size_t words_;
+    std::vector<const AclEntry *> entries_;
+    // Entries that have actions
+    Bits valid_;
+    RangeField protocol_;
+    RangeField src_port_;
+    RangeField dst_port_;
+    AddressField src_addr_;
+    AddressField dst_addr_;
+
+    DISALLOW_COPY_AND_ASSIGN(AclClassifier);
+};
+
+#endif
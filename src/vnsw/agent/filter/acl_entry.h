@@ -56,6 +56,7 @@ public:
     void SetPortRange(const uint16_t min_port, const uint16_t max_port);
     void SetAclEntryMatchSandeshData(AclEntrySandeshData &data) = 0;
     virtual bool Match(const PacketHeader *packet_header) const = 0;
+    const RangeSList &ranges() const { return port_ranges_; }
 protected:
     RangeSList port_ranges_;
 };
@@ -78,6 +79,7 @@ public:
     void SetProtocolRange(const uint16_t min, const uint16_t max);
     bool Match(const PacketHeader *packet_header) const;
     void SetAclEntryMatchSandeshData(AclEntrySandeshData &data);
+    const RangeSList &ranges() const { return protocol_ranges_; }
 private:
     RangeSList protocol_ranges_;
 };
@@ -109,6 +111,13 @@ public:
     // Match packet header for address
     bool Match(const PacketHeader *packet_header) const;
     void SetAclEntryMatchSandeshData(AclEntrySandeshData &data);
+
+    AddressType addr_type() const { return addr_type_; }
+    bool is_source() const { return src_; }
+    const IpAddress &ip_addr() const { return ip_addr_; }
+    const IpAddress &ip_mask() const { return ip_mask_; }
+    const std::string &policy_id_str() const { return policy_id_s_; }
+    int sg_id() const { return sg_id_; }
 private:
     AddressType addr_type_;
     bool src_;
@@ -158,6 +167,7 @@ public:
     bool IsTerminal() const;
 
     uint32_t id() const { return id_; }
+    const std::vector<AclEntryMatch *> &matches() const { return matches_; }
 
     boost::intrusive::list_member_hook<> acl_list_node;
 
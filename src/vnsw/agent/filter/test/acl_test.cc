@@ -338,6 +338,75 @@ TEST_F(AclTest, Config) {
     delete packet1;
 }
 
+// The classifier must match exactly the entries that match one by one.
+TEST_F(AclTest, Classifier) {
+    static const char *vn_names[] = { "vn1", "vn2", "any" };
+    srand(0x1234);
+    std::vector<AclEntry *> entries;
+    for (int i = 0; i < 200; i++) {
+        AclEntrySpec ae_spec;
+        ae_spec.id = i;
+        ae_spec.terminal = false;
+        if (rand() % 4) {
+            ActionSpec action;
+            action.ta_type = TrafficAction::SIMPLE_ACTION;
+            action.simple_action = TrafficAction::PASS;
+            ae_spec.action_l.push_back(action);
+        }
+        if (rand() % 2) {
+            RangeSpec range;
+            range.min = rand() % 20;
+            range.max = range.min + rand() % 3;
+            ae_spec.protocol.push_back(range);
+        }
+        if (rand() % 2) {
+            RangeSpec range;
+            range.min = rand() % 100;
+            range.max = range.min + rand() % 20;
+            ae_spec.dst_port.push_back(range);
+        }
+        if (rand() % 2) {
+            int plen = rand() % 33;
+            uint32_t mask = plen ? (~0U << (32 - plen)) : 0;
+            ae_spec.src_addr_type = AddressMatch::IP_ADDR;
+            ae_spec.src_ip_addr = Ip4Address((0x0a000000 | rand() % 256) & mask);
+            ae_spec.src_ip_mask = Ip4Address(mask);
+        }
+        if (rand() % 2) {
+            ae_spec.dst_addr_type = AddressMatch::NETWORK_ID;
+            ae_spec.dst_policy_id_str = vn_names[rand() % 3];
+        }
+        AclEntry *entry = new AclEntry();
+        entry->PopulateAclEntry(ae_spec);
+        entries.push_back(entry);
+    }
+    AclClassifier classifier;
+    classifier.Build(std::vector<const AclEntry *>(entries.begin(),
+                                                   entries.end()));
+
+    std::vector<uint64_t> match(classifier.word_count());
+    for (int i = 0; i < 5000; i++) {
+        PacketHeader packet;
+        std::string dst_vn(vn_names[rand() % 3]);
+        packet.src_ip = 0x0a000000 | rand() % 256;
+        packet.dst_policy_id = &dst_vn;
+        packet.protocol = rand() % 24;
+        packet.dst_port = rand() % 128;
+        classifier.Match(packet, &match[0]);
+
+        size_t index = classifier.FindNext(&match[0], 0);
+        for (size_t j = 0; j < entries.size(); j++) {
+            bool expected = !entries[j]->PacketMatch(packet).empty();
+            ASSERT_EQ(expected, index == j);
+            if (index == j) {
+                index = classifier.FindNext(&match[0], j + 1);
+            }
+        }
+        ASSERT_EQ(classifier.size(), index);
+    }
+    STLDeleteValues(&entries);
+}
+
 
 } //namespace
 
@@ -402,6 +402,14 @@ void AgentParam::InitFromArguments
         }
     }
 
+    if (var_map.count("flow-thread-count")) {
+        flow_thread_count_ = var_map["flow-thread-count"].as<int>();
+        if (flow_thread_count_ <= 0) {
+            LOG(ERROR, "Error parsing argument for flow-thread-count");
+            exit(EINVAL);
+        }
+    }
+
     return;
 }
 
@@ -453,6 +461,7 @@ void AgentParam::LogConfig() const {
     LOG(DEBUG, "Controller Instances        : " << xmpp_instance_count_);
     LOG(DEBUG, "Tunnel-Type                 : " << tunnel_type_);
     LOG(DEBUG, "Metadata-Proxy Shared Secret: " << metadata_shared_secret_);
+    LOG(DEBUG, "Flow setup threads          : " << flow_thread_count_);
     if (mode_ != MODE_XEN) {
     LOG(DEBUG, "Hypervisor mode             : kvm");
         return;
@@ -472,7 +481,8 @@ AgentParam::AgentParam() :
         log_category_(), collector_(), collector_port_(), http_server_port_(),
         host_name_(),
         agent_stats_interval_(AgentStatsCollector::AgentStatsInterval), 
-        flow_stats_interval_(FlowStatsCollector::FlowStatsInterval) {
+        flow_stats_interval_(FlowStatsCollector::FlowStatsInterval),
+        flow_thread_count_(1) {
     vgw_config_ = std::auto_ptr<VirtualGatewayConfig>
         (new VirtualGatewayConfig());
 }
@@ -79,6 +79,8 @@ public:
     int flow_stats_interval() const { return flow_stats_interval_; }
     void set_agent_stats_interval(int val) { agent_stats_interval_ = val; }
     void set_flow_stats_interval(int val) { flow_stats_interval_ = val; }
+    int flow_thread_count() const { return flow_thread_count_; }
+    void set_flow_thread_count(int val) { flow_thread_count_ = val; }
     VirtualGatewayConfig *vgw_config() const { return vgw_config_.get(); }
 
     Mode mode() const { return mode_; }
@@ -124,6 +126,7 @@ private:
     std::string host_name_;
     int agent_stats_interval_;
     int flow_stats_interval_;
+    int flow_thread_count_;
 
     std::auto_ptr<VirtualGatewayConfig> vgw_config_;
 
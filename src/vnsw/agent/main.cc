@@ -81,6 +81,8 @@ int main(int argc, char *argv[]) {
          "IP Address for the link local port")
         ("xen-ll-prefix-len", opt::value<int>(),
          "Prefix for link local IP Address")
+        ("flow-thread-count", opt::value<int>(),
+         "Number of threads for flow setup")
         ("version", "Display version information")
         ;
     opt::variables_map var_map;
@@ -10,6 +10,7 @@
 #include <net/ethernet.h>
 #include <net/address.h>
 #include <netinet/ether.h>
+#include <base/ip4_lpm_trie.h>
 #include <base/lifetime.h>
 #include <base/patricia.h>
 #include <base/task_annotations.h>
@@ -671,12 +672,8 @@ public:
     virtual string GetTableName() const {return "Inet4UnicastAgentRouteTable";};
     virtual AgentRouteTableAPIS::TableType GetTableType() const {
         return AgentRouteTableAPIS::INET4_UNICAST;};
-    virtual void ProcessAdd(RouteEntry *rt) { 
-        tree_.Insert(static_cast<Inet4UnicastRouteEntry *>(rt));
-    };
-    virtual void ProcessDelete(RouteEntry *rt) { 
-        tree_.Remove(static_cast<Inet4UnicastRouteEntry *>(rt));
-    };
+    virtual void ProcessAdd(RouteEntry *rt);
+    virtual void ProcessDelete(RouteEntry *rt);
     Inet4UnicastRouteEntry *FindRoute(const Ip4Address &ip) { 
         return FindLPM(ip); };
 
@@ -800,6 +797,8 @@ public:
 
 private:
     Inet4RouteTree tree_;
+    // Read-optimized copy of tree_ used by FindLPM
+    Ip4LPMTrie<Inet4UnicastRouteEntry> lpm_trie_;
     Patricia::Node rtnode_;
     DBTableWalker::WalkId walkid_;
     DISALLOW_COPY_AND_ASSIGN(Inet4UnicastAgentRouteTable);
@@ -40,10 +40,22 @@ Inet4UnicastAgentRouteTable::FindRoute(const string &vrf_name,
     return rt_table->FindLPM(ip);
 }
 
+void Inet4UnicastAgentRouteTable::ProcessAdd(RouteEntry *rt) {
+    Inet4UnicastRouteEntry *entry = static_cast<Inet4UnicastRouteEntry *>(rt);
+    tree_.Insert(entry);
+    lpm_trie_.Insert(entry->GetIpAddress().to_ulong(), entry->GetPlen(),
+                     entry);
+}
+
+void Inet4UnicastAgentRouteTable::ProcessDelete(RouteEntry *rt) {
+    Inet4UnicastRouteEntry *entry = static_cast<Inet4UnicastRouteEntry *>(rt);
+    tree_.Remove(entry);
+    lpm_trie_.Remove(entry->GetIpAddress().to_ulong(), entry->GetPlen());
+}
+
 Inet4UnicastRouteEntry *
 Inet4UnicastAgentRouteTable::FindLPM(const Ip4Address &ip) {
-    Inet4UnicastRouteEntry key(NULL, ip);
-    return tree_.LPMFind(&key);
+    return lpm_trie_.LPMFind(ip.to_ulong());
 }
 
 Inet4UnicastRouteEntry *
@@ -2,8 +2,10 @@
  * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <algorithm>
 #include <vector>
 #include <bitset>
+#include <boost/functional/hash.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <sandesh/sandesh_types.h>
 #include <sandesh/sandesh.h>
@@ -557,40 +559,151 @@ void FlowEntry::FillFlowInfo(FlowInfo &info) {
     }
 }
 
+size_t FlowKeyHash::operator()(const FlowKey &key) const {
+    size_t seed = 0;
+    boost::hash_combine(seed, key.vrf);
+    boost::hash_combine(seed, key.src.ipv4);
+    boost::hash_combine(seed, key.dst.ipv4);
+    boost::hash_combine(seed, key.protocol);
+    boost::hash_combine(seed, key.src_port);
+    boost::hash_combine(seed, key.dst_port);
+    return seed;
+}
+
+FlowEntryHash::FlowEntryHash()
+    : slots_(new FlowEntry *[kMinSize]), mask_(kMinSize - 1), count_(0) {
+    std::fill(slots_, slots_ + kMinSize, static_cast<FlowEntry *>(NULL));
+}
+
+FlowEntryHash::~FlowEntryHash() {
+    delete [] slots_;
+}
+
+FlowEntry *FlowEntryHash::Find(const FlowKey &key) const {
+    FlowKey lookup(key);
+    for (size_t i = Slot(key); slots_[i] != NULL; i = (i + 1) & mask_) {
+        if (lookup.CompareKey(slots_[i]->key)) {
+            return slots_[i];
+        }
+    }
+    return NULL;
+}
+
+bool FlowEntryHash::Insert(FlowEntry *flow) {
+    // Keep the load factor at or below 1/2
+    if ((count_ + 1) * 2 > capacity()) {
+        Resize(capacity() * 2);
+    }
+    size_t i = Slot(flow->key);
+    for (; slots_[i] != NULL; i = (i + 1) & mask_) {
+        if (flow->key.CompareKey(slots_[i]->key)) {
+            return false;
+        }
+    }
+    slots_[i] = flow;
+    count_++;
+    return true;
+}
+
+bool FlowEntryHash::Remove(const FlowKey &key) {
+    FlowKey lookup(key);
+    size_t i = Slot(key);
+    for (; slots_[i] != NULL; i = (i + 1) & mask_) {
+        if (lookup.CompareKey(slots_[i]->key)) {
+            break;
+        }
+    }
+    if (slots_[i] == NULL) {
+        return false;
+    }
+
+    // Move back the entries following the hole that would no longer be
+    // reachable from their home slot.
+    size_t hole = i;
+    for (size_t j = (i + 1) & mask_; slots_[j] != NULL; j = (j + 1) & mask_) {
+        size_t home = Slot(slots_[j]->key);
+        if (((j - home) & mask_) >= ((j - hole) & mask_)) {
+            slots_[hole] = slots_[j];
+            hole = j;
+        }
+    }
+    slots_[hole] = NULL;
+    count_--;
+    return true;
+}
+
+void FlowEntryHash::Shrink() {
+    size_t size = capacity();
+    while (size > kMinSize && count_ * 8 < size) {
+        size /= 2;
+    }
+    if (size != capacity()) {
+        Resize(size);
+    }
+}
+
+FlowEntryHash::iterator FlowEntryHash::upper_bound(const FlowKey &key) const {
+    FlowKey lookup(key);
+    size_t i = Slot(key);
+    for (; slots_[i] != NULL; i = (i + 1) & mask_) {
+        if (lookup.CompareKey(slots_[i]->key)) {
+            return iterator(this, NextSlot(i + 1));
+        }
+    }
+    return iterator(this, NextSlot(Slot(key)));
+}
+
+size_t FlowEntryHash::NextSlot(size_t slot) const {
+    for (; slot < capacity(); slot++) {
+        if (slots_[slot] != NULL) {
+            return slot;
+        }
+    }
+    return capacity();
+}
+
+void FlowEntryHash::Resize(size_t size) {
+    FlowEntry **old_slots = slots_;
+    size_t old_size = capacity();
+    slots_ = new FlowEntry *[size];
+    std::fill(slots_, slots_ + size, static_cast<FlowEntry *>(NULL));
+    mask_ = size - 1;
+    for (size_t i = 0; i < old_size; i++) {
+        if (old_slots[i] == NULL)
+            continue;
+        size_t j = Slot(old_slots[i]->key);
+        while (slots_[j] != NULL) {
+            j = (j + 1) & mask_;
+        }
+        slots_[j] = old_slots[i];
+    }
+    delete [] old_slots;
+}
+
 FlowEntry *FlowTable::Allocate(const FlowKey &key) {
-    FlowEntry *flow = new FlowEntry(key);
-    std::pair<FlowEntryMap::iterator, bool> ret;
-    ret = flow_entry_map_.insert(std::pair<FlowKey, FlowEntry*>(key, flow));
-    if (ret.second == false) {
-        delete flow;
-        flow = ret.first->second;
+    FlowEntry *flow = flow_entry_hash_.Find(key);
+    if (flow != NULL) {
         DeleteFlowInfo(flow);
-    } else {
-        flow->flow_uuid = FlowTable::rand_gen_();
-        flow->egress_uuid = FlowTable::rand_gen_();
-        flow->setup_time = UTCTimestampUsec();
-        AgentStats::GetInstance()->IncrFlowActive();
-        AgentStats::GetInstance()->IncrFlowCreated();
+        return flow;
     }
 
+    flow = new FlowEntry(key);
+    flow_entry_hash_.Insert(flow);
+    flow->flow_uuid = FlowTable::rand_gen_();
+    flow->egress_uuid = FlowTable::rand_gen_();
+    flow->setup_time = UTCTimestampUsec();
+    AgentStats::GetInstance()->IncrFlowActive();
+    AgentStats::GetInstance()->IncrFlowCreated();
     return flow;
 }
 
 FlowEntry *FlowTable::Find(const FlowKey &key) {
-    FlowEntryMap::iterator it;
-
-    it = flow_entry_map_.find(key);
-    if (it != flow_entry_map_.end()) {
-        return it->second;
-    } else {
-        return NULL;
-    }
+    return flow_entry_hash_.Find(key);
 }
 
-void FlowTable::DeleteInternal(FlowEntryMap::iterator &it)
+void FlowTable::DeleteInternal(FlowEntry *fe)
 {
     FlowInfo flow_info;
-    FlowEntry *fe = it->second;
     fe->FillFlowInfo(flow_info);
     FLOW_TRACE(Trace, "Delete", flow_info);
 
@@ -606,7 +719,7 @@ void FlowTable::DeleteInternal(FlowEntryMap::iterator &it)
     fe->data.reverse_flow = NULL;
 
     DeleteFlowInfo(fe);
-    flow_entry_map_.erase(it);
+    flow_entry_hash_.Remove(fe->key);
 
     FlowTableKSyncEntry *ksync_entry = 
         FlowTableKSyncObject::GetKSyncObject()->Find(fe);
@@ -626,18 +739,16 @@ void FlowTable::DeleteInternal(FlowEntryMap::iterator &it)
 
 bool FlowTable::DeleteRevFlow(FlowKey &key, bool rev_flow)
 {   
-    FlowEntryMap::iterator it;
     FlowEntryPtr pfe;
 
     // Find the flow, get the reverse flow and delete flow. 
-    it = flow_entry_map_.find(key);
-    if (it == flow_entry_map_.end()) {
+    pfe = flow_entry_hash_.Find(key);
+    if (pfe.get() == NULL) {
         return false;
     }
-    pfe = it->second;
     FlowEntryPtr reverse_flow;
     reverse_flow = pfe->data.reverse_flow;
-    DeleteInternal(it);
+    DeleteInternal(pfe.get());
     if (!rev_flow) {
         return true;
     }
@@ -648,55 +759,22 @@ bool FlowTable::DeleteRevFlow(FlowKey &key, bool rev_flow)
         return true;
     }
 
-    it = flow_entry_map_.find(reverse_flow.get()->key);
-    if (it == flow_entry_map_.end()) {
+    FlowEntry *rfe = flow_entry_hash_.Find(reverse_flow.get()->key);
+    if (rfe == NULL) {
         return false;
     }
-    DeleteInternal(it);
+    DeleteInternal(rfe);
     return true;
 }
 
-bool FlowTable::Delete(FlowEntryMap::iterator &it, bool rev_flow)
-{
-    FlowEntry *fe;
-    FlowEntryMap::iterator rev_it;
-
-    fe = it->second;
-    FlowEntry *reverse_flow = NULL;
-    if (fe->nat || rev_flow) {
-        reverse_flow = fe->data.reverse_flow.get();
-    }
-    DeleteInternal(it);
-
-    if (!reverse_flow) {
-        return true;
-    }
-    /* If reverse-flow is valid and the present iterator is pointing to it,
-     * use that iterator to delete reverse flow
-     */
-    if (reverse_flow == it->second) {
-        DeleteInternal(it);
-        return true;
-    }
-
-    rev_it = flow_entry_map_.find(reverse_flow->key);
-    if (rev_it != flow_entry_map_.end()) {
-        DeleteInternal(rev_it);
-        return true;
-    }
-    return false;
-}
-
 bool FlowTable::DeleteNatFlow(FlowKey &key, bool del_nat_flow)
 {
-    FlowEntryMap::iterator it;
     FlowEntry *fe;
 
-    it = flow_entry_map_.find(key);
-    if (it == flow_entry_map_.end()) {
+    fe = flow_entry_hash_.Find(key);
+    if (fe == NULL) {
         return false;
     }
-    fe = it->second;
 
     FlowEntry *reverse_flow = NULL;
     if (del_nat_flow) {
@@ -704,15 +782,15 @@ bool FlowTable::DeleteNatFlow(FlowKey &key, bool del_nat_flow)
     }
 
     /* Delete the forward flow */
-    DeleteInternal(it);
+    DeleteInternal(fe);
 
     if (!reverse_flow) {
         return true;
     }
 
-    it = flow_entry_map_.find(reverse_flow->key);
-    if (it != flow_entry_map_.end()) {
-        DeleteInternal(it);
+    FlowEntry *rfe = flow_entry_hash_.Find(reverse_flow->key);
+    if (rfe != NULL) {
+        DeleteInternal(rfe);
         return true;
     }
     return false;
@@ -720,14 +798,15 @@ bool FlowTable::DeleteNatFlow(FlowKey &key, bool del_nat_flow)
 
 void FlowTable::DeleteAll()
 {
-    FlowEntryMap::iterator it;
+    FlowEntryIterator it;
 
-    it = flow_entry_map_.begin();
-    while (it != flow_entry_map_.end()) {
-        FlowKey fekey = it->second->key;
+    it = flow_entry_hash_.begin();
+    while (it != flow_entry_hash_.end()) {
+        FlowKey fekey = (*it)->key;
         DeleteNatFlow(fekey, true);
-        it = flow_entry_map_.begin();
+        it = flow_entry_hash_.begin();
     }
+    flow_entry_hash_.Shrink();
 }
 
 void FlowTable::DeleteAclFlows(const AclDBEntry *acl)
@@ -1109,12 +1188,15 @@ void FlowTable::ResyncVnFlows(const VnEntry *vn) {
         return;
     }
 
-    FlowEntryTree fet = vn_it->second->fet;
-    FlowEntryTree::iterator fet_it, it;
-    it = fet.begin();
-    while (it != fet.end()) {
-        fet_it = it++;
-        FlowEntry *fe = (*fet_it).get();
+    // A re-evaluated flow is linked back at the tail of the list, so visit
+    // as many flows from the head as the list had to start with.
+    size_t count = vn_it->second->fet.size();
+    while (count-- > 0) {
+        vn_it = vn_flow_tree_.find(vn);
+        if (vn_it == vn_flow_tree_.end()) {
+            break;
+        }
+        FlowEntry *fe = &vn_it->second->fet.front();
         DeleteFlowInfo(fe);
         MatchPolicy policy;
         fe->GetPolicy(vn, &policy);
@@ -1153,19 +1235,12 @@ void FlowTable::ResyncAclFlows(const AclDBEntry *acl)
     }
 }
 
-void FlowTable::TrapReverseEcmpFlow(RouteFlowKey &key, uint32_t index, 
-                                    bool ingress) {
-    RouteFlowTree::iterator rf_it;
-    rf_it = route_flow_tree_.find(key);
-    if (rf_it == route_flow_tree_.end()) {
-        return;
-    }
-    FlowEntryTree fet = rf_it->second->fet;
-    FlowEntryTree::iterator fet_it, it;
-    it = fet.begin();
-    while (it != fet.end()) {
-        fet_it = it++;
-        FlowEntry *fe = (*fet_it).get();
+template <typename FlowList>
+static void TrapReverseEcmpFlowList(FlowList &list, const RouteFlowKey &key,
+                                    uint32_t index, bool ingress) {
+    typename FlowList::iterator it;
+    for (it = list.begin(); it != list.end(); ++it) {
+        FlowEntry *fe = &(*it);
         //Check only for flows whose destination matches
         //given route
         if (fe->data.flow_dest_vrf != key.vrf) {
@@ -1194,6 +1269,17 @@ void FlowTable::TrapReverseEcmpFlow(RouteFlowKey &key, uint32_t index,
     }
 }
 
+void FlowTable::TrapReverseEcmpFlow(RouteFlowKey &key, uint32_t index, 
+                                    bool ingress) {
+    RouteFlowTree::iterator rf_it;
+    rf_it = route_flow_tree_.find(key);
+    if (rf_it == route_flow_tree_.end()) {
+        return;
+    }
+    TrapReverseEcmpFlowList(rf_it->second->src_fet, key, index, ingress);
+    TrapReverseEcmpFlowList(rf_it->second->dst_fet, key, index, ingress);
+}
+
 void FlowTable::ResyncRouteFlows(RouteFlowKey &key, SecurityGroupList &sg_l)
 {
     RouteFlowTree::iterator rf_it;
@@ -1201,12 +1287,37 @@ void FlowTable::ResyncRouteFlows(RouteFlowKey &key, SecurityGroupList &sg_l)
     if (rf_it == route_flow_tree_.end()) {
         return;
     }
-    FlowEntryTree fet = rf_it->second->fet;
-    FlowEntryTree::iterator fet_it, it;
-    it = fet.begin();
-    while (it != fet.end()) {
-        fet_it = it++;
-        FlowEntry *fe = (*fet_it).get();
+    // A re-evaluated flow is linked back at the tail of the lists, so visit
+    // as many flows from the head as the lists had to start with. A flow
+    // whose source and destination are both the route is re-evaluated from
+    // the source list only.
+    size_t src_count = rf_it->second->src_fet.size();
+    size_t dst_count = rf_it->second->dst_fet.size();
+    while (src_count + dst_count > 0) {
+        rf_it = route_flow_tree_.find(key);
+        if (rf_it == route_flow_tree_.end()) {
+            break;
+        }
+        FlowEntry *fe;
+        if (src_count > 0) {
+            src_count--;
+            if (rf_it->second->src_fet.empty()) {
+                continue;
+            }
+            fe = &rf_it->second->src_fet.front();
+        } else {
+            dst_count--;
+            if (rf_it->second->dst_fet.empty()) {
+                continue;
+            }
+            fe = &rf_it->second->dst_fet.front();
+            if (key.vrf == fe->data.flow_source_vrf &&
+                key.ip.ipv4 == fe->key.src.ipv4) {
+                rf_it->second->dst_fet.pop_front();
+                rf_it->second->dst_fet.push_back(*fe);
+                continue;
+            }
+        }
         DeleteFlowInfo(fe);
         MatchPolicy policy;
         fe->GetPolicy(fe->data.vn_entry.get(), &policy);
@@ -1237,12 +1348,15 @@ void FlowTable::ResyncVmPortFlows(const VmPortInterface *intf) {
         return;
     }
 
-    FlowEntryTree fet = intf_it->second->fet;
-    FlowEntryTree::iterator fet_it, it;
-    it = fet.begin();
-    while (it != fet.end()) {
-        fet_it = it++;
-        FlowEntry *fe = (*fet_it).get();
+    // A re-evaluated flow is linked back at the tail of the list, so visit
+    // as many flows from the head as the list had to start with.
+    size_t count = intf_it->second->fet.size();
+    while (count-- > 0) {
+        intf_it = intf_flow_tree_.find(intf);
+        if (intf_it == intf_flow_tree_.end()) {
+            break;
+        }
+        FlowEntry *fe = &intf_it->second->fet.front();
         DeleteFlowInfo(fe);
         MatchPolicy policy;
         fe->GetPolicy(intf->GetVnEntry(), &policy);
@@ -1264,13 +1378,21 @@ void FlowTable::DeleteRouteFlows(const RouteFlowKey &key)
         return;
     }
     FLOW_TRACE(ModuleInfo, "Delete Route flows");
-    FlowEntryTree fet = rf_it->second->fet;
-    FlowEntryTree::iterator fet_it, it;
-    it = fet.begin();
-    while (it != fet.end()) {
-        fet_it = it++;
-        FlowEntry *fe = (*fet_it).get();
+    // Deleting a flow unlinks it, and its reverse flow, from the lists. The
+    // RouteFlowInfo is freed along with the last flow.
+    while ((rf_it = route_flow_tree_.find(key)) != route_flow_tree_.end()) {
+        RouteFlowInfo *route_flow_info = rf_it->second;
+        FlowEntryPtr fe;
+        if (!route_flow_info->src_fet.empty()) {
+            fe = &route_flow_info->src_fet.front();
+        } else {
+            fe = &route_flow_info->dst_fet.front();
+        }
         DeleteNatFlow(fe->key, true);
+        if (fe->src_route_node_.is_linked() ||
+            fe->dst_route_node_.is_linked()) {
+            DeleteRouteFlowInfo(fe.get());
+        }
     }
 }
 
@@ -1329,8 +1451,8 @@ void FlowTable::DeleteVnFlowInfo(FlowEntry *fe)
         vn_it = vn_flow_tree_.find(fe->data.vn_entry.get());
         if (vn_it != vn_flow_tree_.end()) {
             VnFlowInfo *vn_flow_info = vn_it->second;
-            int count = vn_flow_info->fet.erase(fe);
-            if (count > 0) {
+            if (fe->vn_node_.is_linked()) {
+                fe->vn_node_.unlink();
                 DecrVnFlowCounter(vn_flow_info, fe);
             }
             if (vn_flow_info->fet.empty()) {
@@ -1369,7 +1491,7 @@ void FlowTable::DeleteIntfFlowInfo(FlowEntry *fe)
         intf_it = intf_flow_tree_.find(fe->data.intf_entry.get());
         if (intf_it != intf_flow_tree_.end()) {
             IntfFlowInfo *intf_flow_info = intf_it->second;
-            intf_flow_info->fet.erase(fe);
+            fe->intf_node_.unlink();
             if (intf_flow_info->fet.empty()) {
                 delete intf_flow_info;
                 intf_flow_tree_.erase(intf_it);
@@ -1385,7 +1507,7 @@ void FlowTable::DeleteVmFlowInfo(FlowEntry *fe)
         vm_it = vm_flow_tree_.find(fe->data.vm_entry.get());
         if (vm_it != vm_flow_tree_.end()) {
             VmFlowInfo *vm_flow_info = vm_it->second;
-            vm_flow_info->fet.erase(fe);
+            fe->vm_node_.unlink();
             if (vm_flow_info->fet.empty()) {
                 delete vm_flow_info;
                 vm_flow_tree_.erase(vm_it);
@@ -1398,23 +1520,23 @@ void FlowTable::DeleteRouteFlowInfo (FlowEntry *fe)
 {
     RouteFlowTree::iterator rf_it;
     RouteFlowKey skey(fe->data.flow_source_vrf, fe->key.src.ipv4);
+    fe->src_route_node_.unlink();
     rf_it = route_flow_tree_.find(skey);
     RouteFlowInfo *route_flow_info;
     if (rf_it != route_flow_tree_.end()) {
         route_flow_info = rf_it->second;
-        route_flow_info->fet.erase(fe);
-        if (route_flow_info->fet.empty()) {
+        if (route_flow_info->empty()) {
             delete route_flow_info;
             route_flow_tree_.erase(rf_it);
         }
     }
 
     RouteFlowKey dkey(fe->data.flow_dest_vrf, fe->key.dst.ipv4);
+    fe->dst_route_node_.unlink();
     rf_it = route_flow_tree_.find(dkey);
     if (rf_it != route_flow_tree_.end()) {
         route_flow_info = rf_it->second;
-        route_flow_info->fet.erase(fe);
-        if (route_flow_info->fet.empty()) {
+        if (route_flow_info->empty()) {
             delete route_flow_info;
             route_flow_tree_.erase(rf_it);
         }
@@ -1514,12 +1636,13 @@ void FlowTable::AddIntfFlowInfo (FlowEntry *fe)
     if (it == intf_flow_tree_.end()) {
         intf_flow_info = new IntfFlowInfo();
         intf_flow_info->intf_entry = fe->data.intf_entry;
-        intf_flow_info->fet.insert(fe);
         intf_flow_tree_.insert(IntfFlowPair(fe->data.intf_entry.get(), intf_flow_info));
     } else {
         intf_flow_info = it->second;
-        /* fe can already exist. In that case it won't be inserted */
-        intf_flow_info->fet.insert(fe);
+    }
+    /* fe can already exist. In that case it won't be inserted */
+    if (!fe->intf_node_.is_linked()) {
+        intf_flow_info->fet.push_back(*fe);
     }
 }
 
@@ -1534,12 +1657,13 @@ void FlowTable::AddVmFlowInfo (FlowEntry *fe)
     if (it == vm_flow_tree_.end()) {
         vm_flow_info = new VmFlowInfo();
         vm_flow_info->vm_entry = fe->data.vm_entry;
-        vm_flow_info->fet.insert(fe);
         vm_flow_tree_.insert(VmFlowPair(fe->data.vm_entry.get(), vm_flow_info));
     } else {
         vm_flow_info = it->second;
-        /* fe can already exist. In that case it won't be inserted */
-        vm_flow_info->fet.insert(fe);
+    }
+    /* fe can already exist. In that case it won't be inserted */
+    if (!fe->vm_node_.is_linked()) {
+        vm_flow_info->fet.push_back(*fe);
     }
 }
 
@@ -1582,17 +1706,14 @@ void FlowTable::AddVnFlowInfo (FlowEntry *fe)
     if (it == vn_flow_tree_.end()) {
         vn_flow_info = new VnFlowInfo();
         vn_flow_info->vn_entry = fe->data.vn_entry;
-        vn_flow_info->fet.insert(fe);
-        IncrVnFlowCounter(vn_flow_info, fe);
         vn_flow_tree_.insert(VnFlowPair(fe->data.vn_entry.get(), vn_flow_info));
     } else {
         vn_flow_info = it->second;
-        /* fe can already exist. In that case it won't be inserted */
-        pair<FlowTable::FlowEntryTree::iterator, bool> ret = 
-                                            vn_flow_info->fet.insert(fe);
-        if (ret.second) {
-            IncrVnFlowCounter(vn_flow_info, fe);
-        }
+    }
+    /* fe can already exist. In that case it won't be inserted */
+    if (!fe->vn_node_.is_linked()) {
+        vn_flow_info->fet.push_back(*fe);
+        IncrVnFlowCounter(vn_flow_info, fe);
     }
 }
 
@@ -1614,30 +1735,30 @@ void FlowTable::AddRouteFlowInfo (FlowEntry *fe)
 {
     RouteFlowTree::iterator it;
     RouteFlowInfo *route_flow_info;
-    if (fe->data.flow_source_vrf != VrfEntry::kInvalidIndex) {
+    if (fe->data.flow_source_vrf != VrfEntry::kInvalidIndex &&
+        !fe->src_route_node_.is_linked()) {
         RouteFlowKey skey(fe->data.flow_source_vrf, fe->key.src.ipv4);
         it = route_flow_tree_.find(skey);
         if (it == route_flow_tree_.end()) {
             route_flow_info = new RouteFlowInfo();
-            route_flow_info->fet.insert(fe);
             route_flow_tree_.insert(RouteFlowPair(skey, route_flow_info));
         } else {
             route_flow_info = it->second;
-            route_flow_info->fet.insert(fe);
         }
+        route_flow_info->src_fet.push_back(*fe);
     }
 
-    if (fe->data.flow_dest_vrf != VrfEntry::kInvalidIndex) {
+    if (fe->data.flow_dest_vrf != VrfEntry::kInvalidIndex &&
+        !fe->dst_route_node_.is_linked()) {
         RouteFlowKey dkey(fe->data.flow_dest_vrf, fe->key.dst.ipv4);
         it = route_flow_tree_.find(dkey);
         if (it == route_flow_tree_.end()) {
             route_flow_info = new RouteFlowInfo();
-            route_flow_info->fet.insert(fe);
             route_flow_tree_.insert(RouteFlowPair(dkey, route_flow_info));
         } else {
             route_flow_info = it->second;
-            route_flow_info->fet.insert(fe);
         }
+        route_flow_info->dst_fet.push_back(*fe);
     }
 }
 
@@ -1692,10 +1813,14 @@ void FlowTable::DeleteVnFlows(const VnEntry *vn)
         return;
     }
     FLOW_TRACE(ModuleInfo, "Delete Vn Flows");
-    FlowEntryTree fet = vn_it->second->fet;
-    FlowEntryTree::iterator fet_it;
-    for (fet_it = fet.begin(); fet_it != fet.end(); ++fet_it) {
-        DeleteNatFlow((*fet_it)->key, true);
+    // Deleting a flow unlinks it, and its reverse flow, from the list. The
+    // VnFlowInfo is freed along with the last flow.
+    while ((vn_it = vn_flow_tree_.find(vn)) != vn_flow_tree_.end()) {
+        FlowEntryPtr fe = &vn_it->second->fet.front();
+        DeleteNatFlow(fe->key, true);
+        if (fe->vn_node_.is_linked()) {
+            DeleteVnFlowInfo(fe.get());
+        }
     }
 }
 
@@ -1707,10 +1832,14 @@ void FlowTable::DeleteVmFlows(const VmEntry *vm)
         return;
     }
     FLOW_TRACE(ModuleInfo, "Delete VM flows");
-    FlowEntryTree fet = vm_it->second->fet;
-    FlowEntryTree::iterator fet_it;
-    for (fet_it = fet.begin(); fet_it != fet.end(); ++fet_it) {
-        DeleteNatFlow((*fet_it)->key, true);
+    // Deleting a flow unlinks it, and its reverse flow, from the list. The
+    // VmFlowInfo is freed along with the last flow.
+    while ((vm_it = vm_flow_tree_.find(vm)) != vm_flow_tree_.end()) {
+        FlowEntryPtr fe = &vm_it->second->fet.front();
+        DeleteNatFlow(fe->key, true);
+        if (fe->vm_node_.is_linked()) {
+            DeleteVmFlowInfo(fe.get());
+        }
     }
 }
 
@@ -1722,10 +1851,14 @@ void FlowTable::DeleteVmIntfFlows(const Interface *intf)
         return;
     }
     FLOW_TRACE(ModuleInfo, "Delete Interface Flows");
-    FlowEntryTree fet = intf_it->second->fet;
-    FlowEntryTree::iterator fet_it;
-    for (fet_it = fet.begin(); fet_it != fet.end(); ++fet_it) {
-        DeleteNatFlow((*fet_it)->key, true);
+    // Deleting a flow unlinks it, and its reverse flow, from the list. The
+    // IntfFlowInfo is freed along with the last flow.
+    while ((intf_it = intf_flow_tree_.find(intf)) != intf_flow_tree_.end()) {
+        FlowEntryPtr fe = &intf_it->second->fet.front();
+        DeleteNatFlow(fe->key, true);
+        if (fe->intf_node_.is_linked()) {
+            DeleteIntfFlowInfo(fe.get());
+        }
     }
 }
 
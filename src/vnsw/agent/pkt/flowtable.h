@@ -9,6 +9,7 @@
 #include <boost/uuid/random_generator.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <boost/intrusive_ptr.hpp>
+#include <boost/intrusive/list.hpp>
 #include <tbb/atomic.h>
 #include <tbb/mutex.h>
 #include <base/util.h>
@@ -44,6 +45,10 @@ class NhListener;
 class NhState;
 typedef boost::intrusive_ptr<FlowEntry> FlowEntryPtr;
 typedef boost::intrusive_ptr<const NhState> NhStatePtr;
+// Hook linking a FlowEntry into one of the secondary flow lists. The hook
+// unlinks itself, so a flow can be dropped from a list without the list.
+typedef boost::intrusive::list_member_hook<
+    boost::intrusive::link_mode<boost::intrusive::auto_unlink> > FlowListHook;
 struct RouteFlowKey {
     RouteFlowKey() : vrf(0) { ip.ipv4 = 0;};
     RouteFlowKey(uint32_t v, uint32_t ipv4) : vrf(v) { ip.ipv4 = ipv4;};
@@ -362,6 +367,12 @@ private:
     static tbb::atomic<int> alloc_count_;
     // atomic refcount
     tbb::atomic<int> refcount_;
+    // Links into the VN, interface, VM and route flow lists of FlowTable
+    FlowListHook vn_node_;
+    FlowListHook intf_node_;
+    FlowListHook vm_node_;
+    FlowListHook src_route_node_;
+    FlowListHook dst_route_node_;
 };
  
 inline void intrusive_ptr_add_ref(FlowEntry *fe) {
@@ -383,13 +394,124 @@ struct FlowEntryCmp {
     }
 };
 
+struct FlowKeyHash {
+    size_t operator()(const FlowKey &key) const;
+};
+
+// Open addressing hash of the flow entries, keyed by FlowEntry::key.
+//
+// Slots hold the entry pointers only; the key is read from the entry. Linear
+// probing is used and deletes shift the following entries back, so there are
+// no tombstones and lookups of absent keys stop at the first empty slot.
+//
+// Walks go in slot order. A walk that removes entries must not advance past
+// the current slot, since a following entry may have been moved back into
+// it. A walk that resumes from a slot or a key after the table changed may
+// visit an entry twice or miss it for that pass.
+class FlowEntryHash {
+public:
+    class iterator {
+    public:
+        iterator() : table_(NULL), slot_(0) { }
+        FlowEntry *operator*() const { return table_->slots_[slot_]; }
+        iterator &operator++() {
+            slot_ = table_->NextSlot(slot_ + 1);
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator it(*this);
+            ++(*this);
+            return it;
+        }
+        bool operator==(const iterator &rhs) const {
+            return slot_ == rhs.slot_;
+        }
+        bool operator!=(const iterator &rhs) const {
+            return slot_ != rhs.slot_;
+        }
+        size_t slot() const { return slot_; }
+
+    private:
+        friend class FlowEntryHash;
+        iterator(const FlowEntryHash *table, size_t slot)
+            : table_(table), slot_(slot) { }
+
+        const FlowEntryHash *table_;
+        size_t slot_;
+    };
+
+    FlowEntryHash();
+    ~FlowEntryHash();
+
+    FlowEntry *Find(const FlowKey &key) const;
+    // Returns false if an entry with the same key is present
+    bool Insert(FlowEntry *flow);
+    // Returns false if no entry has the key. Remove never shrinks the table,
+    // so that the slot of a walk in progress stays valid.
+    bool Remove(const FlowKey &key);
+    // Shrink a sparsely used table. Invalidates all iterators and slots.
+    void Shrink();
+
+    size_t size() const { return count_; }
+    size_t capacity() const { return mask_ + 1; }
+
+    iterator begin() const { return iterator(this, NextSlot(0)); }
+    iterator end() const { return iterator(this, capacity()); }
+    // First entry at or after the slot
+    iterator from_slot(size_t slot) const {
+        return iterator(this, NextSlot(slot));
+    }
+    // Entry following the key. If the key is absent, the walk resumes from
+    // the key's home slot.
+    iterator upper_bound(const FlowKey &key) const;
+
+private:
+    static const size_t kMinSize = 1024;
+
+    size_t Slot(const FlowKey &key) const {
+        return FlowKeyHash()(key) & mask_;
+    }
+    // First occupied slot at or after the slot, capacity() if none
+    size_t NextSlot(size_t slot) const;
+    void Resize(size_t size);
+
+    FlowEntry **slots_;
+    size_t mask_;
+    size_t count_;
+
+    DISALLOW_COPY_AND_ASSIGN(FlowEntryHash);
+};
+
 class FlowTable {
 public:
     static const int MaxResponses = 100;
-    typedef std::map<FlowKey, FlowEntry *, FlowKeyCmp> FlowEntryMap;
+    typedef FlowEntryHash::iterator FlowEntryIterator;
 
     typedef std::map<int, int> AceIdFlowCntMap;
     typedef std::set<FlowEntryPtr, FlowEntryCmp> FlowEntryTree;
+
+    // Secondary flow lists. Entries are linked through hooks in FlowEntry
+    // and are not reference counted; a flow is unlinked when it is deleted.
+    typedef boost::intrusive::list<FlowEntry,
+        boost::intrusive::member_hook<FlowEntry, FlowListHook,
+                                      &FlowEntry::vn_node_>,
+        boost::intrusive::constant_time_size<false> > VnFlowList;
+    typedef boost::intrusive::list<FlowEntry,
+        boost::intrusive::member_hook<FlowEntry, FlowListHook,
+                                      &FlowEntry::intf_node_>,
+        boost::intrusive::constant_time_size<false> > IntfFlowList;
+    typedef boost::intrusive::list<FlowEntry,
+        boost::intrusive::member_hook<FlowEntry, FlowListHook,
+                                      &FlowEntry::vm_node_>,
+        boost::intrusive::constant_time_size<false> > VmFlowList;
+    typedef boost::intrusive::list<FlowEntry,
+        boost::intrusive::member_hook<FlowEntry, FlowListHook,
+                                      &FlowEntry::src_route_node_>,
+        boost::intrusive::constant_time_size<false> > SrcRouteFlowList;
+    typedef boost::intrusive::list<FlowEntry,
+        boost::intrusive::member_hook<FlowEntry, FlowListHook,
+                                      &FlowEntry::dst_route_node_>,
+        boost::intrusive::constant_time_size<false> > DstRouteFlowList;
     typedef std::map<const AclDBEntry *, AclFlowInfo *> AclFlowTree;
     typedef std::pair<const AclDBEntry *, AclFlowInfo *> AclFlowPair;
 
@@ -437,7 +559,7 @@ public:
     };
 
     FlowTable() : 
-        flow_entry_map_(), acl_flow_tree_(), acl_listener_id_(), intf_listener_id_(),
+        flow_entry_hash_(), acl_flow_tree_(), acl_listener_id_(), intf_listener_id_(),
         vn_listener_id_(), vm_listener_id_(), vrf_listener_id_(), 
         nh_listener_(NULL) {};
     virtual ~FlowTable();
@@ -453,7 +575,7 @@ public:
     bool DeleteNatFlow(FlowKey &key, bool del_nat_flow);
     bool DeleteRevFlow(FlowKey &key, bool del_reverse_flow);
 
-    size_t Size() {return flow_entry_map_.size();};
+    size_t Size() {return flow_entry_hash_.size();};
     void VnFlowCounters(const VnEntry *vn, uint32_t *in_count, 
                         uint32_t *out_count);
 
@@ -467,15 +589,17 @@ public:
     void SetAceSandeshData(const AclDBEntry *acl, AclFlowCountResp &data, 
                            int ace_id);
    
-    FlowTable::FlowEntryMap::iterator begin() {
-        return flow_entry_map_.begin();
+    FlowTable::FlowEntryIterator begin() {
+        return flow_entry_hash_.begin();
     }
 
-    FlowTable::FlowEntryMap::iterator end() {
-        return flow_entry_map_.end(); 
+    FlowTable::FlowEntryIterator end() {
+        return flow_entry_hash_.end(); 
     }
 
     DBTableBase::ListenerId nh_listener_id();
+    // Serializes flow table updates from the flow setup partitions
+    tbb::mutex &mutex() { return mutex_; }
     friend class FlowStatsCollector;
     friend class PktSandeshFlow;
     friend class FetchFlowRecord;
@@ -483,7 +607,8 @@ public:
     friend class NhState;
 private:
     static FlowTable* singleton_;
-    FlowEntryMap flow_entry_map_;
+    tbb::mutex mutex_;
+    FlowEntryHash flow_entry_hash_;
 
     AclFlowTree acl_flow_tree_;
     VnFlowTree vn_flow_tree_;
@@ -534,8 +659,7 @@ private:
     void AddRouteFlowInfo(FlowEntry *fe);
 
     void DeleteAclFlows(const AclDBEntry *acl);
-    void DeleteInternal(FlowEntryMap::iterator &it);
-    bool Delete(FlowEntryMap::iterator &it, bool rev_flow);
+    void DeleteInternal(FlowEntry *fe);
 
     void UpdateReverseFlow(FlowEntry *flow, FlowEntry *rflow);
 
@@ -627,7 +751,7 @@ struct VnFlowInfo {
     ~VnFlowInfo() {};
 
     VnEntryConstRef vn_entry;
-    FlowTable::FlowEntryTree fet;
+    FlowTable::VnFlowList fet;
     uint32_t ingress_flow_count;
     uint32_t egress_flow_count;
 };
@@ -637,7 +761,7 @@ struct IntfFlowInfo {
     ~IntfFlowInfo() {};
 
     InterfaceConstRef intf_entry;
-    FlowTable::FlowEntryTree fet;
+    FlowTable::IntfFlowList fet;
 };
 
 struct VmFlowInfo {
@@ -645,13 +769,16 @@ struct VmFlowInfo {
     ~VmFlowInfo() {};
 
     VmEntryConstRef vm_entry;
-    FlowTable::FlowEntryTree fet;
+    FlowTable::VmFlowList fet;
 };
 
 struct RouteFlowInfo {
     RouteFlowInfo() {};
     ~RouteFlowInfo() {};
-    FlowTable::FlowEntryTree fet;
+    bool empty() const { return src_fet.empty() && dst_fet.empty(); }
+    // Flows whose source or destination is the route
+    FlowTable::SrcRouteFlowList src_fet;
+    FlowTable::DstRouteFlowList dst_fet;
 };
 
 extern SandeshTraceBufferPtr FlowTraceBuf;
@@ -6,6 +6,8 @@
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <netinet/udp.h>
+#include <algorithm>
+#include <boost/functional/hash.hpp>
 
 #include "route/route.h"
 
@@ -36,6 +38,23 @@ void FlowHandler::Shutdown() {
     FlowProto::Shutdown();
 }
 
+// Order the end points so that the forward and reverse packets of a flow
+// hash to the same value.
+size_t FlowProto::FlowHash(uint32_t sip, uint32_t dip, uint8_t proto,
+                           uint16_t sport, uint16_t dport) {
+    if (sip > dip || (sip == dip && sport > dport)) {
+        std::swap(sip, dip);
+        std::swap(sport, dport);
+    }
+    size_t seed = 0;
+    boost::hash_combine(seed, sip);
+    boost::hash_combine(seed, dip);
+    boost::hash_combine(seed, proto);
+    boost::hash_combine(seed, sport);
+    boost::hash_combine(seed, dport);
+    return seed;
+}
+
 static void LogError(const PktInfo *pkt, const char *str) {
     FLOW_TRACE(DetailErr, pkt->agent_hdr.cmd_param, pkt->agent_hdr.ifindex,
                pkt->agent_hdr.vrf, pkt->ip_saddr, pkt->ip_daddr, str);
@@ -708,6 +727,8 @@ bool PktFlowInfo::Process(const PktInfo *pkt, PktControlInfo *in,
 
 void PktFlowInfo::Add(const PktInfo *pkt, PktControlInfo *in,
                       PktControlInfo *out) {
+    // The forward and reverse flow are allocated and linked as one update
+    tbb::mutex::scoped_lock lock(FlowTable::GetFlowTableObject()->mutex());
     FlowKey key(pkt->vrf, pkt->ip_saddr, pkt->ip_daddr,
                 pkt->ip_proto, pkt->sport, pkt->dport);
     FlowEntryPtr flow(FlowTable::GetFlowTableObject()->Allocate(key));
@@ -760,6 +781,7 @@ void PktFlowInfo::RewritePktInfo(uint32_t flow_index) {
         return;
     }
 
+    tbb::mutex::scoped_lock lock(FlowTable::GetFlowTableObject()->mutex());
     FlowEntry *flow = FlowTable::GetFlowTableObject()->Find(key);
     if (!flow) {
         std::ostringstream ostr;  
@@ -27,15 +27,32 @@ public:
 private:
 };
 
+// Flow setup runs in flow_thread_count partitions, selected by a hash of the
+// 5-tuple. The hash is symmetric so that packets of both directions of a
+// flow are handled by the same partition. FlowTable updates are serialized
+// across partitions by the FlowTable mutex.
 class FlowProto : public Proto<FlowHandler> {
 public:
-    FlowProto(boost::asio::io_service &io) :
-        Proto<FlowHandler>("Agent::FlowHandler", PktHandler::FLOW, io) {};
+    FlowProto(boost::asio::io_service &io, int partitions) :
+        Proto<FlowHandler>("Agent::FlowHandler", PktHandler::FLOW, io,
+                           partitions) {};
 
     virtual ~FlowProto() {};
 
     static void Init(boost::asio::io_service &io) {
-        Agent::GetInstance()->SetFlowProto(new FlowProto(io));
+        int partitions = 1;
+        if (Agent::GetInstance()->params()) {
+            partitions = Agent::GetInstance()->params()->flow_thread_count();
+        }
+        Agent::GetInstance()->SetFlowProto(new FlowProto(io, partitions));
+    }
+
+    static size_t FlowHash(uint32_t sip, uint32_t dip, uint8_t proto,
+                           uint16_t sport, uint16_t dport);
+
+    virtual size_t PartitionHash(const PktInfo *msg) const {
+        return FlowHash(msg->ip_saddr, msg->ip_daddr, msg->ip_proto,
+                        msg->sport, msg->dport);
     }
 
     static void Shutdown() {
@@ -225,26 +225,28 @@ bool PktSandeshFlow::SetFlowKey(string key) {
 }
 
 bool PktSandeshFlow::Run() {
-    FlowTable::FlowEntryMap::iterator it;
+    FlowTable::FlowEntryIterator it;
     std::vector<SandeshFlowData>& list = const_cast<std::vector<SandeshFlowData>&>(resp_obj_->get_flow_list());
     int count = 0;
     bool flow_key_set = false;
     FlowTable *flow_obj = FlowTable::GetFlowTableObject();
 
-    if (key_valid_) {
-        it = flow_obj->flow_entry_map_.upper_bound(flow_iteration_key_);
+    if (key_valid_ && key_start_) {
+        it = flow_obj->flow_entry_hash_.begin();
+    } else if (key_valid_) {
+        it = flow_obj->flow_entry_hash_.upper_bound(flow_iteration_key_);
     } else {
         FlowErrorResp *resp = new FlowErrorResp();
         SendResponse(resp);
         return true;
     }
-    while (it != flow_obj->flow_entry_map_.end()) {
-        FlowEntry *fe = it->second;
+    while (it != flow_obj->flow_entry_hash_.end()) {
+        FlowEntry *fe = *it;
         SetSandeshFlowData(list, fe);
         ++it;
         count++;
         if (count == max_flow_response) {
-            if (it != flow_obj->flow_entry_map_.end()) {
+            if (it != flow_obj->flow_entry_hash_.end()) {
                 resp_obj_->set_flow_key(GetFlowKey(fe->key));
                 flow_key_set = true;
             }
@@ -285,13 +287,11 @@ void FetchFlowRecord::HandleRequest() const {
     key.dst_port = (unsigned)get_dst_port();
     key.protocol = get_protocol();
 
-    FlowTable::FlowEntryMap::iterator it;
     FlowTable *flow_obj = FlowTable::GetFlowTableObject();
-    it = flow_obj->flow_entry_map_.find(key);
+    FlowEntry *fe = flow_obj->Find(key);
     SandeshResponse *resp;
-    if (it != flow_obj->flow_entry_map_.end()) {
+    if (fe != NULL) {
         FlowRecordResp *flow_resp = new FlowRecordResp();
-        FlowEntry *fe = it->second;
         SandeshFlowData data;
         SET_SANDESH_FLOW_DATA(data, fe);
         flow_resp->set_record(data);
@@ -16,10 +16,11 @@ public:
     PktSandeshFlow(FlowRecordsResp *obj, std::string resp_ctx, std::string key) :
         Task((TaskScheduler::GetInstance()->GetTaskId("Agent::PktFlowResponder")),
               0), resp_obj_(obj), resp_data_(resp_ctx), 
-        flow_iteration_key_(), key_valid_(false) {
+        flow_iteration_key_(), key_valid_(false), key_start_(false) {
         if (key != Agent::GetInstance()->NullString()) {
             if (SetFlowKey(key)) {
                 key_valid_ = true;
+                key_start_ = (key == start_key);
             }
         }
     }
@@ -34,6 +35,8 @@ protected:
     std::string resp_data_;
     FlowKey flow_iteration_key_;
     bool key_valid_;
+    // Flows are walked in hash order, which the start key has no place in
+    bool key_start_;
 };
 
 #endif
@@ -6,14 +6,21 @@
 #define vnsw_agent_proto_hpp
 
 #include <net/if.h>
+#include <vector>
 #include "base/queue_task.h"
 #include "vr_defs.h"
 #include "pkt_handler.h"
 #include "oper/mirror_table.h"
 
+// Packets of a module are processed by one or more work queues. With more
+// than one partition, each queue runs as its own task instance so that the
+// partitions are processed in parallel, and PartitionHash() decides which
+// partition a packet goes to.
 template <class Handler>
 class Proto {
 public:
+    typedef WorkQueue<PktInfo *> PktQueue;
+
     static void Init(const char *name, PktHandler::ModuleName mod, 
                      boost::asio::io_service &io) {
         assert(instance_ == NULL);
@@ -25,15 +32,24 @@ public:
         instance_ = NULL;
     }
 
-    Proto(const char *task_name, PktHandler::ModuleName mod, boost::asio::io_service &io) : 
-        work_queue_(TaskScheduler::GetInstance()->GetTaskId(task_name), mod,
-                    boost::bind(&Proto<Handler>::ProcessProto, this, _1)), io_(io) { 
+    Proto(const char *task_name, PktHandler::ModuleName mod,
+          boost::asio::io_service &io, int partitions = 1) : io_(io) {
+        int task_id = TaskScheduler::GetInstance()->GetTaskId(task_name);
+        assert(partitions > 0);
+        for (int i = 0; i < partitions; i++) {
+            int instance = (partitions == 1) ? mod : i;
+            work_queues_.push_back(new PktQueue(task_id, instance,
+                boost::bind(&Proto<Handler>::ProcessProto, this, _1)));
+        }
         PktHandler::GetPktHandler()->Register(mod,
                     boost::bind(&Proto::ValidateAndEnqueueMessage, this, _1) );
     };
 
     virtual ~Proto() { 
-        work_queue_. Shutdown();
+        for (size_t i = 0; i < work_queues_.size(); i++) {
+            work_queues_[i]->Shutdown();
+        }
+        STLDeleteValues(&work_queues_);
     };
 
     virtual bool Validate(PktInfo *msg) {
@@ -44,12 +60,24 @@ public:
         return false;
     }
 
+    // Called only when there is more than one partition.
+    virtual size_t PartitionHash(const PktInfo *msg) const {
+        return 0;
+    }
+
+    int partition_count() const { return work_queues_.size(); }
+
     bool ValidateAndEnqueueMessage(PktInfo *msg) {
         if (!Validate(msg)) {
             delete msg;
             return true;
         }
 
+        size_t partition = 0;
+        if (work_queues_.size() > 1) {
+            partition = PartitionHash(msg) % work_queues_.size();
+        }
+
         if (RemovePktBuff()) {
             if (msg->pkt)
                 delete [] msg->pkt;
@@ -61,7 +89,7 @@ public:
             msg->data = NULL;
         }
 
-        return work_queue_.Enqueue(msg);
+        return work_queues_[partition]->Enqueue(msg);
     };
 
     bool ProcessProto(PktInfo *msg_info) {
@@ -73,7 +101,7 @@ public:
 
 protected:
     static Proto *instance_;
-    WorkQueue<PktInfo *> work_queue_;
+    std::vector<PktQueue *> work_queues_;
     boost::asio::io_service &io_;
     DISALLOW_COPY_AND_ASSIGN(Proto);
 };
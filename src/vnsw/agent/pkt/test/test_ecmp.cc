@@ -1530,11 +1530,11 @@ TEST_F(EcmpTest, EcmpResolve_1) {
     //All flow going to index 3 and index 4, 
     //should have their reverse flow set for trap
     FlowTable *flow_obj = FlowTable::GetFlowTableObject();
-    FlowTable::FlowEntryMap::iterator it;
+    FlowTable::FlowEntryIterator it;
 
     it = flow_obj->begin();
     while (it != flow_obj->end()) {
-        FlowEntry *entry = it->second;
+        FlowEntry *entry = *it;
         if (entry->data.component_nh_idx == 3 || 
             entry->data.component_nh_idx == 4) {
             EXPECT_TRUE(entry->data.reverse_flow.get()->data.trap == true);
@@ -1582,11 +1582,11 @@ TEST_F(EcmpTest, EcmpResolve_2) {
     //All flow going to vnet2 
     //should have their reverse flow set for trap
     FlowTable *flow_obj = FlowTable::GetFlowTableObject();
-    FlowTable::FlowEntryMap::iterator it;
+    FlowTable::FlowEntryIterator it;
 
     it = flow_obj->begin();
     while (it != flow_obj->end()) {
-        FlowEntry *entry = it->second;
+        FlowEntry *entry = *it;
         if (entry->data.component_nh_idx == index) {
             EXPECT_TRUE(entry->data.reverse_flow.get()->data.trap == true);
         } else {
@@ -1646,11 +1646,11 @@ TEST_F(EcmpTest, EcmpResolve_3) {
 
     //All flow going to vnet2 should be marked for trap
     FlowTable *flow_obj = FlowTable::GetFlowTableObject();
-    FlowTable::FlowEntryMap::iterator it;
+    FlowTable::FlowEntryIterator it;
 
     it = flow_obj->begin();
     while (it != flow_obj->end()) {
-        FlowEntry *entry = it->second;
+        FlowEntry *entry = *it;
         if (entry->data.component_nh_idx == index) {
             EXPECT_TRUE(entry->data.reverse_flow.get()->data.trap == true);
         } else {
@@ -1710,11 +1710,11 @@ TEST_F(EcmpTest, EcmpResolve_4) {
 
     //All flow going to vnet2 should be marked for trap
     FlowTable *flow_obj = FlowTable::GetFlowTableObject();
-    FlowTable::FlowEntryMap::iterator it;
+    FlowTable::FlowEntryIterator it;
 
     it = flow_obj->begin();
     while (it != flow_obj->end()) {
-        FlowEntry *entry = it->second;
+        FlowEntry *entry = *it;
         if (entry->data.component_nh_idx == index) {
             EXPECT_TRUE(entry->data.reverse_flow.get()->data.trap == true);
         } else {
@@ -895,6 +895,69 @@ TEST_F(FlowTest, FIP_traffic_to_leaked_routes) {
     client->WaitForIdle();
 }
 
+// Replace the flow setup module with one that runs the given number of
+// partitions.
+static void SetFlowPartitions(int partitions) {
+    client->WaitForIdle();
+    FlowProto::Shutdown();
+    Agent::GetInstance()->SetFlowProto(new FlowProto(
+        *Agent::GetInstance()->GetEventManager()->io_service(), partitions));
+    client->WaitForIdle();
+}
+
+// Set up NAT flows in both directions through several flow partitions at
+// once. The reverse flow of a NAT flow hashes to another partition than the
+// packet that creates it.
+TEST_F(FlowTest, NatFlowPartitions) {
+    const int kPartitions = 4;
+    const int kFlows = 32;
+    SetFlowPartitions(kPartitions);
+    EXPECT_EQ(kPartitions,
+              Agent::GetInstance()->GetFlowProto()->partition_count());
+
+    uint32_t vm1 = Ip4Address::from_string(vnet_addr[1]).to_ulong();
+    uint32_t vm3 = Ip4Address::from_string(vnet_addr[3]).to_ulong();
+    uint32_t fip = Ip4Address::from_string("2.1.1.100").to_ulong();
+    int cross_partition = 0;
+    for (int i = 0; i < kFlows; i++) {
+        size_t fwd = FlowProto::FlowHash(vm1, vm3, IPPROTO_TCP, 1000 + i, 80);
+        size_t rev = FlowProto::FlowHash(vm3, fip, IPPROTO_TCP, 80, 1000 + i);
+        if (fwd % kPartitions != rev % kPartitions) {
+            cross_partition++;
+        }
+    }
+    EXPECT_NE(0, cross_partition);
+
+    for (int i = 0; i < kFlows; i++) {
+        TxTcpPacket(vnet[1]->GetInterfaceId(), vnet_addr[1], vnet_addr[3],
+                    1000 + i, 80, i + 1);
+        TxTcpPacket(vnet[3]->GetInterfaceId(), vnet_addr[3], "2.1.1.100",
+                    3000 + i, 80, kFlows + i + 1);
+    }
+    client->WaitForIdle();
+    EXPECT_EQ((size_t) (4 * kFlows), FlowTable::GetFlowTableObject()->Size());
+
+    for (int i = 0; i < kFlows; i++) {
+        EXPECT_TRUE(NatValidateFlow(i + 1,
+                                    vnet[1]->GetVrf()->GetName().c_str(),
+                                    vnet_addr[1], vnet_addr[3], IPPROTO_TCP,
+                                    1000 + i, 80, 1,
+                                    vnet[3]->GetVrf()->GetName().c_str(),
+                                    "2.1.1.100", vnet_addr[3], 1000 + i, 80,
+                                    "vn2", "vn2"));
+        EXPECT_TRUE(NatValidateFlow(kFlows + i + 1,
+                                    vnet[3]->GetVrf()->GetName().c_str(),
+                                    vnet_addr[3], "2.1.1.100", IPPROTO_TCP,
+                                    3000 + i, 80, 1,
+                                    vnet[1]->GetVrf()->GetName().c_str(),
+                                    vnet_addr[3], vnet_addr[1], 3000 + i, 80,
+                                    "vn2", "vn2"));
+    }
+    EXPECT_EQ(0U, FlowTable::GetFlowTableObject()->Size());
+
+    SetFlowPartitions(1);
+}
+
 int main(int argc, char *argv[]) {
     int ret = 0;
 
@@ -1500,6 +1500,143 @@ TEST_F(FlowTest, AclDelete) {
     EXPECT_TRUE(FlowTableWait(0));
 }
 
+// Both directions of a flow must be set up by the same flow partition.
+TEST_F(FlowTest, FlowHashSymmetric) {
+    uint32_t sip = Ip4Address::from_string(vm1_ip).to_ulong();
+    uint32_t dip = Ip4Address::from_string(vm2_ip).to_ulong();
+    for (uint16_t sport = 1000; sport < 1100; sport++) {
+        EXPECT_EQ(FlowProto::FlowHash(sip, dip, IPPROTO_TCP, sport, 80),
+                  FlowProto::FlowHash(dip, sip, IPPROTO_TCP, 80, sport));
+        EXPECT_EQ(FlowProto::FlowHash(sip, sip, IPPROTO_UDP, sport, 53),
+                  FlowProto::FlowHash(sip, sip, IPPROTO_UDP, 53, sport));
+    }
+    EXPECT_NE(FlowProto::FlowHash(sip, dip, IPPROTO_TCP, 1000, 80),
+              FlowProto::FlowHash(sip, dip, IPPROTO_TCP, 1001, 80));
+}
+
+// Inserts and removes enough flows to grow and shrink FlowEntryHash, checking
+// that the remaining flows are found after every backward shift.
+TEST_F(FlowTest, FlowEntryHash) {
+    FlowEntryHash hash;
+    std::vector<FlowEntry *> flows;
+    uint32_t sip = Ip4Address::from_string(vm1_ip).to_ulong();
+    uint32_t dip = Ip4Address::from_string(vm2_ip).to_ulong();
+    for (uint16_t sport = 0; sport < 5000; sport++) {
+        FlowKey key(1, sip, dip + (sport % 7), IPPROTO_TCP, sport, 80);
+        FlowEntry *flow = new FlowEntry(key);
+        EXPECT_TRUE(hash.Insert(flow));
+        EXPECT_FALSE(hash.Insert(flow));
+        flows.push_back(flow);
+    }
+    EXPECT_EQ(flows.size(), hash.size());
+    EXPECT_LE(hash.size() * 2, hash.capacity());
+
+    FlowKey absent(2, sip, dip, IPPROTO_TCP, 1, 80);
+    EXPECT_TRUE(hash.Find(absent) == NULL);
+    EXPECT_FALSE(hash.Remove(absent));
+
+    for (size_t i = 0; i < flows.size(); i += 2) {
+        EXPECT_TRUE(hash.Remove(flows[i]->key));
+    }
+    for (size_t i = 0; i < flows.size(); i++) {
+        FlowEntry *expected = (i % 2) ? flows[i] : NULL;
+        EXPECT_EQ(expected, hash.Find(flows[i]->key));
+    }
+    for (size_t i = 1; i < flows.size(); i += 2) {
+        EXPECT_TRUE(hash.Remove(flows[i]->key));
+    }
+    EXPECT_EQ(0U, hash.size());
+    EXPECT_EQ(1024U, hash.capacity());
+    STLDeleteValues(&flows);
+}
+
+// Walks FlowEntryHash, resuming after a key as the flow sandesh does and
+// removing entries in place as the flow stats collector does.
+TEST_F(FlowTest, FlowEntryHashWalk) {
+    FlowEntryHash hash;
+    std::vector<FlowEntry *> flows;
+    uint32_t sip = Ip4Address::from_string(vm1_ip).to_ulong();
+    uint32_t dip = Ip4Address::from_string(vm2_ip).to_ulong();
+    for (uint16_t sport = 0; sport < 2000; sport++) {
+        FlowKey key(1, sip, dip, IPPROTO_TCP, sport, 80);
+        FlowEntry *flow = new FlowEntry(key);
+        EXPECT_TRUE(hash.Insert(flow));
+        flows.push_back(flow);
+    }
+
+    std::set<FlowEntry *> seen;
+    FlowEntryHash::iterator it = hash.begin();
+    while (it != hash.end()) {
+        FlowEntry *flow = *it;
+        EXPECT_TRUE(seen.insert(flow).second);
+        it = hash.upper_bound(flow->key);
+    }
+    EXPECT_EQ(flows.size(), seen.size());
+
+    // An entry moved back across the end of the table may be seen twice,
+    // but none is missed.
+    seen.clear();
+    it = hash.begin();
+    while (it != hash.end()) {
+        FlowEntry *flow = *it;
+        seen.insert(flow);
+        if (flow->key.src_port % 2) {
+            EXPECT_TRUE(hash.Remove(flow->key));
+            it = hash.from_slot(it.slot());
+        } else {
+            ++it;
+        }
+    }
+    EXPECT_EQ(flows.size(), seen.size());
+    EXPECT_EQ(flows.size() / 2, hash.size());
+    for (size_t i = 0; i < flows.size(); i++) {
+        FlowEntry *expected = (i % 2) ? NULL : flows[i];
+        EXPECT_EQ(expected, hash.Find(flows[i]->key));
+    }
+    STLDeleteValues(&flows);
+}
+
+// Removing most entries during a walk must not shrink the table under the
+// walk. The table shrinks only on an explicit Shrink.
+TEST_F(FlowTest, FlowEntryHashShrink) {
+    FlowEntryHash hash;
+    std::vector<FlowEntry *> flows;
+    uint32_t sip = Ip4Address::from_string(vm1_ip).to_ulong();
+    uint32_t dip = Ip4Address::from_string(vm2_ip).to_ulong();
+    for (uint16_t sport = 0; sport < 4000; sport++) {
+        FlowKey key(1, sip, dip, IPPROTO_TCP, sport, 80);
+        FlowEntry *flow = new FlowEntry(key);
+        EXPECT_TRUE(hash.Insert(flow));
+        flows.push_back(flow);
+    }
+    size_t capacity = hash.capacity();
+
+    std::set<FlowEntry *> seen;
+    FlowEntryHash::iterator it = hash.begin();
+    while (it != hash.end()) {
+        FlowEntry *flow = *it;
+        seen.insert(flow);
+        if (flow->key.src_port % 16) {
+            EXPECT_TRUE(hash.Remove(flow->key));
+            it = hash.from_slot(it.slot());
+        } else {
+            ++it;
+        }
+    }
+    EXPECT_EQ(flows.size(), seen.size());
+    EXPECT_EQ(capacity, hash.capacity());
+    EXPECT_EQ(flows.size() / 16, hash.size());
+
+    hash.Shrink();
+    EXPECT_GT(capacity, hash.capacity());
+    EXPECT_GE(hash.size() * 8, hash.capacity());
+    for (size_t i = 0; i < flows.size(); i++) {
+        FlowEntry *expected = (i % 16) ? NULL : flows[i];
+        EXPECT_EQ(expected, hash.Find(flows[i]->key));
+    }
+    STLDeleteValues(&flows);
+}
+
 int main(int argc, char *argv[]) {
     GETUSERARGS();
 
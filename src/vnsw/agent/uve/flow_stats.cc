@@ -158,10 +158,10 @@ uint64_t FlowStatsCollector::GetUpdatedFlowPackets(const FlowEntry *fe,
 }
 
 bool FlowStatsCollector::Run() {
-    FlowTable::FlowEntryMap::iterator it;
+    FlowTable::FlowEntryIterator it;
     FlowEntry *entry = NULL, *reverse_flow;
     uint32_t count = 0;
-    bool key_updation_reqd = true, deleted;
+    bool deleted;
     uint64_t diff_bytes, diff_pkts;
     FlowTable *flow_obj = FlowTable::GetFlowTableObject();
   
@@ -170,18 +170,17 @@ bool FlowStatsCollector::Run() {
         return true;
     }
     uint64_t curr_time = UTCTimestampUsec();
-    it = flow_obj->flow_entry_map_.upper_bound(flow_iteration_key_);
-    if (it == flow_obj->flow_entry_map_.end()) {
-        it = flow_obj->flow_entry_map_.begin();
+    // Deleting a flow may move a following flow back into the current slot,
+    // so the walk only moves on from a slot whose flow is kept.
+    it = flow_obj->flow_entry_hash_.from_slot(flow_iteration_slot_);
+    if (it == flow_obj->flow_entry_hash_.end()) {
+        it = flow_obj->flow_entry_hash_.begin();
     }
 
-    while (it != flow_obj->flow_entry_map_.end()) {
-        entry = it->second;
-        it++;
+    while (it != flow_obj->flow_entry_hash_.end()) {
+        entry = *it;
         assert(entry);
         deleted = false;
-
-        flow_iteration_key_ = entry->key;
         const vr_flow_entry *k_flow = 
             FlowTableKSyncObject::GetKSyncObject()->GetKernelFlowEntry
             (entry->flow_handle, false);
@@ -203,11 +202,6 @@ bool FlowStatsCollector::Run() {
         }
 
         if (deleted == true) {
-            if (it != flow_obj->flow_entry_map_.end()) {
-                if (it->second == reverse_flow) {
-                    it++;
-                }
-            }
             FlowTable::GetFlowTableObject()->DeleteRevFlow
                 (entry->key, reverse_flow != NULL? true : false);
             entry = NULL;
@@ -246,21 +240,26 @@ bool FlowStatsCollector::Run() {
             FlowTable::GetFlowTableObject()->DeleteRevFlow(entry->key, false);
         }
 
+        if (deleted) {
+            it = flow_obj->flow_entry_hash_.from_slot(it.slot());
+        } else {
+            ++it;
+        }
+
         count++;
         if (count == flow_count_per_pass_) {
             break;
         }
     }
-    
-    if (count == flow_count_per_pass_) {
-        if (it != flow_obj->flow_entry_map_.end()) {
-            key_updation_reqd = false;
-        }
-    }
 
-    /* Reset the iteration key if we are done with all the elements */
-    if (key_updation_reqd) {
-        flow_iteration_key_.Reset();
+    /* Restart from the first slot if we are done with all the elements.
+     * The table only shrinks here, so that the saved slot stays valid.
+     */
+    if (it != flow_obj->flow_entry_hash_.end()) {
+        flow_iteration_slot_ = it.slot();
+    } else {
+        flow_iteration_slot_ = 0;
+        flow_obj->flow_entry_hash_.Shrink();
     }
     /* Update the flow_timer_interval and flow_count_per_pass_ based on 
      * total flows that we have
@@ -28,7 +28,7 @@ public:
                        ("Agent::StatsCollector"),
                        StatsCollector::FlowStatsCollector, 
                        io, intvl, "Flow stats collector") {
-        flow_iteration_key_.Reset();
+        flow_iteration_slot_ = 0;
         flow_default_interval_ = intvl;
         flow_age_time_intvl_ = FlowAgeTime;
         flow_count_per_pass_ = FlowCountPerPass;
@@ -59,7 +59,7 @@ private:
     static void SourceIpOverride(FlowEntry *flow, FlowDataIpv4 &s_flow);
     uint64_t GetUpdatedFlowPackets(const FlowEntry *fe, uint64_t k_flow_pkts);
     uint64_t GetUpdatedFlowBytes(const FlowEntry *fe, uint64_t k_flow_bytes);
-    FlowKey flow_iteration_key_;
+    size_t flow_iteration_slot_;
     uint64_t flow_age_time_intvl_;
     uint32_t flow_count_per_pass_;
     uint32_t flow_multiplier_;
@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "xmpp/xmpp_session.h"
+
+#include <stdlib.h>
+#include <sstream>
+#include <boost/regex.hpp>
+
+#include "base/logging.h"
+#include "base/util.h"
+#include "xmpp/xmpp_str.h"
+
+#include "testing/gunit.h"
+
+using namespace std;
+
+namespace {
+
+// The boost::regex based framing the XmppStanzaFramer replaced, for the
+// comparison tests. Handles established sessions only.
+class RegexFramer {
+public:
+    RegexFramer() : patt_(rXMPP_MESSAGE), tag_known_(false), offset_(0) { }
+
+    void Read(const uint8_t *data, size_t size, vector<string> *stanzas) {
+        buf_ += string(data, data + size);
+        while (!buf_.empty()) {
+            if (!tag_known_) {
+                size_t pos = buf_.find_first_not_of(sXMPP_VALIDWS);
+                if (pos != 0) {
+                    if (pos == string::npos) pos = buf_.size();
+                    Deliver(pos, stanzas);
+                    continue;
+                }
+            }
+
+            boost::regex close;
+            if (tag_known_) {
+                close = boost::regex("</" + begin_tag_.substr(1) +
+                                     "[\\s\\t\\r\\n]*>");
+            }
+            boost::match_results<string::const_iterator> res;
+            string::const_iterator start = buf_.begin() + offset_;
+            string::const_iterator end = buf_.end();
+            if (!boost::regex_search(start, end, res,
+                    tag_known_ ? close : patt_,
+                    boost::match_default | boost::match_partial)) {
+                return;
+            }
+            if (!res[0].matched) {
+                offset_ = res[0].first - buf_.begin();
+                return;
+            }
+            offset_ = res[0].second - buf_.begin();
+            if (!tag_known_) {
+                begin_tag_ = string(res[0].first, res[0].second);
+                tag_known_ = true;
+                continue;
+            }
+            tag_known_ = false;
+            Deliver(offset_, stanzas);
+        }
+    }
+
+private:
+    void Deliver(size_t length, vector<string> *stanzas) {
+        stanzas->push_back(buf_.substr(0, length));
+        buf_ = buf_.substr(length);
+        offset_ = 0;
+    }
+
+    boost::regex patt_;
+    bool tag_known_;
+    string begin_tag_;
+    string buf_;
+    size_t offset_;
+};
+
+//
+// The benchmark is disabled by default, run it with
+// --gtest_also_run_disabled_tests.
+//
+// Environment variables for the benchmark:
+//     XMPP_BENCH_STANZAS - number of stanzas in the stream (default 10000)
+//
+class XmppFramerTest : public ::testing::Test {
+protected:
+    XmppFramerTest() {
+        stanza_count_ = 10000;
+        char *str = getenv("XMPP_BENCH_STANZAS");
+        if (str) stanza_count_ = strtoul(str, NULL, 0);
+    }
+
+    // Feed the buffers to the framer and return the stanzas found.
+    vector<string> Frame(const vector<string> &buffers,
+                         XmppStanzaFramer::Mode mode) {
+        vector<string> stanzas;
+        for (size_t i = 0; i < buffers.size(); i++) {
+            const uint8_t *data =
+                reinterpret_cast<const uint8_t *>(buffers[i].data());
+            size_t size = buffers[i].size();
+            while (size > 0) {
+                if (!framer_.started()) framer_.Start(mode);
+                bool complete;
+                size_t length = framer_.Scan(data, size, &complete);
+                current_.append(reinterpret_cast<const char *>(data), length);
+                data += length;
+                size -= length;
+                if (!complete) break;
+                stanzas.push_back(current_);
+                current_.clear();
+            }
+        }
+        return stanzas;
+    }
+
+    vector<string> Frame(const string &data, XmppStanzaFramer::Mode mode) {
+        return Frame(vector<string>(1, data), mode);
+    }
+
+    // A stream of count publish stanzas with some whitespace keepalives.
+    string PublishStream(size_t count) {
+        ostringstream oss;
+        for (size_t i = 0; i < count; i++) {
+            oss << "<iq type='set' from='agent-a' to='network-control' id='"
+                << i << "'><pubsub xmlns='http://jabber.org/protocol/pubsub'>"
+                << "<publish node='1/1/blue'><item><entry><nlri><af>1</af>"
+                << "<address>10.1." << (i >> 8) % 256 << "." << i % 256
+                << "/32</address></nlri><next-hops><next-hop><af>1</af>"
+                << "<address>192.168.1.1</address><label>" << i
+                << "</label></next-hop></next-hops></entry></item></publish>"
+                << "</pubsub></iq>" << (i % 16 == 0 ? sXMPP_WHITESPACE : "");
+        }
+        return oss.str();
+    }
+
+    vector<string> RegexFrame(const vector<string> &buffers) {
+        RegexFramer regex_framer;
+        vector<string> stanzas;
+        for (size_t i = 0; i < buffers.size(); i++) {
+            regex_framer.Read(
+                reinterpret_cast<const uint8_t *>(buffers[i].data()),
+                buffers[i].size(), &stanzas);
+        }
+        return stanzas;
+    }
+
+    // Split data in buffers of the given size.
+    vector<string> Split(const string &data, size_t size) {
+        vector<string> buffers;
+        for (size_t pos = 0; pos < data.size(); pos += size) {
+            buffers.push_back(data.substr(pos, size));
+        }
+        return buffers;
+    }
+
+    XmppStanzaFramer framer_;
+    string current_;
+    size_t stanza_count_;
+};
+
+TEST_F(XmppFramerTest, Stanza) {
+    vector<string> stanzas = Frame(
+        "<iq what =1><comm> blah </comm> </iq>"
+        "<message a = '2'> <item> blah blah </item></message >",
+        XmppStanzaFramer::STANZA);
+    ASSERT_EQ(2U, stanzas.size());
+    EXPECT_EQ("<iq what =1><comm> blah </comm> </iq>", stanzas[0]);
+    EXPECT_EQ("<message a = '2'> <item> blah blah </item></message >",
+              stanzas[1]);
+    EXPECT_FALSE(framer_.started());
+}
+
+TEST_F(XmppFramerTest, Partial) {
+    vector<string> buffers;
+    buffers.push_back("<message a = '2'> <item> blah blah </item></mess");
+    buffers.push_back("age><i");
+    buffers.push_back("q a = '2'> <item>");
+    vector<string> stanzas = Frame(buffers, XmppStanzaFramer::STANZA);
+    ASSERT_EQ(1U, stanzas.size());
+    EXPECT_EQ("<message a = '2'> <item> blah blah </item></message>",
+              stanzas[0]);
+    EXPECT_TRUE(framer_.started());
+    EXPECT_EQ("<iq a = '2'> <item>", current_);
+
+    stanzas = Frame(string(" blah blah </item></iq\n>"),
+                    XmppStanzaFramer::STANZA);
+    ASSERT_EQ(1U, stanzas.size());
+    EXPECT_EQ("<iq a = '2'> <item> blah blah </item></iq\n>", stanzas[0]);
+}
+
+// Every split of the stream gives the same stanzas.
+TEST_F(XmppFramerTest, Boundaries) {
+    string data = "<iq a='1'><x/></iq> \n<message><body>b</body></message>"
+                  "<iq></iq >";
+    for (size_t size = 1; size <= data.size(); size++) {
+        vector<string> stanzas = Frame(Split(data, size),
+                                       XmppStanzaFramer::STANZA);
+        ASSERT_LE(4U, stanzas.size());
+        EXPECT_EQ("<iq a='1'><x/></iq>", stanzas[0]);
+        EXPECT_EQ("<iq></iq >", stanzas.back());
+        string joined;
+        for (size_t i = 0; i < stanzas.size(); i++) joined += stanzas[i];
+        EXPECT_EQ(data, joined);
+    }
+}
+
+// Leading whitespace is a stanza by itself, garbage is part of the stanza.
+TEST_F(XmppFramerTest, Whitespace) {
+    vector<string> stanzas = Frame("   abc   <iq> blah </iq>"
+                                   sXMPP_WHITESPACE,
+                                   XmppStanzaFramer::STANZA);
+    ASSERT_EQ(3U, stanzas.size());
+    EXPECT_EQ("   ", stanzas[0]);
+    EXPECT_EQ("abc   <iq> blah </iq>", stanzas[1]);
+    EXPECT_EQ(sXMPP_WHITESPACE, stanzas[2]);
+}
+
+TEST_F(XmppFramerTest, StreamHeader) {
+    string header = "<?xml version='1.0'?><stream:stream from='a' "
+        "xmlns:stream='http://etherx.jabber.org/streams' to='b' "
+        "xmlns:stream=\"http://etherx.jabber.org/streams\" >";
+    vector<string> stanzas = Frame(Split(header + "<stream:features>", 7),
+                                   XmppStanzaFramer::STREAM_HEADER);
+    ASSERT_EQ(1U, stanzas.size());
+    EXPECT_EQ(header, stanzas[0]);
+    EXPECT_EQ("<stream:features>", current_);
+}
+
+// The framer must find the same stanzas as the regex framing.
+TEST_F(XmppFramerTest, RegexFraming) {
+    vector<string> buffers =
+        Split(PublishStream(200), TcpSession::kDefaultBufferSize);
+    vector<string> regex_stanzas = RegexFrame(buffers);
+    vector<string> stanzas = Frame(buffers, XmppStanzaFramer::STANZA);
+    size_t iq_count = 0;
+    for (size_t i = 0; i < stanzas.size(); i++) {
+        if (stanzas[i].compare(0, 3, "<iq") == 0) iq_count++;
+    }
+    EXPECT_EQ(200U, iq_count);
+    EXPECT_EQ(regex_stanzas, stanzas);
+}
+
+// Stanzas per second of the framer against the regex framing.
+TEST_F(XmppFramerTest, DISABLED_Benchmark) {
+    string data = PublishStream(stanza_count_);
+    vector<string> buffers = Split(data, TcpSession::kDefaultBufferSize);
+
+    uint64_t t0 = UTCTimestampUsec();
+    vector<string> regex_stanzas = RegexFrame(buffers);
+    uint64_t regex_usecs = UTCTimestampUsec() - t0 + 1;
+
+    t0 = UTCTimestampUsec();
+    vector<string> stanzas = Frame(buffers, XmppStanzaFramer::STANZA);
+    uint64_t framer_usecs = UTCTimestampUsec() - t0 + 1;
+
+    EXPECT_EQ(regex_stanzas, stanzas);
+
+    cout << "stanzas: " << stanzas.size() << " bytes: " << data.size()
+         << endl;
+    cout << "regex  usecs: " << regex_usecs << endl;
+    cout << "framer usecs: " << framer_usecs << endl;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -16,9 +16,11 @@
 #include "xmpp/xmpp_channel_mux.h"
 #include "xmpp/xmpp_client.h"
 #include "xmpp/xmpp_config.h"
+#include "xmpp/xmpp_connection.h"
 #include "xmpp/xmpp_init.h"
 #include "xmpp/xmpp_proto.h"
 #include "xmpp/xmpp_server.h"
+#include "xmpp/xmpp_session.h"
 #include "xmpp/xmpp_state_machine.h"
 
 #include "testing/gunit.h"
@@ -110,6 +112,30 @@ protected:
         client->ConfigUpdate(config);
     }
 
+    // Publish count messages from the client as the BGP peer and return the
+    // number of socket writes they took.
+    uint64_t Publish(XmppConnection *connection, size_t count) {
+        XmppChannel *channel = connection->ChannelMux();
+        const TcpSession *session = connection->session();
+        uint64_t write_calls = session->GetSocketStats().write_calls;
+        for (size_t i = 0; i < count; i++) {
+            ostringstream oss;
+            oss << "<iq type='set' from='" << SUB_ADDR << "' to='"
+                << XMPP_CONTROL_SERV << "/other-peer' id='" << i << "'>"
+                << "<pubsub xmlns='http://jabber.org/protocol/pubsub'>"
+                << "<publish node='01020304abcd:vpn-ip-address/32'><item>"
+                << "<entry><nlri><af>1</af><address>10.1.2." << i % 256
+                << "/32</address></nlri></entry></item></publish></pubsub>"
+                << "</iq>";
+            string data = oss.str();
+            EXPECT_TRUE(channel->SendBatch(
+                reinterpret_cast<const uint8_t *>(data.data()), data.size(),
+                xmps::BGP, XmppChannel::SendReadyCb()));
+        }
+        channel->Flush(XmppChannel::SendReadyCb());
+        return session->GetSocketStats().write_calls - write_calls;
+    }
+
     auto_ptr<EventManager> evm_;
     auto_ptr<ServerThread> thread_;
     XmppServer *a_;
@@ -170,6 +196,50 @@ TEST_F(XmppPubSubTest, Connection) {
     task_util::WaitForIdle();
 }
 
+// Batched sends take far fewer socket writes than messages, and the server
+// receives all the messages.
+TEST_F(XmppPubSubTest, BatchSend) {
+    XmppConfigData *cfg_b = new XmppConfigData;
+    cfg_b->AddXmppChannelConfig(CreateXmppChannelCfg("127.0.0.1", a_->GetPort(),
+                                SUB_ADDR, XMPP_CONTROL_SERV, true));
+    ConfigUpdate(b_, cfg_b);
+
+    XmppConnection *sconnection;
+    TASK_UTIL_EXPECT_TRUE((sconnection = a_->FindConnection(SUB_ADDR)) != NULL);
+    TASK_UTIL_EXPECT_TRUE(sconnection->GetStateMcState() == xmsm::ESTABLISHED);
+    XmppBgpMockPeer *bgp_schannel =
+            new XmppBgpMockPeer(sconnection->ChannelMux());
+
+    XmppConnection *cconnection = b_->FindConnection(XMPP_CONTROL_SERV);
+    ASSERT_FALSE(cconnection == NULL);
+    TASK_UTIL_EXPECT_TRUE(cconnection->GetStateMcState() == xmsm::ESTABLISHED);
+
+    const size_t kMessages = 200;
+    uint64_t unbatched = Publish(cconnection, kMessages);
+    TASK_UTIL_EXPECT_EQ(kMessages, bgp_schannel->Count());
+    EXPECT_LE(kMessages, unbatched);
+
+    cconnection->ChannelMux()->SetBatchSend(8 * 1024);
+    uint64_t batched = Publish(cconnection, kMessages);
+    TASK_UTIL_EXPECT_EQ(2 * kMessages, bgp_schannel->Count());
+    EXPECT_GT(unbatched / 10, batched);
+
+    XmppConnection::BatchStats stats = cconnection->batch_stats();
+    EXPECT_EQ(batched, stats.batches);
+    EXPECT_EQ(kMessages, stats.messages);
+    EXPECT_EQ(1U, stats.end_of_run);
+    EXPECT_EQ(stats.batches - 1, stats.threshold);
+    EXPECT_EQ(0U, stats.unbatched);
+    LOG(DEBUG, "Socket writes for " << kMessages << " messages: "
+        << unbatched << " unbatched, " << batched << " batched");
+
+    delete bgp_schannel;
+    task_util::WaitForIdle();
+
+    ConfigUpdate(b_, new XmppConfigData());
+    task_util::WaitForIdle();
+}
+
 }
 
 int main(int argc, char **argv) {
@@ -36,6 +36,18 @@ public:
 
     virtual ~XmppChannel() { }
     virtual bool Send(const uint8_t *, size_t, xmps::PeerId, SendReadyCb) = 0;
+    // Same as Send, except that the message is held in the send batch of the
+    // connection if batching is enabled. The sender must call Flush at the
+    // end of its task run.
+    virtual bool SendBatch(const uint8_t *, size_t, xmps::PeerId,
+                           SendReadyCb) = 0;
+    // Enable batching of the messages sent with SendBatch, up to max_bytes.
+    // A max_bytes of 0 disables batching, which is the default.
+    virtual void SetBatchSend(size_t max_bytes) = 0;
+    // Writes the BGP messages batched by SendBatch. Returns false if the
+    // connection is send blocked, in which case the callback is called once
+    // it's writable again.
+    virtual bool Flush(SendReadyCb) = 0;
     virtual void RegisterReceive(xmps::PeerId, ReceiveCb) = 0;
     virtual void UnRegisterReceive(xmps::PeerId) = 0;
     virtual std::string ToString() const = 0;
@@ -38,16 +38,46 @@ void XmppChannelMux::WriteReady(const boost::system::error_code &ec) {
 bool XmppChannelMux::Send(const uint8_t *msg, size_t msgsize, 
                           xmps::PeerId id, 
                           SendReadyCb cb) {
+    return SendInternal(msg, msgsize, id, cb, false);
+}
+
+bool XmppChannelMux::SendBatch(const uint8_t *msg, size_t msgsize,
+                               xmps::PeerId id, SendReadyCb cb) {
+    return SendInternal(msg, msgsize, id, cb, true);
+}
+
+bool XmppChannelMux::SendInternal(const uint8_t *msg, size_t msgsize,
+                                  xmps::PeerId id, SendReadyCb cb,
+                                  bool batch) {
     if (!connection_) return false;
 
     tbb::mutex::scoped_lock lock(mutex_);
-    bool res = connection_->Send(msg, msgsize);
+    bool res = connection_->Send(msg, msgsize, batch);
     if (res == false) {
         RegisterWriteReady(id, cb);
     }
     return res;
 }
 
+void XmppChannelMux::SetBatchSend(size_t max_bytes) {
+    if (!connection_) return;
+    connection_->SetBatchSend(max_bytes);
+}
+
+bool XmppChannelMux::Flush(SendReadyCb cb) {
+    if (!connection_) return false;
+
+    // Nothing is batched unless the connection batches sends.
+    if (connection_->batch_send_bytes() == 0) return true;
+
+    tbb::mutex::scoped_lock lock(mutex_);
+    bool res = connection_->Flush();
+    if (res == false) {
+        RegisterWriteReady(xmps::BGP, cb);
+    }
+    return res;
+}
+
 void XmppChannelMux::RegisterReceive(xmps::PeerId id, ReceiveCb cb) {
     rxmap_.insert(make_pair(id, cb));
 }
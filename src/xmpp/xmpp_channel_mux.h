@@ -19,6 +19,10 @@ public:
     virtual ~XmppChannelMux();
 
     virtual bool Send(const uint8_t *, size_t, xmps::PeerId, SendReadyCb);
+    virtual bool SendBatch(const uint8_t *, size_t, xmps::PeerId,
+                           SendReadyCb);
+    virtual void SetBatchSend(size_t max_bytes);
+    virtual bool Flush(SendReadyCb);
     virtual void RegisterReceive(xmps::PeerId, ReceiveCb);
     virtual void UnRegisterReceive(xmps::PeerId);
     size_t ReceiverCount() const;
@@ -55,6 +59,8 @@ protected:
     friend class XmppChannelMuxMock;
 
 private:
+    bool SendInternal(const uint8_t *, size_t, xmps::PeerId, SendReadyCb,
+                      bool batch);
     void RegisterWriteReady(xmps::PeerId, SendReadyCb);
     void UnRegisterWriteReady(xmps::PeerId id); 
 
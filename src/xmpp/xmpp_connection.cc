@@ -48,6 +48,7 @@ XmppConnection::XmppConnection(TcpServer *server,
       to_(config->ToAddr),
       mux_(XmppObjectFactory::Create<XmppChannelMux>(this)),
       keepalive_time_(GetDefaultkeepAliveTime()),
+      batch_max_bytes_(0), batch_messages_(0),
       disable_read_(false), flap_count_(0), last_flap_(0), close_reason_("") {
 }
 
@@ -67,6 +68,8 @@ void XmppConnection::SetConfig(const XmppChannelConfig *config) {
 void XmppConnection::set_session(XmppSession *session) {
     tbb::spin_mutex::scoped_lock lock(spin_mutex_);
     session_ = session;
+    batch_.clear();
+    batch_messages_ = 0;
 }
 
 const XmppSession *XmppConnection::session() const {
@@ -167,7 +170,7 @@ bool XmppConnection::AcceptSession(XmppSession *session) {
     return state_machine_->PassiveOpen(session);
 }
 
-bool XmppConnection::Send(const uint8_t *data, size_t size) {
+bool XmppConnection::Send(const uint8_t *data, size_t size, bool batch) {
     size_t sent;
     tbb::spin_mutex::scoped_lock lock(spin_mutex_);
     if (session_ == NULL) {
@@ -179,7 +182,69 @@ bool XmppConnection::Send(const uint8_t *data, size_t size) {
            string(reinterpret_cast<const char *>(data), size));
 
     stats_[1].update++;
-    return session_->Send(data, size, &sent);
+    if (!batch || batch_max_bytes_ == 0) {
+        FlushLocked(FLUSH_UNBATCHED);
+        return session_->Send(data, size, &sent);
+    }
+
+    batch_.insert(batch_.end(), data, data + size);
+    batch_messages_++;
+    if (batch_.size() < batch_max_bytes_) {
+        return true;
+    }
+    return FlushLocked(FLUSH_THRESHOLD);
+}
+
+void XmppConnection::SetBatchSend(size_t max_bytes) {
+    tbb::spin_mutex::scoped_lock lock(spin_mutex_);
+    FlushLocked(FLUSH_END_OF_RUN);
+    batch_max_bytes_ = max_bytes;
+    batch_.reserve(max_bytes);
+}
+
+//
+// Write the batched messages. Returns false if the session is send blocked,
+// in which case the data is queued by the session.
+//
+bool XmppConnection::Flush() {
+    tbb::spin_mutex::scoped_lock lock(spin_mutex_);
+    return FlushLocked(FLUSH_END_OF_RUN);
+}
+
+bool XmppConnection::FlushLocked(FlushReason reason) {
+    if (batch_.empty()) {
+        return true;
+    }
+    if (session_ == NULL) {
+        batch_.clear();
+        batch_messages_ = 0;
+        return false;
+    }
+
+    batch_stats_.batches++;
+    batch_stats_.messages += batch_messages_;
+    batch_stats_.bytes += batch_.size();
+    switch (reason) {
+    case FLUSH_END_OF_RUN:
+        batch_stats_.end_of_run++;
+        break;
+    case FLUSH_THRESHOLD:
+        batch_stats_.threshold++;
+        break;
+    case FLUSH_UNBATCHED:
+        batch_stats_.unbatched++;
+        break;
+    }
+
+    bool ready = session_->Send(&batch_[0], batch_.size(), NULL);
+    batch_.clear();
+    batch_messages_ = 0;
+    return ready;
+}
+
+XmppConnection::BatchStats XmppConnection::batch_stats() const {
+    tbb::spin_mutex::scoped_lock lock(spin_mutex_);
+    return batch_stats_;
 }
 
 void XmppConnection::SendOpen(TcpSession *session) {
@@ -5,6 +5,7 @@
 #ifndef __XMPP_CHANNEL_H__
 #define __XMPP_CHANNEL_H__
 
+#include <vector>
 #include <boost/asio/ip/tcp.hpp>
 #include <tbb/spin_mutex.h>
 
@@ -34,6 +35,25 @@ public:
         uint32_t keepalive;
         uint32_t update;
     };
+
+    enum FlushReason {
+        FLUSH_END_OF_RUN,
+        FLUSH_THRESHOLD,
+        FLUSH_UNBATCHED
+    };
+
+    struct BatchStats {
+        BatchStats() : batches(0), messages(0), bytes(0), end_of_run(0),
+            threshold(0), unbatched(0) {
+        }
+        uint64_t batches;       // batches written to the session
+        uint64_t messages;      // messages in those batches
+        uint64_t bytes;
+        uint64_t end_of_run;    // batches flushed at the end of a task run
+        uint64_t threshold;     // batches flushed on reaching the batch size
+        uint64_t unbatched;     // batches flushed ahead of an unbatched send
+    };
+
     XmppConnection(TcpServer *server, const XmppChannelConfig *config);
     virtual ~XmppConnection();
 
@@ -52,7 +72,17 @@ public:
     std::string ToUVEKey() const; 
     std::string FromString() const;
     void SetAdminDown(bool toggle);
-    bool Send(const uint8_t *data, size_t size);
+    bool Send(const uint8_t *data, size_t size, bool batch = false);
+
+    // Batching of update messages. When enabled, Send accumulates the
+    // messages sent with batch set and writes them to the session once
+    // max_bytes are batched, before an unbatched message, or when Flush is
+    // called, which the sender must do at the end of its task run.
+    // A max_bytes of 0 disables batching, which is the default.
+    void SetBatchSend(size_t max_bytes);
+    size_t batch_send_bytes() const { return batch_max_bytes_; }
+    bool Flush();
+    BatchStats batch_stats() const;
 
     // Xmpp connection messages
     void SendOpen(TcpSession *session);
@@ -179,13 +209,14 @@ private:
                                     std::string error_message);
     XmppStanza::XmppMessage *XmppDecode(const std::string &msg);
     void LogKeepAliveSend();
+    bool FlushLocked(FlushReason reason);
 
     TcpServer *server_;
     boost::asio::ip::tcp::endpoint endpoint_;
     boost::asio::ip::tcp::endpoint local_endpoint_;
     const XmppChannelConfig *config_;
-    // Protection for session_ and keepalive_timer_
-    tbb::spin_mutex spin_mutex_;
+    // Protection for session_, keepalive_timer_ and the send batch
+    mutable tbb::spin_mutex spin_mutex_;
     XmppSession *session_;
     std::auto_ptr<XmppStateMachine> state_machine_;
     Timer *keepalive_timer_;
@@ -200,6 +231,10 @@ private:
     std::auto_ptr<XmppStanza::XmppMessage> last_msg_;
     
     ProtoStats stats_[2];
+    size_t batch_max_bytes_;
+    std::vector<uint8_t> batch_;
+    size_t batch_messages_;
+    BatchStats batch_stats_;
     bool     disable_read_;
     uint32_t flap_count_;
     uint64_t last_flap_;
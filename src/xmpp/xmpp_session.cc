@@ -4,6 +4,8 @@
 
 #include "xmpp/xmpp_session.h"
 
+#include <string.h>
+
 #include "xmpp/xmpp_connection.h"
 #include "xmpp/xmpp_log.h"
 #include "xmpp/xmpp_proto.h"
@@ -18,20 +20,172 @@ using namespace std;
 
 using boost::asio::mutable_buffer;
 
-const boost::regex XmppSession::patt_(rXMPP_MESSAGE);
-const boost::regex XmppSession::stream_patt_(rXMPP_STREAM_START);
-const boost::regex XmppSession::stream_res_end_(rXMPP_STREAM_END);
-const boost::regex XmppSession::whitespace_(sXMPP_WHITESPACE);
-
 const std::string XmppStream::close_string = sXML_STREAM_C;
 
+// A stanza starts with the open literal and ends with the close literal,
+// optionally followed by a quote, then by whitespace and '>'.
+struct XmppStanzaFramer::Tag {
+    const char *open;
+    const char *close;
+    bool quoted;
+};
+
+const XmppStanzaFramer::Tag XmppStanzaFramer::kStreamTags[] = {
+    { sXMPP_STREAM_START, sXMPP_STREAM_NS_URI, true },
+};
+
+const XmppStanzaFramer::Tag XmppStanzaFramer::kStanzaTags[] = {
+    { sXMPP_IQ, sXMPP_IQ_C, false },
+    { sXMPP_MESSAGE, sXMPP_MESSAGE_C, false },
+};
+
+static bool IsValidWhitespace(char c) {
+    return (c != '\0' && strchr(sXMPP_VALIDWS, c) != NULL);
+}
+
+static bool IsSpace(char c) {
+    return (c == ' ' || c == '\t' || c == '\r' || c == '\n' ||
+            c == '\f' || c == '\v');
+}
+
+// Number of characters of pattern matched after the first pos of them were
+// matched and c is seen: the longest prefix of pattern ending at c.
+static size_t Advance(const char *pattern, size_t pos, char c) {
+    if (pattern[pos] == c)
+        return pos + 1;
+    for (size_t len = pos; len > 0; len--) {
+        if (pattern[len - 1] == c &&
+            memcmp(pattern, pattern + pos - len + 1, len - 1) == 0) {
+            return len;
+        }
+    }
+    return 0;
+}
+
+XmppStanzaFramer::XmppStanzaFramer()
+    : phase_(IDLE), tags_(NULL), tag_count_(0), tag_(NULL), close_pos_(0) {
+}
+
+void XmppStanzaFramer::Start(Mode mode) {
+    if (mode == STREAM_HEADER) {
+        tags_ = kStreamTags;
+        tag_count_ = sizeof(kStreamTags) / sizeof(kStreamTags[0]);
+    } else {
+        tags_ = kStanzaTags;
+        tag_count_ = sizeof(kStanzaTags) / sizeof(kStanzaTags[0]);
+    }
+    for (size_t i = 0; i < tag_count_; i++) {
+        open_pos_[i] = 0;
+    }
+    tag_ = NULL;
+    close_pos_ = 0;
+    phase_ = BEGIN;
+}
+
+size_t XmppStanzaFramer::Scan(const uint8_t *data, size_t size,
+                              bool *complete) {
+    const char *start = reinterpret_cast<const char *>(data);
+    const char *end = start + size;
+    const char *cp = start;
+    *complete = false;
+
+    while (cp < end) {
+        switch (phase_) {
+        case BEGIN:
+            phase_ = IsValidWhitespace(*cp) ? WHITESPACE : OPEN;
+            break;
+
+        case WHITESPACE:
+            // The whitespace ends at the first other character or with the
+            // data at hand.
+            while (cp < end && IsValidWhitespace(*cp)) {
+                cp++;
+            }
+            phase_ = IDLE;
+            *complete = true;
+            return cp - start;
+
+        case OPEN: {
+            // All the open literals start with '<'.
+            bool none = true;
+            for (size_t i = 0; i < tag_count_; i++) {
+                none = none && (open_pos_[i] == 0);
+            }
+            if (none) {
+                const void *lt = memchr(cp, '<', end - cp);
+                if (lt == NULL) {
+                    cp = end;
+                    break;
+                }
+                cp = static_cast<const char *>(lt);
+            }
+            char c = *cp++;
+            for (size_t i = 0; i < tag_count_; i++) {
+                open_pos_[i] = Advance(tags_[i].open, open_pos_[i], c);
+                if (tags_[i].open[open_pos_[i]] == '\0') {
+                    tag_ = &tags_[i];
+                    phase_ = CLOSE;
+                    break;
+                }
+            }
+            break;
+        }
+
+        case CLOSE: {
+            if (close_pos_ == 0) {
+                const void *first = memchr(cp, tag_->close[0], end - cp);
+                if (first == NULL) {
+                    cp = end;
+                    break;
+                }
+                cp = static_cast<const char *>(first);
+            }
+            close_pos_ = Advance(tag_->close, close_pos_, *cp++);
+            if (tag_->close[close_pos_] == '\0') {
+                phase_ = tag_->quoted ? CLOSE_QUOTE : CLOSE_END;
+            }
+            break;
+        }
+
+        case CLOSE_QUOTE: {
+            char c = *cp++;
+            if (c == '\'' || c == '"') {
+                phase_ = CLOSE_END;
+            } else {
+                close_pos_ = Advance(tag_->close, 0, c);
+                phase_ = CLOSE;
+            }
+            break;
+        }
+
+        case CLOSE_END: {
+            char c = *cp++;
+            if (c == '>') {
+                phase_ = IDLE;
+                *complete = true;
+                return cp - start;
+            }
+            if (!IsSpace(c)) {
+                close_pos_ = Advance(tag_->close, 0, c);
+                phase_ = CLOSE;
+            }
+            break;
+        }
+
+        case IDLE:
+            assert(false);
+            break;
+        }
+    }
+
+    return size;
+}
+
 XmppSession::XmppSession(TcpServer *server, Socket *socket, bool async_ready)
         : TcpSession(server, socket, async_ready), connection_(NULL), 
-          buf_(""), offset_(), tag_known_(0), 
           stats_(XmppStanza::RESERVED_STANZA, XmppSession::StatsPair(0,0)) {
 
     buf_.reserve(kMaxMessageSize);
-    offset_ = buf_.begin();
 }
 
 
@@ -56,115 +210,9 @@ void XmppSession::IncStats(unsigned int type, uint64_t bytes) {
     stats_[type].second += bytes;
 }
 
-boost::regex XmppSession::tag_to_pattern(const char *tag) {
-    std::string token("</");
-    token += ++tag;
-    token += "[\\s\\t\\r\\n]*>";
-
-    boost::regex exp(token.c_str());
-    return exp;
-}
-
-void XmppSession::SetBuf(const std::string &str) {
-    if (buf_.empty()) {
-        ReplaceBuf(str);
-    } else {
-        int pos = offset_ - buf_.begin();
-        buf_ += str;
-        offset_ = buf_.begin() + pos;
-    }
-}
-
-void XmppSession::ReplaceBuf(const std::string &str) {
-    buf_ = str;
-    buf_.reserve(kMaxMessageSize+8);
-    offset_ = buf_.begin();
-}
-
-bool XmppSession::LeftOver() const {
-    if (buf_.empty())
-        return false;
-    return (buf_.end() != offset_);
-}
-
-// Match a pattern in the buffer. Partially matched string is
-// kept in buf_ for use in conjucntion with next buffer read.
-int XmppSession::MatchRegex(const boost::regex &patt) {
-
-    std::string::const_iterator end = buf_.end();
-
-    if (regex_search(offset_, end, res_, patt, 
-                     boost::match_default | boost::match_partial) == 0) {
-        return -1;
-    }
-    if(res_[0].matched == false) {
-        // partial match
-        offset_ = res_[0].first;
-        return 1;
-    } else {
-        begin_tag_ = string(res_[0].first, res_[0].second);
-        offset_ = res_[0].second;
-        return 0; 
-    }
-}
-
-bool XmppSession::Match(Buffer buffer, int *result, bool NewBuf) {
-    const XmppConnection *connection = this->Channel();
-
-    if (connection == NULL) {
-        return true;
-    }
-
-    xmsm::XmState state = connection->GetStateMcState();
-
-    if (NewBuf) {
-        const uint8_t *cp = BufferData(buffer);
-        // TODO Avoid this copy
-        std::string str(cp, cp + BufferSize(buffer));
-        XmppSession::SetBuf(str);
-    }
-
-    int m;
-    *result = 0;
-    do {
-        if (!tag_known_) {
-            // check for whitespaces
-            size_t pos = buf_.find_first_not_of(sXMPP_VALIDWS);
-            if (pos != 0) {
-                if (pos == string::npos) pos = buf_.size();
-                offset_ = buf_.begin() + pos;
-                return false;
-            }
-        }
-
-        if (state == xmsm::ACTIVE || state == xmsm::IDLE) {
-            m = MatchRegex(tag_known_ ? stream_res_end_:stream_patt_);
-        } else if (state == xmsm::CONNECT || state == xmsm::OPENSENT) { 
-            m = MatchRegex(tag_known_ ? stream_res_end_:stream_patt_);
-        } else if (state == xmsm::OPENCONFIRM || state == xmsm::ESTABLISHED) {
-            m = MatchRegex(tag_known_ ? tag_to_pattern(begin_tag_.c_str()):patt_);
-        }
-
-        if (m == 0) { // full match
-            *result = 0; 
-            tag_known_ ^= 1; 
-            if (!tag_known_) {
-                // Found well formed xml
-                return false;
-            }
-        } else if (m == -1) { // no match
-            return true;
-        } else {
-            return true; // partial. read more
-        }
-    } while (true);
-
-    return true;
-}
-
 // Read the socket stream and send messages to the connection object.
-// The buffer is copied to local string for regex match. 
-// TODO Code need to change st Match() is done on buffer itself.
+// Stanzas are framed on the receive buffer itself and copied once, into
+// buf_, which only allocates when a stanza is larger than any before it.
 void XmppSession::OnRead(Buffer buffer) {
     if (this->Channel() == NULL || !connection_) {
         // Connection is deleted. Session is being deleted as well
@@ -182,41 +230,35 @@ void XmppSession::OnRead(Buffer buffer) {
         return;
     }
 
-    int result = 0;
-    bool more = Match(buffer, &result, true);
-    do {
-        if (more == false) {
-            if (result < 0) {
-                // TODO generate error, close connection.
-                break;
+    const uint8_t *data = BufferData(buffer);
+    size_t size = BufferSize(buffer);
+    while (size > 0) {
+        if (!framer_.started()) {
+            xmsm::XmState state = connection_->GetStateMcState();
+            if (state == xmsm::OPENCONFIRM || state == xmsm::ESTABLISHED) {
+                framer_.Start(XmppStanzaFramer::STANZA);
+            } else {
+                framer_.Start(XmppStanzaFramer::STREAM_HEADER);
             }
-            // We got good match. Process the message
-            std::string::const_iterator st = buf_.begin();
-            std::string xml = string(st, offset_);
-
-            //
-            // XXX Connection gone ?
-            //
-            if (!connection_) break;
-            connection_->ReceiveMsg(this, xml);
-
-        } else {
-            // Read more data. Either we have partial match
-            // or no match but in this state we need to keep
-            // reading data.
-            break;
         }
 
-        if (LeftOver()) {
-            std::string::const_iterator st = buf_.end();
-            ReplaceBuf(string(offset_, st));
-            more = Match(buffer, &result, false);
-        } else {
-            // No more data in the Buffer
-            buf_.clear();
+        bool complete;
+        size_t length = framer_.Scan(data, size, &complete);
+        buf_.append(reinterpret_cast<const char *>(data), length);
+        data += length;
+        size -= length;
+        if (!complete) {
+            // Read more data to complete the stanza
             break;
         }
-    } while (true);
+
+        //
+        // XXX Connection gone ?
+        //
+        if (!connection_) break;
+        connection_->ReceiveMsg(this, buf_);
+        buf_.clear();
+    }
 
     ReleaseBuffer(buffer);
     return;
@@ -6,14 +6,64 @@
 #define __XMPP_SESSION_H__
 
 #include <string>
-#include <boost/regex.hpp>
 #include "io/tcp_server.h"
 #include "io/tcp_session.h"
 
 class XmppStream;
 class XmppServer;
 class XmppConnection;
-class XmppRegexMock;
+
+// Finds the end of the next stanza in the byte stream received from a peer.
+//
+// The scan is incremental: a stanza may span any number of receive buffers,
+// and the framer keeps its matching state across calls so every byte is
+// looked at once. Before the stream is open, a stanza runs up to the end of
+// the <stream:stream> header. Afterwards it runs from the start of the data
+// up to the closing tag of the first <iq> or <message> element. A run of
+// whitespace at the start of a stanza is a stanza by itself (keepalive).
+class XmppStanzaFramer {
+public:
+    enum Mode {
+        STREAM_HEADER,
+        STANZA
+    };
+
+    XmppStanzaFramer();
+
+    // Start scanning for a new stanza of the given kind.
+    void Start(Mode mode);
+    bool started() const { return phase_ != IDLE; }
+
+    // Scans data for the end of the current stanza and returns the number of
+    // bytes that belong to it. Sets complete if the stanza ends there, in
+    // which case the framer must be started again for the next one.
+    size_t Scan(const uint8_t *data, size_t size, bool *complete);
+
+private:
+    struct Tag;
+    static const size_t kMaxTags = 2;
+    static const Tag kStreamTags[];
+    static const Tag kStanzaTags[];
+
+    enum Phase {
+        IDLE,
+        BEGIN,
+        WHITESPACE,
+        OPEN,
+        CLOSE,
+        CLOSE_QUOTE,
+        CLOSE_END
+    };
+
+    Phase phase_;
+    const Tag *tags_;
+    size_t tag_count_;
+    size_t open_pos_[kMaxTags];
+    const Tag *tag_;
+    size_t close_pos_;
+
+    DISALLOW_COPY_AND_ASSIGN(XmppStanzaFramer);
+};
 
 class XmppSession : public TcpSession {
 public:
@@ -34,8 +84,7 @@ public:
     void IncStats(unsigned int message_type, uint64_t bytes);
 
     static const int kMaxMessageSize = 4096;
-    friend class XmppRegexMock;
-   
+
 protected:
     std::string jid;
     virtual void OnRead(Buffer buffer);
@@ -43,28 +92,14 @@ protected:
 private:
     typedef std::deque<Buffer> BufferQueue;
 
-    boost::regex tag_to_pattern(const char *); 
-    int MatchRegex(const boost::regex &patt);
-    bool Match(Buffer buffer, int *result, bool NewBuf);
-    void SetBuf(const std::string &);
-    void ReplaceBuf(const std::string &);
-    bool LeftOver() const;
-
     XmppConnection *connection_;
     BufferQueue queue_;
     XmppStream *stream_;
-    std::string begin_tag_;
+    XmppStanzaFramer framer_;
+    // Stanza being assembled, reused across stanzas
     std::string buf_;
-    std::string::const_iterator offset_;
-    int tag_known_;
-    boost::match_results<std::string::const_iterator> res_;
     std::vector<StatsPair> stats_; // packet count
 
-    static const boost::regex patt_;
-    static const boost::regex stream_patt_;
-    static const boost::regex stream_res_end_;
-    static const boost::regex whitespace_;
-
     DISALLOW_COPY_AND_ASSIGN(XmppSession);
 };
 
@@ -19,6 +19,10 @@
 #define sXMPP_IQ                    "<iq"
 #define sXMPP_MESSAGE_KEY           "message"
 #define sXMPP_MESSAGE               "<message"
+#define sXMPP_IQ_C                  "</iq"
+#define sXMPP_MESSAGE_C             "</message"
+#define sXMPP_STREAM_START          "<stream:stream"
+#define sXMPP_STREAM_NS_URI         "http://etherx.jabber.org/streams"
 
 #define sXMPP_VERSION_1_GLOBAL      "<?xml version='1.0'?>"
 #define sXMPP_VERSION_1             "version='1.0'"